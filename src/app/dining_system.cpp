@@ -1,4 +1,5 @@
 #include "dining_system.h"
+#include "system_tasks.h"
 #include "../modules/rfid_module.h"
 #include "../modules/oled_display.h"
 #include "../modules/keyboard_module.h"
@@ -6,21 +7,56 @@
 #include "../modules/esp_cam_module.h"
 #include "../services/api_client.h"
 #include "../services/fraud_detection.h"
+#include "../services/fraud_window.h"
+#include "../services/student_profile.h"
+#include "../services/peer_sync.h"
+#include "../services/hub_service.h"
 #include "../services/wifi_manager.h"
 #include "../services/offline_service.h"
+#include "../services/local_verification.h"
+#include "../services/frame_quality.h"
+#include "../services/capture_tuning.h"
+#include "../services/commit_pipeline.h"
 #include "../storage/transaction_cache.h"
+#include "../storage/offline_queue.h"
 #include "../ui/manager_approval.h"
 #include "../power_management.h"
 #include "../utils/logger.h"
 #include "../utils/helpers.h"
 #include "../utils/error_handler.h"
+#include "../utils/trace.h"
+#include "../utils/clock.h"
+#include "../services/status_server.h"
 #include <vector>
 
+#define FACE_CAPTURE_TIMEOUT_MS 5000
+#define WAITING_TIMEOUT_MS 30000
+#define ERROR_RESET_MS 10000
+#define PERIODIC_MS 30000
+#define RESULT_SHOW_MS 2000
+#define ERROR_SHOW_MS 3000
+#define VERIFY_RETRY_MS 50
+#define LOG_SHOW_MS 2000 // Old TRANSACTION_LOG pause, --blocking-results only
+
 DiningSystem::DiningSystem() {
   current_state = IDLE;
   current_rfid_uid = "";
   current_face_image = "";
-  last_state_change = millis();
+  has_face_descriptor = false;
+  last_state_change = clock_millis();
+  display_hold_until = 0;
+  pending_card_uid = "";
+  pending_key = -1;
+  motion_seen = false;
+  camera_pending = false;
+  verify_pending = false;
+  verify_retry = false;
+  precapture_on = false;
+  last_periodic = 0;
+  serve_start_us = 0;
+  blocking_results = false;
+  throughput_count = 0;
+  throughput_next = 0;
 }
 
 void DiningSystem::init(SystemConfig config) {
@@ -44,10 +80,31 @@ void DiningSystem::init(SystemConfig config) {
   if (!esp_cam_init()) {
     Logger::logError("Failed to initialize ESP-CAM");
   }
+  esp_cam_set_quick_ae(config.camera_quick_ae);
   
   if (!cache_init()) {
     Logger::logError("Failed to initialize transaction cache");
   }
+  if (!offline_queue_init()) {
+    Logger::logError("Failed to open the offline queue");
+  }
+  fraud_window_init();
+  if (!profile_init()) {
+    Logger::logError("Failed to initialize student profiles");
+  }
+  fraud_set_thresholds({config.fraud_deny_confidence, config.fraud_approval_confidence,
+                        config.fraud_min_meal_cost, config.fraud_serve_window_sec,
+                        config.fraud_deny_window_sec, config.fraud_max_denials,
+                        config.fraud_anomaly_warning_score, config.fraud_anomaly_alert_score});
+  
+  if (!local_verify_init()) {
+    Logger::logError("Failed to initialize local verification");
+  }
+  local_verify_derive_thresholds(system_config);
+  
+  if (!commit_pipeline_init()) {
+    Logger::logError("Failed to start commit pipeline");
+  }
   
   power_init();
   
@@ -57,36 +114,65 @@ void DiningSystem::init(SystemConfig config) {
     String base_url = "http://" + config.server_ip + ":" + String(config.server_port);
     api_init(base_url);
     api_set_server(config.server_ip, config.server_port);
+    api_set_device_id(config.device_id);
+    status_server_begin(STATUS_SERVER_PORT);
+    if (config.peer_sync_enabled) {
+      peer_sync_init(config.device_id, config.peer_group, config.peer_port);
+    }
+    if (config.hub_mode) {
+      hub_begin(status_server_get());
+    } else if (config.hub_ip.length() > 0) {
+      api_set_hub(config.hub_ip, config.hub_port);
+    }
   }
   
-  // Callbacks will be handled in update() method
-  
   display_status("System Ready", "0.00", false);
+  
+  // Peripherals are owned by their tasks from here on
+  if (!system_tasks_start()) {
+    Logger::logError("Failed to start system tasks");
+  }
+  
   Logger::logInfo("System initialized successfully");
 }
 
 void DiningSystem::update() {
-  // Continuous monitoring
-  wifi_check_connection();
-  keyboard_scan();
-  bool motion = motion_detected();
+  task_load_begin(TASK_APP);
   
-  // Handle motion callback manually
-  if (motion && current_state == IDLE && !is_sleep_mode()) {
-    transition_to(WAITING_FOR_CARD);
+  // Card taps, keys, motion, WiFi changes and task completions
+  Event event;
+  while (event_poll(event)) {
+    handle_event(event);
   }
   
-  // Check power management
+  // Check power management; the camera and input tasks follow the change
+  bool was_sleeping = is_sleep_mode();
   power_check_sleep(system_config.motion_timeout_sec * 1000);
+  if (is_sleep_mode() != was_sleeping) {
+    system_tasks_notify_power();
+  }
   
   // Periodic tasks (every 30 seconds)
-  static unsigned long last_periodic = 0;
-  if (millis() - last_periodic > 30000) {
-    last_periodic = millis();
-    sync_offline_transactions();
+  if (clock_millis() - last_periodic >= PERIODIC_MS) {
+    last_periodic = clock_millis();
+    commit_pipeline_sync_offline();
+    commit_pipeline_log_stats();
+    offline_queue_log_stats();
+    local_verify_log_stats();
+    fraud_log_stats();
+    peer_sync_log_stats();
+    hub_log_stats();
+    frame_quality_log_stats();
+    esp_cam_log_burst_stats();
+    system_tasks_log_stats();
+    trace_log_summary();
+    if (throughput_count > 1) {
+      Logger::logInfo("Throughput: " + String(get_students_per_minute(), 1) + " students/min");
+    }
   }
   
   // Update state machine
+  SystemState state_before = current_state;
   switch (current_state) {
     case IDLE:
       state_idle();
@@ -117,111 +203,244 @@ void DiningSystem::update() {
   // Update display with status
   update_display_with_status();
   
-  delay(50); // 20Hz
+  task_load_end(TASK_APP);
+  
+  // A new state runs its entry work on the next pass without waiting.
+  // Otherwise sleep until an event is posted or the nearest deadline.
+  if (current_state == state_before) {
+    event_bus_wait(next_wait_ms());
+  }
+}
+
+void DiningSystem::handle_event(const Event& event) {
+  switch (event.type) {
+    case EVENT_MOTION:
+      motion_seen = true;
+      break;
+    case EVENT_CARD:
+      // Taps outside WAITING_FOR_CARD are ignored, as before
+      if (current_state == WAITING_FOR_CARD) {
+        pending_card_uid = event.data;
+      }
+      break;
+    case EVENT_KEY:
+      handle_keyboard_input(event.value);
+      break;
+    case EVENT_WIFI:
+      // Flush the offline queue as soon as the link is back
+      if (event.value) {
+        commit_pipeline_sync_offline();
+      }
+      break;
+    default:
+      // Camera and verify results are picked up by their states
+      break;
+  }
 }
 
 void DiningSystem::state_idle() {
-  // Motion handling is done in update()
+  // The motion event only marks the edge; presence that outlasts a
+  // WAITING_FOR_CARD timeout keeps the terminal awake
+  if ((motion_seen || motion_active()) && !is_sleep_mode()) {
+    transition_to(WAITING_FOR_CARD);
+  }
 }
 
 void DiningSystem::state_waiting_for_card() {
-  display_waiting("Scan Card");
+  // The previous student's result stays up while the next card is accepted
+  if (!display_held()) {
+    display_waiting("Scan Card");
+  }
   
-  if (rfid_detect_card()) {
-    current_rfid_uid = rfid_read_uid();
-    if (current_rfid_uid.length() > 0) {
-      Logger::logInfo("RFID: Card detected - " + current_rfid_uid);
-      transition_to(CAPTURING_FACE);
-    }
+  // The camera task keeps the freshest sharp frame ready meanwhile
+  if (pending_card_uid.length() > 0) {
+    current_rfid_uid = pending_card_uid;
+    pending_card_uid = "";
+    serve_start_us = trace_begin();
+    Logger::logInfo("RFID: Card detected - " + current_rfid_uid);
+    display_hold_until = 0; // New student, drop the previous result screen
+    transition_to(CAPTURING_FACE);
+    return;
   }
   
   // Timeout after 30 seconds
-  if (millis() - last_state_change > 30000) {
+  if (clock_millis() - last_state_change > WAITING_TIMEOUT_MS) {
     transition_to(IDLE);
   }
 }
 
 void DiningSystem::state_capturing_face() {
-  display_waiting("Capturing Face");
-  
-  if (esp_cam_capture_frame()) {
-    current_face_image = esp_cam_get_base64_jpeg();
-    if (current_face_image.length() > 0) {
-      Logger::logInfo("Camera: Face captured");
-      esp_cam_cleanup();
-      transition_to(VERIFYING);
-    } else {
-      Logger::logError("Camera: Failed to encode image");
-      display_error("Face capture failed");
-      delay(2000);
-      transition_to(WAITING_FOR_CARD);
-    }
-  } else {
+  // Capture, quality gate, descriptor and crop run on the camera task
+  if (!camera_pending) {
+    display_waiting("Capturing Face");
+    camera_pending = system_tasks_request_camera(CAMERA_CAPTURE, system_config.camera_burst_size);
+    return;
+  }
+  
+  CameraResult result;
+  if (!system_tasks_poll_camera(result)) {
+    return;
+  }
+  camera_pending = false;
+  
+  if (!result.captured) {
     Logger::logError("Camera: Capture failed");
     display_error("Camera error");
-    delay(2000);
+    hold_display(RESULT_SHOW_MS);
+    transition_to(WAITING_FOR_CARD);
+    return;
+  }
+  
+  if (result.verdict != FRAME_OK) {
+    Logger::logInfo("Camera: Frame rejected - " + frame_quality_verdict_string(result.verdict));
+    if (clock_millis() - last_state_change < FACE_CAPTURE_TIMEOUT_MS) {
+      display_waiting(frame_quality_user_hint(result.verdict));
+      return; // Re-capture on the next update
+    }
+    handle_error(ERR_FACE_CAPTURE_FAIL, "No usable frame - " + frame_quality_verdict_string(result.verdict));
+    hold_display(RESULT_SHOW_MS);
+    transition_to(WAITING_FOR_CARD);
+    return;
+  }
+  
+  has_face_descriptor = result.has_descriptor;
+  current_face_descriptor = result.descriptor;
+  current_face_image = result.image_base64;
+  if (current_face_image.length() > 0) {
+    Logger::logInfo("Camera: Face captured");
+    transition_to(VERIFYING);
+  } else {
+    Logger::logError("Camera: Failed to encode image");
+    display_error("Face capture failed");
+    hold_display(RESULT_SHOW_MS);
     transition_to(WAITING_FOR_CARD);
   }
 }
 
 void DiningSystem::state_verifying() {
-  display_waiting("Verifying");
-  
-  // Call API to verify face + RFID
-  FaceVerificationResult fvr;
-  
-  if (api_is_connected()) {
-    String response = api_face_verify(current_rfid_uid, current_face_image);
-    if (response.length() > 0) {
-      fvr = FaceVerificationResult::fromJson(response);
-    } else {
-      handle_error(ERR_API_TIMEOUT, "Face verification timeout");
-      // Fall back to offline mode
-      if (is_offline_mode()) {
-        current_fraud_result = check_offline_eligibility("");
-        current_fraud_result.requires_approval = true;
-        transition_to(DECISION);
+  if (!verify_pending) {
+    display_waiting("Verifying");
+    
+    // Stage 1: match against the cached template for this card
+    if (has_face_descriptor && !verify_retry) {
+      uint32_t match_start = trace_begin();
+      LocalMatchResult local = local_verify_match(current_rfid_uid, current_face_descriptor,
+                                                  system_config.local_approve_similarity,
+                                                  system_config.local_reject_similarity);
+      trace_end(TRACE_LOCAL_MATCH, match_start);
+      if (local.outcome == LOCAL_APPROVE || local.outcome == LOCAL_REJECT) {
+        Logger::logInfo("Verification: Decided locally, server skipped");
+        apply_verification_result(local.fvr);
         return;
       }
-      transition_to(WAITING_FOR_CARD);
+    }
+    
+    if (!api_is_connected()) {
+      // Offline mode
+      Logger::logInfo("Offline mode: Limited verification");
+      is_offline_mode();
+      current_fraud_result = check_offline_eligibility("");
+      current_fraud_result.requires_approval = true;
+      // Create minimal verification result for offline
+      FaceVerificationResult fvr;
+      fvr.success = true;
+      fvr.student_id = "";
+      fvr.student_name = "Unknown (Offline)";
+      fvr.confidence = 0.0;
+      fvr.eligible = true;
+      fvr.balance = 0.0;
+      fvr.meal_plan = "unknown";
+      fvr.already_served = false;
+      fvr.needs_approval = true;
+      fvr.reason = "Offline mode - Manager approval required";
+      current_verification_result = fvr;
+      transition_to(DECISION);
       return;
     }
-  } else {
-    // Offline mode
-    Logger::logInfo("Offline mode: Limited verification");
-    is_offline_mode();
-    current_fraud_result = check_offline_eligibility("");
-    current_fraud_result.requires_approval = true;
-    // Create minimal verification result for offline
-    fvr.success = true;
-    fvr.student_id = "";
-    fvr.student_name = "Unknown (Offline)";
-    fvr.confidence = 0.0;
-    fvr.eligible = true;
-    fvr.balance = 0.0;
-    fvr.meal_plan = "unknown";
-    fvr.already_served = false;
-    fvr.needs_approval = true;
-    fvr.reason = "Offline mode - Manager approval required";
+    
+    // Stage 2: the network task verifies face + RFID with the server
+    verify_pending = system_tasks_request_verify(current_rfid_uid, current_face_image);
+    verify_retry = !verify_pending;
+    if (verify_pending) {
+      return;
+    }
+    // The network task has not taken the previous request yet; only a
+    // queue that stays full for the capture timeout counts as a timeout
+    if (clock_millis() - last_state_change < FACE_CAPTURE_TIMEOUT_MS) {
+      return;
+    }
+    verify_retry = false;
+    Logger::logError("Verification: Request queue full");
+  }
+  
+  VerifyResult result;
+  if (verify_pending && !system_tasks_poll_verify(result)) {
+    return;
+  }
+  verify_pending = false;
+  
+  FaceVerificationResult fvr;
+  if (result.from_hub) {
+    // Known card but no face match: offline rules, plus the hub's view of
+    // who has eaten, and always a manager's approval
+    capture_tuning_observe_timeout();
+    fvr = FaceVerificationResult::fromJson(result.response);
+    Logger::logInfo("Verification: Server unreachable, " + fvr.student_name + " from hub roster");
     current_verification_result = fvr;
+    current_fraud_result = check_offline_eligibility(fvr.student_id);
+    if (fvr.already_served) {
+      current_fraud_result.passes_all_rules = false;
+      current_fraud_result.alert_reason = "Already served today (hub)";
+      current_fraud_result.severity = 2;
+    }
+    current_fraud_result.requires_approval = true;
     transition_to(DECISION);
     return;
   }
+  if (result.response.length() > 0) {
+    fvr = FaceVerificationResult::fromJson(result.response);
+    capture_tuning_observe(result.request_bytes, result.request_ms,
+                           fvr.confidence, system_config.min_face_confidence);
+  } else {
+    capture_tuning_observe_timeout();
+    handle_error(ERR_API_TIMEOUT, "Face verification timeout");
+    // Fall back to offline mode
+    if (is_offline_mode()) {
+      current_fraud_result = check_offline_eligibility("");
+      current_fraud_result.requires_approval = true;
+      transition_to(DECISION);
+      return;
+    }
+    hold_display(ERROR_SHOW_MS);
+    transition_to(WAITING_FOR_CARD);
+    return;
+  }
+  
+  // Learn this face for the local fast path next time
+  if (fvr.success && has_face_descriptor && fvr.confidence >= system_config.min_face_confidence) {
+    local_verify_enroll(current_rfid_uid, current_face_descriptor, fvr);
+  }
   
+  apply_verification_result(fvr);
+}
+
+void DiningSystem::apply_verification_result(FaceVerificationResult fvr) {
   if (fvr.success) {
     current_verification_result = fvr;
     Logger::logInfo("Verification: Success - " + fvr.student_name);
     
-    // Check fraud rules
-    std::vector<Transaction> recent_txns = cache_get_recent_transactions(6);
-    current_fraud_result = check_all_fraud_rules(current_rfid_uid, fvr, recent_txns);
+    // Check fraud rules against the per-student windows, which already
+    // include transactions still in the commit pipeline
+    uint32_t fraud_start = trace_begin();
+    current_fraud_result = check_all_fraud_rules(current_rfid_uid, fvr);
+    trace_end(TRACE_FRAUD, fraud_start);
     
     transition_to(DECISION);
   } else {
     Logger::logError("Verification: Failed - " + fvr.reason);
     handle_error(ERR_FACE_RECOGNITION_FAIL, fvr.reason);
     display_error("Verification failed: " + fvr.reason);
-    delay(3000);
+    hold_display(ERROR_SHOW_MS);
     transition_to(WAITING_FOR_CARD);
   }
 }
@@ -233,13 +452,20 @@ void DiningSystem::state_decision() {
     Logger::logError("Decision: DENIED - " + current_fraud_result.alert_reason);
     create_transaction("denied", current_fraud_result.alert_reason);
     display_error(current_fraud_result.alert_reason);
-    delay(3000);
+    hold_display(ERROR_SHOW_MS);
     transition_to(TRANSACTION_LOG);
     return;
   }
   
   // Check if approval required
   if (current_fraud_result.requires_approval || current_verification_result.needs_approval) {
+    String reason = current_fraud_result.alert_reason.length() > 0 ? 
+                    current_fraud_result.alert_reason : 
+                    current_verification_result.reason;
+    manager_approval_begin(current_verification_result.student_name,
+                           current_verification_result.student_id,
+                           reason,
+                           60);
     transition_to(MANAGER_APPROVAL_WAIT);
     return;
   }
@@ -248,62 +474,64 @@ void DiningSystem::state_decision() {
   Logger::logInfo("Decision: AUTO-APPROVED");
   create_transaction("approved", "Auto-approved - matched credentials");
   display_status("APPROVED", String(current_verification_result.balance, 2), true);
-  delay(2000);
+  hold_display(RESULT_SHOW_MS);
   transition_to(TRANSACTION_LOG);
 }
 
 void DiningSystem::state_manager_approval_wait() {
-  String reason = current_fraud_result.alert_reason.length() > 0 ? 
-                  current_fraud_result.alert_reason : 
-                  current_verification_result.reason;
-  
-  ApprovalDecision decision = wait_manager_approval(
-    current_verification_result.student_name,
-    current_verification_result.student_id,
-    reason,
-    60
-  );
+  ApprovalDecision decision = manager_approval_poll(pending_key);
+  pending_key = -1;
+  if (decision == PENDING) {
+    return;
+  }
   
   if (decision == APPROVED) {
     Logger::logInfo("Manager: APPROVED");
     create_transaction("manual_approved", "Manager approved");
     display_status("APPROVED", String(current_verification_result.balance, 2), true);
-    delay(2000);
+    hold_display(RESULT_SHOW_MS);
   } else if (decision == OVERRIDE) {
     Logger::logInfo("Manager: OVERRIDE");
     create_transaction("override", "Manager override");
     display_status("OVERRIDE", String(current_verification_result.balance, 2), true);
-    delay(2000);
+    hold_display(RESULT_SHOW_MS);
   } else {
     Logger::logInfo("Manager: DENIED");
     handle_error(ERR_MANAGER_DENIED, "Manager denied transaction");
     create_transaction("denied", "Manager denied");
     display_error("Contact Manager");
-    delay(3000);
+    hold_display(ERROR_SHOW_MS);
   }
   
   transition_to(TRANSACTION_LOG);
 }
 
 void DiningSystem::state_transaction_log() {
-  // Log transaction to cache and API
+  // Hand the transaction to the commit worker; cache write and server log
+  // overlap with the next student's scan
   if (current_transaction.student_id.length() > 0) {
-    cache_add_transaction(current_transaction);
+    if (!commit_pipeline_submit(current_transaction)) {
+      // Pipeline full: hold the next student until a slot frees up
+      return;
+    }
     
-    if (api_is_connected()) {
-      if (api_log_transaction(current_transaction)) {
-        current_transaction.synced = true;
-        cache_mark_synced(current_transaction.id);
-      }
-    } else {
-      // Queue for offline sync
-      queue_offline_transaction(current_transaction);
+    if (current_transaction.status != "denied") {
+      local_verify_update_balance(current_rfid_uid, current_transaction.balance_after);
     }
+    trace_end(TRACE_SERVE, serve_start_us);
+  }
+  
+  record_throughput();
+  
+  if (blocking_results) {
+    // As before: pause on the log, then wait for motion again in IDLE
+    delay(LOG_SHOW_MS);
+    transition_to(IDLE);
+    return;
   }
   
-  // Wait a bit then return to idle
-  delay(2000);
-  transition_to(IDLE);
+  // Ready for the next card while the result is still on screen
+  transition_to(WAITING_FOR_CARD);
 }
 
 void DiningSystem::state_error() {
@@ -318,7 +546,7 @@ void DiningSystem::state_error() {
   }
   
   // Reset on motion or after 10 seconds
-  if (motion_detected() || (millis() - last_state_change > 10000)) {
+  if (motion_seen || (clock_millis() - last_state_change > ERROR_RESET_MS)) {
     error_displayed = false;
     transition_to(IDLE);
   }
@@ -327,29 +555,42 @@ void DiningSystem::state_error() {
 void DiningSystem::transition_to(SystemState next_state) {
   String from = Helpers::getStateName(current_state);
   String to = Helpers::getStateName(next_state);
-  Logger::logStateTransition(from, to);
+  Logger::logStateTransition(from, to, clock_millis() - last_state_change);
   
   current_state = next_state;
-  last_state_change = millis();
+  last_state_change = clock_millis();
+  
+  // Pre-capture runs from motion detect until the card is read
+  bool want_precapture = next_state == WAITING_FOR_CARD;
+  system_tasks_set_card_scan(want_precapture);
+  if (want_precapture != precapture_on &&
+      system_tasks_request_camera(want_precapture ? CAMERA_PRECAPTURE_ON : CAMERA_PRECAPTURE_OFF, 0)) {
+    precapture_on = want_precapture;
+  }
+  motion_seen = false;
+  pending_key = -1;
+  verify_retry = false;
   
   // Clear state variables on transition
   if (next_state == WAITING_FOR_CARD) {
     current_rfid_uid = "";
     current_face_image = "";
+    has_face_descriptor = false;
   }
 }
 
 void DiningSystem::handle_keyboard_input(int key) {
   // Handle keyboard input during manager approval
   if (current_state == MANAGER_APPROVAL_WAIT) {
-    // Keyboard handling is done in wait_manager_approval
+    // Consumed by manager_approval_poll on this pass
+    pending_key = key;
     return;
   }
 }
 
 void DiningSystem::create_transaction(String status, String reason) {
   Transaction t;
-  t.id = "TXN_" + String(millis()) + "_" + String(random(1000, 9999));
+  t.id = "TXN_" + String(clock_millis()) + "_" + String(random(1000, 9999));
   t.timestamp = Helpers::getCurrentTimestamp();
   t.student_id = current_verification_result.student_id;
   t.student_name = current_verification_result.student_name;
@@ -369,12 +610,98 @@ void DiningSystem::create_transaction(String status, String reason) {
 void DiningSystem::update_display_with_status() {
   // Show WiFi status in corner if needed
   static unsigned long last_status_update = 0;
-  if (millis() - last_status_update > 5000) {
-    last_status_update = millis();
+  if (clock_millis() - last_status_update > 5000) {
+    last_status_update = clock_millis();
     // Status updates are handled in individual states
   }
 }
 
+void DiningSystem::hold_display(unsigned long ms) {
+  if (blocking_results) {
+    delay(ms);
+    return;
+  }
+  display_hold_until = clock_millis() + ms;
+}
+
+bool DiningSystem::display_held() {
+  return display_hold_until != 0 && (long)(clock_millis() - display_hold_until) < 0;
+}
+
+void DiningSystem::record_throughput() {
+  throughput_times[throughput_next] = clock_millis();
+  throughput_next = (throughput_next + 1) % THROUGHPUT_WINDOW;
+  if (throughput_count < THROUGHPUT_WINDOW) {
+    throughput_count++;
+  }
+}
+
+// Remaining ms until deadline, 0 once it has passed
+static unsigned long ms_until(unsigned long deadline, unsigned long now) {
+  long remaining = (long)(deadline - now);
+  return remaining > 0 ? remaining : 0;
+}
+
+unsigned long DiningSystem::next_wait_ms() {
+  unsigned long now = clock_millis();
+  unsigned long wait = ms_until(last_periodic + PERIODIC_MS, now);
+  
+  // Sleep entry once motion has been absent for the configured timeout
+  if (!is_sleep_mode()) {
+    unsigned long sleep_at = motion_last_time() + system_config.motion_timeout_sec * 1000 + 1;
+    wait = min(wait, ms_until(sleep_at, now));
+  }
+  
+  switch (current_state) {
+    case WAITING_FOR_CARD:
+      wait = min(wait, ms_until(last_state_change + WAITING_TIMEOUT_MS + 1, now));
+      if (display_held()) {
+        wait = min(wait, ms_until(display_hold_until, now)); // "Scan Card" after the result
+      }
+      break;
+    case CAPTURING_FACE:
+      if (!camera_pending) {
+        wait = 0; // Re-capture after a rejected frame
+      }
+      break;
+    case MANAGER_APPROVAL_WAIT:
+      wait = min(wait, ms_until(manager_approval_next_deadline(), now));
+      break;
+    case VERIFYING:
+      if (verify_retry) { // Otherwise waits for EVENT_VERIFY_RESULT
+        wait = min(wait, (unsigned long)VERIFY_RETRY_MS);
+      }
+      break;
+    case ERROR_STATE:
+      wait = min(wait, ms_until(last_state_change + ERROR_RESET_MS + 1, now));
+      break;
+    default:
+      // IDLE waits for EVENT_MOTION, TRANSACTION_LOG for EVENT_COMMITTED
+      break;
+  }
+  
+  return wait;
+}
+
+float DiningSystem::get_students_per_minute() {
+  if (throughput_count < 2) {
+    return 0.0;
+  }
+  
+  // Rate over the last THROUGHPUT_WINDOW completed transactions
+  int newest = (throughput_next + THROUGHPUT_WINDOW - 1) % THROUGHPUT_WINDOW;
+  int oldest = (throughput_next + THROUGHPUT_WINDOW - throughput_count) % THROUGHPUT_WINDOW;
+  unsigned long span = throughput_times[newest] - throughput_times[oldest];
+  if (span == 0) {
+    return 0.0;
+  }
+  return (throughput_count - 1) * 60000.0 / span;
+}
+
+void DiningSystem::set_blocking_results(bool enabled) {
+  blocking_results = enabled;
+}
+
 SystemState DiningSystem::get_state() {
   return current_state;
 }
@@ -3,6 +3,10 @@
 
 #include <Arduino.h>
 #include "../config/data_types.h"
+#include "../utils/image_utils.h"
+#include "../utils/event_bus.h"
+
+#define THROUGHPUT_WINDOW 10
 
 class DiningSystem {
 private:
@@ -10,10 +14,26 @@ private:
   SystemConfig system_config;
   String current_rfid_uid;
   String current_face_image;
+  FaceDescriptor current_face_descriptor;
+  bool has_face_descriptor;
   FaceVerificationResult current_verification_result;
   FraudCheckResult current_fraud_result;
   Transaction current_transaction;
   unsigned long last_state_change;
+  unsigned long display_hold_until; // Result screen stays up until this time
+  String pending_card_uid;   // Latest tap from the event bus
+  int pending_key;           // Latest key from the event bus, -1 for none
+  bool motion_seen;
+  bool camera_pending;       // Capture requested from the camera task
+  bool verify_pending;       // Face-verify requested from the network task
+  bool verify_retry;         // Request queue was full, submit again shortly
+  bool precapture_on;
+  unsigned long last_periodic;
+  uint32_t serve_start_us;   // Card accepted, for the end-to-end trace
+  bool blocking_results;     // Result screens block like the old delay() calls
+  unsigned long throughput_times[THROUGHPUT_WINDOW];
+  int throughput_count;
+  int throughput_next;
   
   void state_idle();
   void state_waiting_for_card();
@@ -23,16 +43,27 @@ private:
   void state_manager_approval_wait();
   void state_transaction_log();
   void state_error();
+  void apply_verification_result(FaceVerificationResult fvr);
   void transition_to(SystemState next_state);
+  void handle_event(const Event& event);
   void handle_keyboard_input(int key);
   void create_transaction(String status, String reason);
   void update_display_with_status();
+  void hold_display(unsigned long ms);
+  bool display_held();
+  void record_throughput();
+  unsigned long next_wait_ms();
   
 public:
   DiningSystem();
   void init(SystemConfig config);
   void update();
   SystemState get_state();
+  float get_students_per_minute();
+  // Sim baseline for the throughput comparison: hold each result screen
+  // and the transaction log with delay() and return through IDLE, as the
+  // state machine used to
+  void set_blocking_results(bool enabled);
 };
 
 #endif
@@ -0,0 +1,427 @@
+#include "system_tasks.h"
+#include "../modules/rfid_module.h"
+#include "../modules/keyboard_module.h"
+#include "../modules/motion_sensor.h"
+#include "../modules/oled_display.h"
+#include "../modules/esp_cam_module.h"
+#include "../services/api_client.h"
+#include "../services/wifi_manager.h"
+#include "../services/capture_tuning.h"
+#include "../services/commit_pipeline.h"
+#include "../services/peer_sync.h"
+#include "../services/hub_service.h"
+#include "../power_management.h"
+#include "../utils/spsc_queue.h"
+#include "../utils/event_bus.h"
+#include "../utils/trace.h"
+#include "../utils/logger.h"
+
+#define INPUT_POLL_MS 10          // Keypad and RFID have no interrupt lines
+#define INPUT_SLEEP_POLL_MS 250   // PIR interrupt wakes the task in between
+#define CAMERA_PRECAPTURE_POLL_MS 25
+#define NETWORK_HEALTH_MS 1000
+#define LOAD_WINDOW_US 1000000
+
+struct TaskSpec {
+  const char* name;
+  TaskFunction_t entry;
+  uint32_t stack;
+  UBaseType_t priority;
+  BaseType_t core;
+};
+
+struct TaskLoad {
+  unsigned long busy_us;
+  unsigned long window_start_us;
+  unsigned long begin_us;
+  float cpu_percent;
+};
+
+struct VerifyRequest {
+  String rfid_uid;
+  String face_base64;
+};
+
+static void input_task(void* arg);
+static void camera_task(void* arg);
+static void network_task(void* arg);
+static void storage_task(void* arg);
+static void ui_task(void* arg);
+
+// The app entry describes the Arduino loop task, which already exists
+const TaskSpec TASK_SPECS[TASK_COUNT] = {
+  {"app",     NULL,          0,    1, 1},
+  {"input",   input_task,    4096, 3, 1},
+  {"camera",  camera_task,   8192, 2, 0},
+  {"network", network_task,  8192, 3, 0},
+  {"storage", storage_task,  8192, 1, 0},
+  {"ui",      ui_task,       4096, 1, 1}
+};
+
+TaskHandle_t task_handles[TASK_COUNT] = {NULL};
+TaskLoad task_loads[TASK_COUNT];
+bool system_tasks_running = false;
+volatile bool card_scan_enabled = false;
+
+// One producer and one consumer per queue
+SpscQueue<CameraRequest, 4> camera_requests; // app     -> camera
+SpscQueue<CameraResult, 2> camera_results;   // camera  -> app
+SpscQueue<VerifyRequest, 2> verify_requests; // app     -> network
+SpscQueue<VerifyResult, 2> verify_results;   // network -> app
+
+// Keypad columns share pins with the OLED I2C bus and the RFID reader
+SemaphoreHandle_t io_bus_mutex = NULL;
+
+void task_load_begin(SystemTaskId id) {
+  task_loads[id].begin_us = micros();
+}
+
+void task_load_end(SystemTaskId id) {
+  TaskLoad& load = task_loads[id];
+  unsigned long now = micros();
+  load.busy_us += now - load.begin_us;
+
+  unsigned long window = now - load.window_start_us;
+  if (window >= LOAD_WINDOW_US) {
+    load.cpu_percent = load.busy_us * 100.0 / window;
+    load.busy_us = 0;
+    load.window_start_us = now;
+  }
+}
+
+// Module callbacks, run on whichever task drives the module
+static void on_key(int key) {
+  event_post(EVENT_KEY, key);
+}
+
+static void on_motion() {
+  event_post(EVENT_MOTION);
+}
+
+static void on_wifi_status(bool connected) {
+  event_post(EVENT_WIFI, connected ? 1 : 0);
+}
+
+static void input_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    task_load_begin(TASK_INPUT);
+
+    // PIR first, its pin doubles as a keypad row. Rising edges reach on_motion.
+    motion_detected();
+
+    // A card presence check with no card waits out the reader's timeout,
+    // so only scan when a tap would be accepted
+    xSemaphoreTake(io_bus_mutex, portMAX_DELAY);
+    keyboard_scan(); // Presses reach on_key
+    String uid = "";
+    uint32_t read_start = trace_begin();
+    if (card_scan_enabled && rfid_detect_card()) {
+      uid = rfid_read_uid();
+    }
+    xSemaphoreGive(io_bus_mutex);
+
+    if (uid.length() > 0) {
+      trace_end(TRACE_RFID_READ, read_start);
+      event_post(EVENT_CARD, 0, uid.c_str());
+    }
+
+    task_load_end(TASK_INPUT);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(is_sleep_mode() ? INPUT_SLEEP_POLL_MS : INPUT_POLL_MS));
+  }
+}
+
+static void camera_capture(int burst_size, CameraResult& result) {
+  result.captured = false;
+  result.verdict = FRAME_OK;
+  result.has_descriptor = false;
+  result.image_base64 = "";
+  uint32_t capture_start = trace_begin();
+
+  // Best pre-captured frame first, live burst once the ring is used up
+  if (!esp_cam_take_precaptured() && !esp_cam_capture_burst(burst_size)) {
+    return;
+  }
+  result.captured = true;
+
+  // Reject dark, blurred or faceless frames locally instead of after a server round trip
+  const LumaImage* luma = esp_cam_get_luma();
+  if (luma != nullptr) {
+    FrameQuality quality = frame_quality_assess(*luma);
+    result.verdict = quality.verdict;
+    if (quality.verdict != FRAME_OK) {
+      esp_cam_cleanup();
+      trace_end(TRACE_CAPTURE, capture_start);
+      return;
+    }
+    result.has_descriptor = image_compute_descriptor(*luma, &quality.face, result.descriptor);
+
+    // Ship only the padded face region; the full frame is the fallback
+    esp_cam_crop_to_face(quality.face);
+  }
+
+  trace_end(TRACE_CAPTURE, capture_start);
+
+  uint32_t encode_start = trace_begin();
+  result.image_base64 = esp_cam_get_base64_jpeg();
+  trace_end(TRACE_ENCODE, encode_start);
+  esp_cam_cleanup();
+}
+
+static void camera_task(void* arg) {
+  (void)arg;
+  bool precapture = false;
+
+  for (;;) {
+    task_load_begin(TASK_CAMERA);
+
+    // The camera follows the power state; it is only ever touched from this task
+    if (is_sleep_mode() && !esp_cam_is_sleeping()) {
+      esp_cam_sleep();
+    } else if (!is_sleep_mode() && esp_cam_is_sleeping()) {
+      esp_cam_wake();
+    }
+
+    // Link-aware profile picked by capture tuning, applied between captures
+    if (capture_tuning_target_profile() != esp_cam_get_profile()) {
+      esp_cam_apply_profile(capture_tuning_target_profile());
+    }
+
+    CameraRequest request;
+    while (camera_requests.pop(request)) {
+      if (request.command == CAMERA_PRECAPTURE_ON) {
+        esp_cam_precapture_start();
+        precapture = true;
+      } else if (request.command == CAMERA_PRECAPTURE_OFF) {
+        esp_cam_precapture_stop();
+        precapture = false;
+      } else {
+        CameraResult result;
+        camera_capture(request.burst_size, result);
+        camera_results.push(result);
+        event_post(EVENT_CAMERA_RESULT);
+      }
+    }
+
+    if (precapture) {
+      esp_cam_precapture_poll();
+    }
+
+    // Requests and power changes notify this task; otherwise it only wakes for pre-capture
+    task_load_end(TASK_CAMERA);
+    ulTaskNotifyTake(pdTRUE, precapture ? pdMS_TO_TICKS(CAMERA_PRECAPTURE_POLL_MS) : portMAX_DELAY);
+  }
+}
+
+static void network_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    task_load_begin(TASK_NETWORK);
+
+    // Reconnects block for seconds, which is why they live here
+    wifi_check_connection();
+
+    VerifyRequest request;
+    while (verify_requests.pop(request)) {
+      VerifyResult result;
+      uint32_t verify_start = trace_begin();
+      result.response = api_face_verify(request.rfid_uid, request.face_base64);
+      trace_end(TRACE_VERIFY_RTT, verify_start);
+      result.from_hub = false;
+      if (result.response.length() == 0) {
+        // The hub, if there is one, still knows whose card it is
+        result.response = api_hub_lookup(request.rfid_uid);
+        result.from_hub = result.response.length() > 0;
+      }
+      result.request_bytes = api_get_last_request_bytes();
+      result.request_ms = api_get_last_request_ms();
+      verify_results.push(result);
+      event_post(EVENT_VERIFY_RESULT);
+    }
+
+    // Peer datagrams have no interrupt to wake the task, so poll faster while joined
+    unsigned long wait_ms = NETWORK_HEALTH_MS;
+    unsigned long peer_ms = peer_sync_service();
+    if (peer_ms > 0 && peer_ms < wait_ms) {
+      wait_ms = peer_ms;
+    }
+    // Hub forwarding blocks on the server, so it lives here too, one chunk
+    // per pass so verify requests are not held behind a backlog
+    unsigned long hub_ms = hub_service();
+    if (hub_ms > 0 && hub_ms < wait_ms) {
+      wait_ms = hub_ms;
+    }
+
+    task_load_end(TASK_NETWORK);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+  }
+}
+
+static void storage_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    task_load_begin(TASK_STORAGE);
+    commit_pipeline_service();
+    task_load_end(TASK_STORAGE);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+static void ui_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    task_load_begin(TASK_UI);
+    xSemaphoreTake(io_bus_mutex, portMAX_DELAY);
+    unsigned long next_frame_ms = oled_service();
+    xSemaphoreGive(io_bus_mutex);
+    task_load_end(TASK_UI);
+
+    // New screens notify this task; only the waiting animation needs a timer
+    ulTaskNotifyTake(pdTRUE, next_frame_ms > 0 ? pdMS_TO_TICKS(next_frame_ms) : portMAX_DELAY);
+  }
+}
+
+bool system_tasks_start() {
+  if (system_tasks_running) {
+    return true;
+  }
+
+  io_bus_mutex = xSemaphoreCreateMutex();
+  if (io_bus_mutex == NULL) {
+    Logger::logError("Tasks: Bus mutex allocation failed");
+    return false;
+  }
+
+  unsigned long now = micros();
+  for (int i = 0; i < TASK_COUNT; i++) {
+    task_loads[i].busy_us = 0;
+    task_loads[i].window_start_us = now;
+    task_loads[i].begin_us = now;
+    task_loads[i].cpu_percent = 0.0;
+  }
+
+  // Caller is the Arduino loop task, which runs the state machine
+  task_handles[TASK_APP] = xTaskGetCurrentTaskHandle();
+  event_bus_set_consumer(task_handles[TASK_APP]);
+
+  keyboard_set_callback(on_key);
+  motion_set_callback(on_motion);
+  wifi_set_status_callback(on_wifi_status);
+
+  for (int i = 0; i < TASK_COUNT; i++) {
+    const TaskSpec& spec = TASK_SPECS[i];
+    if (spec.entry == NULL) {
+      continue;
+    }
+    if (xTaskCreatePinnedToCore(spec.entry, spec.name, spec.stack, NULL,
+                                spec.priority, &task_handles[i], spec.core) != pdPASS) {
+      Logger::logError("Tasks: Failed to start " + String(spec.name));
+      return false;
+    }
+  }
+
+  commit_pipeline_attach(task_handles[TASK_STORAGE]);
+  peer_sync_attach(task_handles[TASK_NETWORK]);
+  hub_attach(task_handles[TASK_NETWORK]);
+  motion_set_wake_task(task_handles[TASK_INPUT]);
+  oled_set_async(task_handles[TASK_UI]);
+
+  system_tasks_running = true;
+  Logger::logInfo("Tasks: Started " + String(TASK_COUNT - 1) + " tasks");
+  return true;
+}
+
+bool system_tasks_request_camera(CameraCommand command, int burst_size) {
+  CameraRequest request;
+  request.command = command;
+  request.burst_size = burst_size;
+  if (!camera_requests.push(request)) {
+    return false;
+  }
+  xTaskNotifyGive(task_handles[TASK_CAMERA]);
+  return true;
+}
+
+bool system_tasks_poll_camera(CameraResult& result) {
+  return camera_results.pop(result);
+}
+
+bool system_tasks_request_verify(String rfid_uid, String face_base64) {
+  VerifyRequest request;
+  request.rfid_uid = rfid_uid;
+  request.face_base64 = face_base64;
+  if (!verify_requests.push(request)) {
+    return false;
+  }
+  xTaskNotifyGive(task_handles[TASK_NETWORK]);
+  return true;
+}
+
+bool system_tasks_poll_verify(VerifyResult& result) {
+  return verify_results.pop(result);
+}
+
+void system_tasks_set_card_scan(bool enabled) {
+  card_scan_enabled = enabled;
+}
+
+void system_tasks_notify_power() {
+  if (!system_tasks_running) {
+    return;
+  }
+  xTaskNotifyGive(task_handles[TASK_CAMERA]);
+  xTaskNotifyGive(task_handles[TASK_INPUT]);
+}
+
+int system_tasks_get_info(TaskInfo* out, int max) {
+  int count = 0;
+  for (int i = 0; i < TASK_COUNT && count < max; i++) {
+    TaskInfo& info = out[count++];
+    info.name = TASK_SPECS[i].name;
+    info.core = TASK_SPECS[i].core;
+    info.priority = TASK_SPECS[i].priority;
+    info.cpu_percent = task_loads[i].cpu_percent;
+    info.stack_free = task_handles[i] != NULL ? uxTaskGetStackHighWaterMark(task_handles[i]) : 0;
+  }
+  return count;
+}
+
+int system_tasks_get_queue_info(QueueInfo* out, int max) {
+  EventBusStats events = event_bus_get_stats();
+  QueueInfo all[] = {
+    {"events", events.depth, events.max_depth, EVENT_BUS_CAPACITY, events.dropped},
+    {"camera_req", camera_requests.size(), camera_requests.max_depth(), camera_requests.capacity(), camera_requests.drops()},
+    {"camera_res", camera_results.size(), camera_results.max_depth(), camera_results.capacity(), camera_results.drops()},
+    {"verify_req", verify_requests.size(), verify_requests.max_depth(), verify_requests.capacity(), verify_requests.drops()},
+    {"verify_res", verify_results.size(), verify_results.max_depth(), verify_results.capacity(), verify_results.drops()},
+    {"display", oled_queue_depth(), oled_queue_max_depth(), OLED_QUEUE_DEPTH, oled_queue_drops()}
+  };
+
+  int count = 0;
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]) && count < max; i++) {
+    out[count++] = all[i];
+  }
+  return count;
+}
+
+void system_tasks_log_stats() {
+  if (!system_tasks_running) {
+    return;
+  }
+
+  TaskInfo tasks[TASK_COUNT];
+  int task_count = system_tasks_get_info(tasks, TASK_COUNT);
+  for (int i = 0; i < task_count; i++) {
+    Logger::logf("[INFO] Task %-8s core %d prio %d: %5.1f%% CPU, %lu B stack free",
+                 tasks[i].name, tasks[i].core, tasks[i].priority,
+                 tasks[i].cpu_percent, tasks[i].stack_free);
+  }
+
+  QueueInfo queues[8];
+  int queue_count = system_tasks_get_queue_info(queues, 8);
+  for (int i = 0; i < queue_count; i++) {
+    Logger::logf("[INFO] Queue %-10s %u/%u (max %u), %lu dropped",
+                 queues[i].name, (unsigned)queues[i].depth, (unsigned)queues[i].capacity,
+                 (unsigned)queues[i].max_depth, queues[i].drops);
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef SYSTEM_TASKS_H
+#define SYSTEM_TASKS_H
+
+#include <Arduino.h>
+#include "../config/data_types.h"
+#include "../services/frame_quality.h"
+#include "../utils/image_utils.h"
+
+// Core 0 runs the network, camera and storage tasks next to the WiFi stack.
+// Core 1 runs input, UI and the state machine (Arduino loop task).
+enum SystemTaskId {
+  TASK_APP,
+  TASK_INPUT,
+  TASK_CAMERA,
+  TASK_NETWORK,
+  TASK_STORAGE,
+  TASK_UI,
+  TASK_COUNT
+};
+
+// State machine -> camera task
+enum CameraCommand {
+  CAMERA_CAPTURE,
+  CAMERA_PRECAPTURE_ON,
+  CAMERA_PRECAPTURE_OFF
+};
+
+struct CameraRequest {
+  CameraCommand command;
+  int burst_size;
+};
+
+// Camera task -> state machine: a gated, cropped and encoded frame
+struct CameraResult {
+  bool captured;        // False when the sensor returned nothing
+  FrameVerdict verdict;
+  bool has_descriptor;
+  FaceDescriptor descriptor;
+  String image_base64;  // Empty unless verdict is FRAME_OK
+};
+
+// Network task -> state machine
+struct VerifyResult {
+  String response;          // Empty on timeout or transport error
+  bool from_hub = false;    // Server unreachable; response is the hub's roster entry
+  size_t request_bytes = 0;
+  unsigned long request_ms = 0;
+};
+
+struct TaskInfo {
+  const char* name;
+  int core;
+  int priority;
+  float cpu_percent;          // Busy time over the last window
+  unsigned long stack_free;   // Bytes never used
+};
+
+struct QueueInfo {
+  const char* name;
+  size_t depth;
+  size_t max_depth;
+  size_t capacity;
+  unsigned long drops;
+};
+
+bool system_tasks_start();
+
+// Input, WiFi and completion events reach the state machine on the event bus.
+// Request/result payloads use one SPSC queue per direction.
+bool system_tasks_request_camera(CameraCommand command, int burst_size);
+bool system_tasks_poll_camera(CameraResult& result);
+bool system_tasks_request_verify(String rfid_uid, String face_base64);
+bool system_tasks_poll_verify(VerifyResult& result);
+
+// RFID polling is only needed while the state machine accepts cards
+void system_tasks_set_card_scan(bool enabled);
+// Wake the tasks that follow the power state after it changed
+void system_tasks_notify_power();
+
+// Busy-time accounting, for tasks whose loop is not created here
+void task_load_begin(SystemTaskId id);
+void task_load_end(SystemTaskId id);
+
+int system_tasks_get_info(TaskInfo* out, int max);
+int system_tasks_get_queue_info(QueueInfo* out, int max);
+void system_tasks_log_stats();
+
+#endif
@@ -0,0 +1,421 @@
+// Host micro-benchmarks for the hot data paths: transaction cache, fraud
+// rules, base64 and JSON. Each case reports ns/op and heap allocations/op.
+//
+//   bench [--filter text] [--csv out.csv] [--compare baseline.csv]
+//
+// Allocations are counted through operator new and, with the linker's
+// --wrap=malloc,realloc,calloc (see [env:native_bench]), through the C
+// allocator ArduinoJson uses. The host String grows geometrically, so
+// append loops allocate less here than with the Arduino String.
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <new>
+#include <vector>
+#include <unistd.h>
+#include "../hal/native/sim_hal.h"
+#include "../config/data_types.h"
+#include "../services/fraud_detection.h"
+#include "../services/fraud_window.h"
+#include "../services/student_profile.h"
+#include "../storage/transaction_cache.h"
+#include "../utils/helpers.h"
+
+#define BENCH_MIN_MS 300      // Measured time per case, excluding paused setup
+#define BENCH_MIN_ITERS 5
+#define BENCH_MAX_ITERS 1000000
+#define BENCH_NOW_MS (12UL * 3600 * 1000)  // Virtual noon; cached records span the morning
+
+static const int RECORD_SIZES[] = {100, 1000, 10000};
+// Face crop JPEG, full VGA JPEG, raw VGA grayscale
+static const size_t FRAME_SIZES[] = {25 * 1024, 60 * 1024, 640 * 480};
+
+// ---- Allocation counting ----
+
+static std::atomic<unsigned long> bench_allocs(0);
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_calloc(size_t count, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  bench_allocs++;
+  return __real_malloc(size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  bench_allocs++;
+  return __real_realloc(ptr, size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  bench_allocs++;
+  return __real_calloc(count, size);
+}
+}
+
+void* operator new(size_t size) {
+  bench_allocs++;
+  void* p = __real_malloc(size > 0 ? size : 1);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+// ---- Harness ----
+
+struct BenchRun {
+  unsigned long iterations;
+  unsigned long allocs;
+  std::chrono::steady_clock::duration elapsed;
+  std::chrono::steady_clock::time_point started;
+  unsigned long allocs_at_start;
+  bool running;
+};
+
+struct BenchResult {
+  String name;
+  unsigned long iterations;
+  double ns_per_op;
+  double allocs_per_op;
+};
+
+// Sink for results the compiler must not drop
+static volatile size_t bench_sink = 0;
+
+static void bench_resume(BenchRun& run) {
+  run.started = std::chrono::steady_clock::now();
+  run.allocs_at_start = bench_allocs;
+  run.running = true;
+}
+
+static void bench_pause(BenchRun& run) {
+  run.elapsed += std::chrono::steady_clock::now() - run.started;
+  run.allocs += bench_allocs - run.allocs_at_start;
+  run.running = false;
+}
+
+// Loop condition: while (bench_next(run)) { ...one op... }. Timing starts
+// on the first call; setup before the loop is not measured.
+static bool bench_next(BenchRun& run) {
+  if (!run.running) {
+    bench_resume(run);
+  }
+  if (run.iterations >= BENCH_MIN_ITERS) {
+    auto elapsed = run.elapsed + (std::chrono::steady_clock::now() - run.started);
+    if (elapsed >= std::chrono::milliseconds(BENCH_MIN_MS) || run.iterations >= BENCH_MAX_ITERS) {
+      bench_pause(run);
+      return false;
+    }
+  }
+  run.iterations++;
+  return true;
+}
+
+typedef void (*BenchFn)(BenchRun& run, int size);
+
+struct BenchCase {
+  const char* name;
+  BenchFn fn;
+  int size;
+};
+
+static BenchResult bench_execute(const BenchCase& c) {
+  BenchRun run = {};
+  c.fn(run, c.size);
+
+  BenchResult result;
+  result.name = String(c.name) + "/" + String(c.size);
+  result.iterations = run.iterations;
+  double ns = std::chrono::duration<double, std::nano>(run.elapsed).count();
+  result.ns_per_op = run.iterations > 0 ? ns / run.iterations : 0;
+  result.allocs_per_op = run.iterations > 0 ? (double)run.allocs / run.iterations : 0;
+  return result;
+}
+
+// ---- Fixtures ----
+
+static Transaction sample_transaction(int i, unsigned long timestamp) {
+  char uid[16];
+  snprintf(uid, sizeof(uid), "%08X", 0xC3000000 + i);
+
+  Transaction t;
+  t.id = "TXN_" + String(timestamp * 1000 + i) + "_" + String(1000 + i % 9000);
+  t.timestamp = timestamp;
+  t.student_id = "STU_" + String(uid);
+  t.student_name = "Student " + String(uid);
+  t.rfid_uid = uid;
+  t.status = i % 17 == 0 ? "denied" : "approved";
+  t.balance_before = 500.0;
+  t.balance_after = 495.0;
+  t.reason = "Auto-approved - matched credentials";
+  t.fraud_alert = false;
+  t.face_confidence = 0.92;
+  t.synced = i % 3 != 0;
+  t.offline_mode = false;
+  return t;
+}
+
+// Records spread over the six hours before BENCH_NOW_MS, oldest first
+static std::vector<Transaction> sample_transactions(int count) {
+  std::vector<Transaction> txns;
+  unsigned long now_sec = BENCH_NOW_MS / 1000;
+  for (int i = 0; i < count; i++) {
+    txns.push_back(sample_transaction(i, now_sec - 6 * 3600 + (unsigned long)i * 6 * 3600 / count));
+  }
+  return txns;
+}
+
+// Cache file as transaction_cache.cpp writes it
+static String cache_image(int count) {
+  JsonDocument doc;
+  JsonArray arr = doc["transactions"].to<JsonArray>();
+  for (const Transaction& tx : sample_transactions(count)) {
+    JsonObject obj = arr.add<JsonObject>();
+    obj["id"] = tx.id;
+    obj["timestamp"] = tx.timestamp;
+    obj["student_id"] = tx.student_id;
+    obj["student_name"] = tx.student_name;
+    obj["rfid_uid"] = tx.rfid_uid;
+    obj["status"] = tx.status;
+    obj["balance_before"] = tx.balance_before;
+    obj["balance_after"] = tx.balance_after;
+    obj["reason"] = tx.reason;
+    obj["fraud_alert"] = tx.fraud_alert;
+    obj["face_confidence"] = tx.face_confidence;
+    obj["synced"] = tx.synced;
+    obj["offline_mode"] = tx.offline_mode;
+  }
+  String image;
+  serializeJson(doc, image);
+  return image;
+}
+
+static void cache_restore(const String& image) {
+  File file = SPIFFS.open(CACHE_FILE, "w");
+  file.print(image);
+  file.close();
+}
+
+static const char* VERIFY_RESPONSE =
+    "{\"status\":\"success\",\"student_id\":\"STU_04A1B2C3\",\"student_name\":\"Student 04A1B2C3\","
+    "\"confidence\":0.92,\"eligible\":true,\"balance\":500.0,\"meal_plan\":\"active\","
+    "\"already_served_today\":false,\"approval_required\":false,\"reason\":\"\"}";
+
+// ---- Cases ----
+
+static void bench_cache_add(BenchRun& run, int size) {
+  String image = cache_image(size);
+  Transaction t = sample_transaction(size, BENCH_NOW_MS / 1000);
+  cache_restore(image);
+  while (bench_next(run)) {
+    bench_sink += cache_add_transaction(t);
+    bench_pause(run);
+    cache_restore(image); // Keep the cache at the nominal size
+    bench_resume(run);
+  }
+}
+
+static void bench_cache_get_recent(BenchRun& run, int size) {
+  cache_restore(cache_image(size));
+  while (bench_next(run)) {
+    bench_sink += cache_get_recent_transactions(6).size();
+  }
+}
+
+static void bench_fraud_rules(BenchRun& run, int size) {
+  // The rules read the per-student windows, filled here as the commit
+  // pipeline would; size is the number of transactions recorded
+  fraud_window_clear();
+  for (const Transaction& t : sample_transactions(size)) {
+    fraud_window_record(t);
+  }
+  FaceVerificationResult fvr = FaceVerificationResult::fromJson(VERIFY_RESPONSE);
+  String uid = "04A1B2C3"; // Not in the window: every rule runs to the end
+  while (bench_next(run)) {
+    bench_sink += check_all_fraud_rules(uid, fvr).severity;
+  }
+}
+
+static void bench_profile_score(BenchRun& run, int size) {
+  // One mature profile: a breakfast regular, scored at an unusual hour
+  (void)size;
+  profile_clear();
+  for (int day = 0; day < 20; day++) {
+    Transaction t = sample_transaction(0, BENCH_NOW_MS / 1000 - (20 - day) * 24 * 3600);
+    profile_update(t);
+  }
+  String student_id = sample_transaction(0, 0).student_id;
+  unsigned long now_sec = BENCH_NOW_MS / 1000 + 5 * 3600;
+  while (bench_next(run)) {
+    bench_sink += profile_score(student_id, 0.80, now_sec).score;
+  }
+}
+
+static void bench_base64(BenchRun& run, int size) {
+  std::vector<uint8_t> frame(size);
+  for (int i = 0; i < size; i++) {
+    frame[i] = (uint8_t)(i * 31 + (i >> 7));
+  }
+  while (bench_next(run)) {
+    bench_sink += Helpers::base64Encode(frame.data(), frame.size()).length();
+  }
+}
+
+static void bench_transaction_to_json(BenchRun& run, int size) {
+  Transaction t = sample_transaction(size, BENCH_NOW_MS / 1000);
+  while (bench_next(run)) {
+    bench_sink += t.toJson().length();
+  }
+}
+
+static void bench_transaction_from_json(BenchRun& run, int size) {
+  String json = sample_transaction(size, BENCH_NOW_MS / 1000).toJson();
+  while (bench_next(run)) {
+    bench_sink += Transaction::fromJson(json).timestamp;
+  }
+}
+
+static void bench_verify_from_json(BenchRun& run, int size) {
+  (void)size;
+  String json = VERIFY_RESPONSE;
+  while (bench_next(run)) {
+    bench_sink += FaceVerificationResult::fromJson(json).success;
+  }
+}
+
+static std::vector<BenchCase> bench_cases() {
+  std::vector<BenchCase> cases;
+  for (int size : RECORD_SIZES) {
+    cases.push_back({"cache_add_transaction", bench_cache_add, size});
+  }
+  for (int size : RECORD_SIZES) {
+    cases.push_back({"cache_get_recent_transactions", bench_cache_get_recent, size});
+  }
+  for (int size : RECORD_SIZES) {
+    cases.push_back({"check_all_fraud_rules", bench_fraud_rules, size});
+  }
+  cases.push_back({"profile_score", bench_profile_score, 1});
+  for (size_t size : FRAME_SIZES) {
+    cases.push_back({"base64Encode", bench_base64, (int)size});
+  }
+  cases.push_back({"Transaction::toJson", bench_transaction_to_json, 1});
+  cases.push_back({"Transaction::fromJson", bench_transaction_from_json, 1});
+  cases.push_back({"FaceVerificationResult::fromJson", bench_verify_from_json, 1});
+  return cases;
+}
+
+// ---- Baselines ----
+
+static std::map<String, double> load_baseline(const char* path) {
+  std::map<String, double> baseline;
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "bench: cannot open %s\n", path);
+    return baseline;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char name[128];
+    unsigned long iterations;
+    double ns;
+    if (sscanf(line, "%127[^,],%lu,%lf", name, &iterations, &ns) == 3) {
+      baseline[String(name)] = ns;
+    }
+  }
+  fclose(f);
+  return baseline;
+}
+
+int main(int argc, char** argv) {
+  const char* filter = NULL;
+  const char* csv_path = NULL;
+  const char* compare_path = NULL;
+  for (int i = 1; i < argc; i++) {
+    String arg(argv[i]);
+    if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (arg == "--csv" && i + 1 < argc) {
+      csv_path = argv[++i];
+    } else if (arg == "--compare" && i + 1 < argc) {
+      compare_path = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--filter text] [--csv out.csv] [--compare baseline.csv]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::map<String, double> baseline;
+  if (compare_path != NULL) {
+    baseline = load_baseline(compare_path);
+  }
+  FILE* csv = NULL;
+  if (csv_path != NULL) {
+    csv = fopen(csv_path, "w");
+    if (csv == NULL) {
+      fprintf(stderr, "bench: cannot write %s\n", csv_path);
+      return 1;
+    }
+    fprintf(csv, "name,iterations,ns_per_op,allocs_per_op\n");
+  }
+
+  sim_serial_set_echo(false);
+  sim_clock_install(BENCH_NOW_MS);
+  cache_init();
+  profile_init();
+
+  printf("%-40s %10s %14s %12s %10s\n", "case", "iters", "ns/op", "allocs/op", "vs base");
+  for (const BenchCase& c : bench_cases()) {
+    String name = String(c.name) + "/" + String(c.size);
+    if (filter != NULL && name.indexOf(filter) < 0) {
+      continue;
+    }
+    BenchResult r = bench_execute(c);
+
+    String delta = "";
+    auto base = baseline.find(r.name);
+    if (base != baseline.end() && base->second > 0) {
+      char text[16];
+      snprintf(text, sizeof(text), "%+.1f%%", (r.ns_per_op / base->second - 1.0) * 100.0);
+      delta = text;
+    }
+    printf("%-40s %10lu %14.0f %12.1f %10s\n", r.name.c_str(), r.iterations, r.ns_per_op,
+           r.allocs_per_op, delta.c_str());
+    fflush(stdout);
+    if (csv != NULL) {
+      fprintf(csv, "%s,%lu,%.1f,%.2f\n", r.name.c_str(), r.iterations, r.ns_per_op, r.allocs_per_op);
+    }
+  }
+
+  if (csv != NULL) {
+    fclose(csv);
+  }
+  fflush(stdout);
+  _exit(0);
+}
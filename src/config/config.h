@@ -9,6 +9,8 @@
 
 #define CONFIG_FILE "/config.json"
 
+bool save_config(SystemConfig config);
+
 SystemConfig load_config() {
   SystemConfig config = SystemConfig::defaultConfig();
   
@@ -129,7 +129,29 @@ struct SystemConfig {
   String wifi_password;
   int motion_timeout_sec;
   float min_face_confidence;
+  // Local fast path, descriptor similarity scale (see local_verification.h);
+  // negative: derived from min_face_confidence, 0: off
+  float local_approve_similarity;
+  float local_reject_similarity;
   bool offline_mode_enabled;
+  int camera_burst_size; // Frames per capture attempt, best one is kept
+  bool camera_quick_ae;  // Run a short AE loop on preview frames after wake
+  // Fraud rule thresholds (see fraud_detection.h)
+  float fraud_deny_confidence;
+  float fraud_approval_confidence;
+  float fraud_min_meal_cost;
+  unsigned long fraud_serve_window_sec;
+  unsigned long fraud_deny_window_sec;
+  int fraud_max_denials;
+  int fraud_anomaly_warning_score;  // Visit-profile score, 0-100
+  int fraud_anomaly_alert_score;
+  String device_id;        // Reported with sync batches, names this terminal to peers
+  bool peer_sync_enabled;  // Share serves with other terminals (see peer_sync.h)
+  String peer_group;       // Multicast group
+  int peer_port;
+  bool hub_mode;           // Relay and roster hub for the hall (see hub_service.h)
+  String hub_ip;           // Other terminals: the hub to use, "" for none
+  int hub_port;
   
   static SystemConfig defaultConfig() {
     SystemConfig config;
@@ -139,7 +161,26 @@ struct SystemConfig {
     config.wifi_password = "";
     config.motion_timeout_sec = 30;
     config.min_face_confidence = 0.80;
+    config.local_approve_similarity = -1.0;
+    config.local_reject_similarity = -1.0;
     config.offline_mode_enabled = true;
+    config.camera_burst_size = 3;
+    config.camera_quick_ae = true;
+    config.fraud_deny_confidence = 0.60;
+    config.fraud_approval_confidence = 0.75;
+    config.fraud_min_meal_cost = 100.0;
+    config.fraud_serve_window_sec = 6 * 3600;
+    config.fraud_deny_window_sec = 600;
+    config.fraud_max_denials = 3;
+    config.fraud_anomaly_warning_score = 40;
+    config.fraud_anomaly_alert_score = 70;
+    config.device_id = "esp32_device_001";
+    config.peer_sync_enabled = true;
+    config.peer_group = "239.10.0.1";
+    config.peer_port = 4210;
+    config.hub_mode = false;
+    config.hub_ip = "";
+    config.hub_port = 80;
     return config;
   }
   
@@ -151,7 +192,26 @@ struct SystemConfig {
     doc["wifi_password"] = wifi_password;
     doc["motion_timeout_sec"] = motion_timeout_sec;
     doc["min_face_confidence"] = min_face_confidence;
+    doc["local_approve_similarity"] = local_approve_similarity;
+    doc["local_reject_similarity"] = local_reject_similarity;
     doc["offline_mode_enabled"] = offline_mode_enabled;
+    doc["camera_burst_size"] = camera_burst_size;
+    doc["camera_quick_ae"] = camera_quick_ae;
+    doc["fraud_deny_confidence"] = fraud_deny_confidence;
+    doc["fraud_approval_confidence"] = fraud_approval_confidence;
+    doc["fraud_min_meal_cost"] = fraud_min_meal_cost;
+    doc["fraud_serve_window_sec"] = fraud_serve_window_sec;
+    doc["fraud_deny_window_sec"] = fraud_deny_window_sec;
+    doc["fraud_max_denials"] = fraud_max_denials;
+    doc["fraud_anomaly_warning_score"] = fraud_anomaly_warning_score;
+    doc["fraud_anomaly_alert_score"] = fraud_anomaly_alert_score;
+    doc["device_id"] = device_id;
+    doc["peer_sync_enabled"] = peer_sync_enabled;
+    doc["peer_group"] = peer_group;
+    doc["peer_port"] = peer_port;
+    doc["hub_mode"] = hub_mode;
+    doc["hub_ip"] = hub_ip;
+    doc["hub_port"] = hub_port;
     
     String result;
     serializeJson(doc, result);
@@ -168,7 +228,26 @@ struct SystemConfig {
       config.wifi_password = doc["wifi_password"] | config.wifi_password;
       config.motion_timeout_sec = doc["motion_timeout_sec"] | config.motion_timeout_sec;
       config.min_face_confidence = doc["min_face_confidence"] | config.min_face_confidence;
+      config.local_approve_similarity = doc["local_approve_similarity"] | config.local_approve_similarity;
+      config.local_reject_similarity = doc["local_reject_similarity"] | config.local_reject_similarity;
       config.offline_mode_enabled = doc["offline_mode_enabled"] | config.offline_mode_enabled;
+      config.camera_burst_size = doc["camera_burst_size"] | config.camera_burst_size;
+      config.camera_quick_ae = doc["camera_quick_ae"] | config.camera_quick_ae;
+      config.fraud_deny_confidence = doc["fraud_deny_confidence"] | config.fraud_deny_confidence;
+      config.fraud_approval_confidence = doc["fraud_approval_confidence"] | config.fraud_approval_confidence;
+      config.fraud_min_meal_cost = doc["fraud_min_meal_cost"] | config.fraud_min_meal_cost;
+      config.fraud_serve_window_sec = doc["fraud_serve_window_sec"] | config.fraud_serve_window_sec;
+      config.fraud_deny_window_sec = doc["fraud_deny_window_sec"] | config.fraud_deny_window_sec;
+      config.fraud_max_denials = doc["fraud_max_denials"] | config.fraud_max_denials;
+      config.fraud_anomaly_warning_score = doc["fraud_anomaly_warning_score"] | config.fraud_anomaly_warning_score;
+      config.fraud_anomaly_alert_score = doc["fraud_anomaly_alert_score"] | config.fraud_anomaly_alert_score;
+      config.device_id = doc["device_id"] | config.device_id;
+      config.peer_sync_enabled = doc["peer_sync_enabled"] | config.peer_sync_enabled;
+      config.peer_group = doc["peer_group"] | config.peer_group;
+      config.peer_port = doc["peer_port"] | config.peer_port;
+      config.hub_mode = doc["hub_mode"] | config.hub_mode;
+      config.hub_ip = doc["hub_ip"] | config.hub_ip;
+      config.hub_port = doc["hub_port"] | config.hub_port;
     }
     return config;
   }
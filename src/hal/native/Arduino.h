@@ -0,0 +1,206 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host stand-in for the parts of the ESP32 Arduino core the firmware uses.
+// Only built by the native environment; the device build never sees this.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+#include "freertos_shim.h"
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define IRAM_ATTR
+#define PROGMEM
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+class String {
+public:
+  String() {}
+  String(const char* cstr) : value(cstr != NULL ? cstr : "") {}
+  String(const char* cstr, size_t length) : value(cstr != NULL ? cstr : "", cstr != NULL ? length : 0) {}
+  String(const std::string& str) : value(str) {}
+  explicit String(char c) : value(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(long long value, unsigned char base = 10);
+  explicit String(unsigned long long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimals = 2);
+  explicit String(double value, unsigned char decimals = 2);
+
+  String& operator=(const char* cstr) {
+    value = cstr != NULL ? cstr : "";
+    return *this;
+  }
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.length(); }
+  bool isEmpty() const { return value.empty(); }
+  bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+  bool concat(const String& str) { value += str.value; return true; }
+  bool concat(const char* cstr) { if (cstr != NULL) value += cstr; return true; }
+  bool concat(const char* cstr, unsigned int length) { if (cstr != NULL) value.append(cstr, length); return true; }
+  bool concat(char c) { value += c; return true; }
+  template<typename T> bool concat(T number) { return concat(String(number)); }
+
+  String& operator+=(const String& str) { concat(str); return *this; }
+  String& operator+=(const char* cstr) { concat(cstr); return *this; }
+  String& operator+=(char c) { concat(c); return *this; }
+  template<typename T> String& operator+=(T number) { concat(String(number)); return *this; }
+
+  bool equals(const String& other) const { return value == other.value; }
+  bool equals(const char* cstr) const { return value == (cstr != NULL ? cstr : ""); }
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String& other) const { return value < other.value; }
+  int compareTo(const String& other) const { return value.compare(other.value); }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+  bool endsWith(const String& suffix) const {
+    return value.size() >= suffix.value.size() &&
+           value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+  }
+
+  char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) { return value[index]; }
+
+  int indexOf(char c, unsigned int from = 0) const { return to_index(value.find(c, from)); }
+  int indexOf(const String& str, unsigned int from = 0) const { return to_index(value.find(str.value, from)); }
+  int lastIndexOf(char c) const { return to_index(value.rfind(c)); }
+  int lastIndexOf(const String& str) const { return to_index(value.rfind(str.value)); }
+  String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const;
+
+  void toUpperCase();
+  void toLowerCase();
+  void trim();
+  void replace(const String& find, const String& with);
+  void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+  long toInt() const { return strtol(value.c_str(), NULL, 10); }
+  float toFloat() const { return strtof(value.c_str(), NULL); }
+
+  const std::string& str() const { return value; }
+
+private:
+  std::string value;
+
+  static int to_index(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+};
+
+// The core returns this from operator+; kept so string adapters see the same types
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+inline String operator+(const String& lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(const String& lhs, const char* rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(const char* lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(const String& lhs, char rhs) { String s(lhs); s += rhs; return s; }
+template<typename T> String operator+(const String& lhs, T rhs) { String s(lhs); s += String(rhs); return s; }
+inline bool operator==(const char* lhs, const String& rhs) { return rhs.equals(lhs); }
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return str != NULL ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  template<typename T> size_t print(T value) { return print(String(value)); }
+  size_t println() { return write((uint8_t)'\n'); }
+  template<typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(char* buffer, size_t length);
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+  String readString();
+  void setTimeout(unsigned long timeout) { (void)timeout; }
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() {}
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+// SNTP: the host's system time is already set, so this only records the call
+void configTime(long gmt_offset_sec, int daylight_offset_sec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// Emulated GPIO: firmware reads and writes a pin table, sim_hal.h drives it
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+// Cycle counter of a nominal 1 GHz core: one count per nanosecond
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 1000; }
+};
+
+extern EspClass ESP;
+
+// Host RAM stands in for PSRAM
+inline bool psramFound() { return true; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef NATIVE_ESPASYNCWEBSERVER_H
+#define NATIVE_ESPASYNCWEBSERVER_H
+
+// Route table, reached in-process with sim_web_dispatch() on the caller's
+// thread, or over loopback TCP once sim_web_listen() has been called.
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_ANY = 0b01111111
+} WebRequestMethod;
+
+class AsyncWebParameter {
+public:
+  AsyncWebParameter(const String& name, const String& value) : name_(name), value_(value) {}
+  const String& name() const { return name_; }
+  const String& value() const { return value_; }
+
+private:
+  String name_;
+  String value_;
+};
+
+class AsyncWebServerRequest {
+public:
+  AsyncWebServerRequest(WebRequestMethod method, const String& url)
+    : _tempObject(NULL), code(0), method_(method), url_(url) {}
+  ~AsyncWebServerRequest() { free(_tempObject); }  // Same ownership as the library
+
+  WebRequestMethod method() const { return method_; }
+  const String& url() const { return url_; }
+  bool hasParam(const String& name) const { return getParam(name) != NULL; }
+  const AsyncWebParameter* getParam(const String& name) const {
+    for (const AsyncWebParameter& param : params) {
+      if (param.name() == name) {
+        return &param;
+      }
+    }
+    return NULL;
+  }
+  void send(int status, const String& content_type = String(), const String& content = String()) {
+    (void)content_type;
+    code = status;
+    body = content;
+  }
+
+  void* _tempObject;  // Handler scratch, released with free()
+  std::vector<AsyncWebParameter> params;
+  int code;
+  String body;
+
+private:
+  WebRequestMethod method_;
+  String url_;
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index,
+                           uint8_t* data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                           size_t index, size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebServer {
+public:
+  explicit AsyncWebServer(uint16_t port) : port(port) {}
+
+  void on(const char* uri, int method, ArRequestHandlerFunction handler,
+          ArUploadHandlerFunction upload = nullptr, ArBodyHandlerFunction body = nullptr) {
+    (void)upload;
+    routes.push_back({String(uri), method, handler, body});
+  }
+  void begin() {}
+  // url may carry a query string; the body arrives in one piece
+  int dispatch(WebRequestMethod method, const String& url, const String& body, String& response);
+
+private:
+  struct Route {
+    String uri;
+    int method;
+    ArRequestHandlerFunction handler;
+    ArBodyHandlerFunction body;
+  };
+
+  uint16_t port;
+  std::vector<Route> routes;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef NATIVE_HTTPCLIENT_H
+#define NATIVE_HTTPCLIENT_H
+
+// Blocking HTTP/1.1 client over POSIX sockets, or an in-process handler
+// installed with sim_http_set_handler()
+
+#include <Arduino.h>
+#include <vector>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+public:
+  HTTPClient() : timeout_ms(5000) {}
+  bool begin(const String& url);
+  void setTimeout(uint16_t timeout) { timeout_ms = timeout; }
+  void addHeader(const String& name, const String& value);
+  int GET();
+  int POST(const String& payload);
+  String getString() { return response; }
+  void end();
+
+private:
+  String host;
+  uint16_t port;
+  String path;
+  std::vector<String> headers;
+  uint16_t timeout_ms;
+  String response;
+
+  int send(const char* method, const String& payload);
+};
+
+#endif
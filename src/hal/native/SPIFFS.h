@@ -0,0 +1,57 @@
+#ifndef NATIVE_SPIFFS_H
+#define NATIVE_SPIFFS_H
+
+// In-memory SPIFFS: files live in a map for the life of the process
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+struct NativeFileNode;
+
+class File : public Stream {
+public:
+  File() : position_(0), writable(false) {}
+  File(std::shared_ptr<NativeFileNode> node, const String& path, bool writable, size_t position);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t read(uint8_t* buffer, size_t size);
+  bool seek(uint32_t pos);
+  size_t position() const { return position_; }
+  size_t size() const;
+  const char* name() const { return path.c_str(); }
+  void flush() {}
+  void close();
+  operator bool() const { return node != nullptr; }
+
+private:
+  std::shared_ptr<NativeFileNode> node;
+  String path;
+  size_t position_;
+  bool writable;
+};
+
+class SPIFFSFS {
+public:
+  bool begin(bool format_on_fail = false);
+  void end() {}
+  bool format();
+  bool exists(const String& path);
+  File open(const String& path, const char* mode = FILE_READ);
+  bool remove(const String& path);
+  bool rename(const String& from, const String& to);
+  size_t totalBytes();
+  size_t usedBytes();
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef NATIVE_U8G2LIB_H
+#define NATIVE_U8G2LIB_H
+
+// Virtual 128x64 OLED. Drawing goes to a text layer: each string keeps its
+// position, and widths follow the real fonts' average advance so centering
+// and word wrap in oled_display.cpp behave as on the panel.
+
+#include <Arduino.h>
+#include <vector>
+
+#define U8X8_PIN_NONE 255
+#define U8G2_R0 0
+
+// {average advance, ascent} in pixels
+static const uint8_t u8g2_font_ncenB08_tr[] = {6, 8};
+static const uint8_t u8g2_font_ncenB10_tr[] = {7, 10};
+static const uint8_t u8g2_font_ncenB14_tr[] = {10, 14};
+static const uint8_t u8g2_font_ncenR08_tr[] = {5, 8};
+
+struct U8g2TextItem {
+  int x;
+  int y;
+  String text;
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C {
+public:
+  U8G2_SSD1306_128X64_NONAME_F_HW_I2C(int rotation, int reset) : font(u8g2_font_ncenB08_tr) {
+    (void)rotation;
+    (void)reset;
+  }
+
+  bool begin() { return true; }
+  void setFont(const uint8_t* f) { font = f; }
+  void setFontMode(int mode) { (void)mode; }
+  void setFontDirection(int dir) { (void)dir; }
+  void clearBuffer() { buffer.clear(); }
+  void clearDisplay() { buffer.clear(); sendBuffer(); }
+  int getStrWidth(const char* s) const { return strlen(s) * font[0]; }
+  int drawStr(int x, int y, const char* s);
+  void sendBuffer();
+
+private:
+  const uint8_t* font;
+  std::vector<U8g2TextItem> buffer;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+// Station-mode WiFi on the host: the link is up unless the simulator drops it
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} wifi_mode_t;
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+  String toString() const {
+    return String(octets[0]) + "." + String(octets[1]) + "." + String(octets[2]) + "." + String(octets[3]);
+  }
+  bool fromString(const char* address) {
+    unsigned int a, b, c, d;
+    char tail;
+    if (sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 ||
+        c > 255 || d > 255) {
+      return false;
+    }
+    octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d;
+    return true;
+  }
+  bool fromString(const String& address) { return fromString(address.c_str()); }
+  uint8_t operator[](int index) const { return octets[index]; }
+  bool operator==(const IPAddress& other) const { return memcmp(octets, other.octets, 4) == 0; }
+
+private:
+  uint8_t octets[4];
+};
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t mode) { (void)mode; return true; }
+  wl_status_t begin(const char* ssid, const char* password = NULL);
+  bool disconnect(bool wifi_off = false);
+  wl_status_t status();
+  int8_t RSSI();
+  IPAddress localIP();
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef NATIVE_WIFI_UDP_H
+#define NATIVE_WIFI_UDP_H
+
+// UDP on host sockets, with the part of the ESP32 WiFiUDP API the firmware
+// uses. Multicast stays on loopback, so several simulated terminals on one
+// machine hear each other and nothing leaves the host.
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define SIM_UDP_MAX_PACKET 1472
+
+class WiFiUDP {
+public:
+  WiFiUDP() : sock(-1), group_port(0), rx_len(0), rx_pos(0), tx_len(0) {}
+  ~WiFiUDP() { stop(); }
+
+  uint8_t beginMulticast(IPAddress group, uint16_t port);
+  void stop();
+
+  // Sending: one datagram per begin/end pair
+  int beginMulticastPacket();
+  int beginPacket(IPAddress ip, uint16_t port);
+  size_t write(const uint8_t* buffer, size_t size);
+  int endPacket();
+
+  // Receiving: never blocks, 0 when nothing is waiting
+  int parsePacket();
+  int available() { return rx_len - rx_pos; }
+  int read(uint8_t* buffer, size_t len);
+  IPAddress remoteIP() { return rx_from; }
+
+private:
+  int sock;
+  IPAddress group;
+  uint16_t group_port;
+  IPAddress tx_to;
+  uint16_t tx_port;
+  IPAddress rx_from;
+  uint8_t rx_buffer[SIM_UDP_MAX_PACKET];
+  int rx_len;
+  int rx_pos;
+  uint8_t tx_buffer[SIM_UDP_MAX_PACKET];
+  size_t tx_len;
+};
+
+#endif
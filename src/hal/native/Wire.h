@@ -0,0 +1,14 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+// The virtual OLED has no bus; pin setup is accepted and ignored
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1) { (void)sda; (void)scl; return true; }
+};
+
+extern TwoWire Wire;
+
+#endif
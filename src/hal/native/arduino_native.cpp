@@ -0,0 +1,395 @@
+#include <Arduino.h>
+#include <esp32-hal-cpu.h>
+#include "sim_hal.h"
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+
+HardwareSerial Serial;
+
+// ---- String ----
+
+static std::string format_integer(unsigned long long value, bool negative, unsigned char base) {
+  if (base < 2 || base > 36) {
+    base = 10;
+  }
+  char buf[72];
+  int pos = sizeof(buf) - 1;
+  buf[pos] = '\0';
+  do {
+    int digit = value % base;
+    buf[--pos] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value > 0);
+  if (negative) {
+    buf[--pos] = '-';
+  }
+  return std::string(buf + pos);
+}
+
+static std::string format_signed(long long value, unsigned char base) {
+  // The core prints negative values in base 10 only
+  if (value < 0 && base == 10) {
+    return format_integer(0ULL - (unsigned long long)value, true, base);
+  }
+  return format_integer((unsigned long long)value, false, base);
+}
+
+static std::string format_float(double value, unsigned char decimals) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+  return std::string(buf);
+}
+
+String::String(unsigned char value, unsigned char base) : value(format_integer(value, false, base)) {}
+String::String(int value, unsigned char base) : value(format_signed(value, base)) {}
+String::String(unsigned int value, unsigned char base) : value(format_integer(value, false, base)) {}
+String::String(long value, unsigned char base) : value(format_signed(value, base)) {}
+String::String(unsigned long value, unsigned char base) : value(format_integer(value, false, base)) {}
+String::String(long long value, unsigned char base) : value(format_signed(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : value(format_integer(value, false, base)) {}
+String::String(float value, unsigned char decimals) : value(format_float(value, decimals)) {}
+String::String(double value, unsigned char decimals) : value(format_float(value, decimals)) {}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    std::swap(from, to);
+  }
+  if (from >= value.size()) {
+    return String();
+  }
+  return String(value.substr(from, std::min<size_t>(to, value.size()) - from));
+}
+
+void String::toUpperCase() {
+  for (char& c : value) {
+    c = toupper((unsigned char)c);
+  }
+}
+
+void String::toLowerCase() {
+  for (char& c : value) {
+    c = tolower((unsigned char)c);
+  }
+}
+
+void String::trim() {
+  size_t begin = 0;
+  while (begin < value.size() && isspace((unsigned char)value[begin])) {
+    begin++;
+  }
+  size_t end = value.size();
+  while (end > begin && isspace((unsigned char)value[end - 1])) {
+    end--;
+  }
+  value = value.substr(begin, end - begin);
+}
+
+void String::replace(const String& find, const String& with) {
+  if (find.value.empty()) {
+    return;
+  }
+  size_t pos = 0;
+  while ((pos = value.find(find.value, pos)) != std::string::npos) {
+    value.replace(pos, find.value.size(), with.value);
+    pos += with.value.size();
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < value.size()) {
+    value.erase(index, count);
+  }
+}
+
+// ---- Print / Stream / Serial ----
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buf[512];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return write((const uint8_t*)buf, std::min<size_t>(len, sizeof(buf) - 1));
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = read();
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+String Stream::readString() {
+  String result;
+  int c;
+  while ((c = read()) >= 0) {
+    result += (char)c;
+  }
+  return result;
+}
+
+// Serial lines from several tasks must not interleave mid-line
+static std::mutex serial_lock;
+static std::atomic<bool> serial_echo(true);
+
+size_t HardwareSerial::write(uint8_t c) {
+  std::lock_guard<std::mutex> guard(serial_lock);
+  if (serial_echo) {
+    fputc(c, stdout);
+  }
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  std::lock_guard<std::mutex> guard(serial_lock);
+  return serial_echo ? fwrite(buffer, 1, size, stdout) : size;
+}
+
+void sim_serial_set_echo(bool echo) {
+  serial_echo = echo;
+}
+
+// ---- Time ----
+
+static const std::chrono::steady_clock::time_point boot_time = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - boot_time).count();
+}
+
+unsigned long micros() {
+  // Wraps at 32 bits like the device counter, so unsigned differences still work
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - boot_time).count();
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - boot_time).count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+void configTime(long gmt_offset_sec, int daylight_offset_sec, const char* server1, const char* server2,
+                const char* server3) {
+  (void)gmt_offset_sec;
+  (void)daylight_offset_sec;
+  (void)server1;
+  (void)server2;
+  (void)server3;
+}
+
+static uint32_t cpu_freq_mhz = 240;
+
+bool setCpuFrequencyMhz(uint32_t mhz) {
+  cpu_freq_mhz = mhz;
+  return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+  return cpu_freq_mhz;
+}
+
+// ---- Random ----
+
+static std::mt19937 random_engine(1);
+static std::mutex random_lock;
+
+long random(long max) {
+  return random(0, max);
+}
+
+long random(long min, long max) {
+  if (max <= min) {
+    return min;
+  }
+  std::lock_guard<std::mutex> guard(random_lock);
+  return min + (long)(random_engine() % (unsigned long)(max - min));
+}
+
+void randomSeed(unsigned long seed) {
+  std::lock_guard<std::mutex> guard(random_lock);
+  random_engine.seed(seed);
+}
+
+// ---- GPIO ----
+
+#define SIM_GPIO_COUNT 40
+#define SIM_MAX_SWITCHES 4
+
+struct SimPin {
+  uint8_t mode;
+  uint8_t output;     // Level written by the firmware
+  int external;       // Level driven from outside, -1 when floating
+  void (*isr)();
+  int isr_mode;
+};
+
+struct SimSwitch {
+  uint8_t a;
+  uint8_t b;
+  unsigned long release_at;
+  bool active;
+};
+
+static SimPin sim_pins[SIM_GPIO_COUNT];
+static SimSwitch sim_switches[SIM_MAX_SWITCHES];
+static std::recursive_mutex gpio_lock;
+
+static SimPin* pin_at(uint8_t pin) {
+  return pin < SIM_GPIO_COUNT ? &sim_pins[pin] : NULL;
+}
+
+// A closed switch pulls an input low when the pin on its other side is driven low
+static bool switch_pulls_low(uint8_t pin) {
+  unsigned long now = millis();
+  for (int i = 0; i < SIM_MAX_SWITCHES; i++) {
+    SimSwitch& sw = sim_switches[i];
+    if (!sw.active || (long)(now - sw.release_at) >= 0) {
+      sw.active = false;
+      continue;
+    }
+    uint8_t other = sw.a == pin ? sw.b : sw.b == pin ? sw.a : 0xFF;
+    if (other != 0xFF && sim_pins[other].mode == OUTPUT && sim_pins[other].output == LOW) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+  SimPin* p = pin_at(pin);
+  if (p != NULL) {
+    p->mode = mode;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+  SimPin* p = pin_at(pin);
+  if (p != NULL) {
+    p->output = level;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+  SimPin* p = pin_at(pin);
+  if (p == NULL) {
+    return LOW;
+  }
+  if (p->external >= 0) {
+    return p->external;
+  }
+  if (switch_pulls_low(pin)) {
+    return LOW;
+  }
+  if (p->mode == INPUT_PULLUP) {
+    return HIGH;
+  }
+  return p->mode == OUTPUT ? p->output : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+  SimPin* p = pin_at(pin);
+  if (p != NULL) {
+    p->isr = isr;
+    p->isr_mode = mode;
+  }
+}
+
+void detachInterrupt(uint8_t pin) {
+  attachInterrupt(pin, NULL, 0);
+}
+
+void sim_gpio_set(uint8_t pin, int level) {
+  void (*isr)() = NULL;
+  {
+    std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+    SimPin* p = pin_at(pin);
+    if (p == NULL) {
+      return;
+    }
+    int before = p->external >= 0 ? p->external : LOW;
+    p->external = level;
+    bool rising = before == LOW && level == HIGH;
+    bool falling = before == HIGH && level == LOW;
+    if (p->isr != NULL && ((rising && p->isr_mode != FALLING) || (falling && p->isr_mode != RISING))) {
+      isr = p->isr;
+    }
+  }
+  // Runs on the caller's thread, standing in for interrupt context
+  if (isr != NULL) {
+    isr();
+  }
+}
+
+void sim_gpio_release(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+  SimPin* p = pin_at(pin);
+  if (p != NULL) {
+    p->external = -1;
+  }
+}
+
+bool sim_gpio_close_switch(uint8_t a, uint8_t b, unsigned long hold_ms) {
+  std::lock_guard<std::recursive_mutex> guard(gpio_lock);
+  unsigned long now = millis();
+  for (int i = 0; i < SIM_MAX_SWITCHES; i++) {
+    SimSwitch& sw = sim_switches[i];
+    if (!sw.active || (long)(now - sw.release_at) >= 0) {
+      sw.a = a;
+      sw.b = b;
+      sw.release_at = now + hold_ms;
+      sw.active = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+static struct SimPinsInit {
+  SimPinsInit() {
+    for (int i = 0; i < SIM_GPIO_COUNT; i++) {
+      sim_pins[i].mode = INPUT;
+      sim_pins[i].output = LOW;
+      sim_pins[i].external = -1;
+      sim_pins[i].isr = NULL;
+      sim_pins[i].isr_mode = 0;
+    }
+  }
+} sim_pins_init;
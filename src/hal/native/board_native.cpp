@@ -0,0 +1,31 @@
+#include "sim_hal.h"
+#include "../../modules/keyboard_module.h"
+
+// Same wiring as motion_sensor.cpp and keyboard_module.cpp, so their
+// drivers run unchanged against the emulated pins
+#define SIM_PIR_PIN 16
+#define SIM_KEY_HOLD_MS 15  // Shorter than the 20 ms debounce: one press, no repeat
+
+static const uint8_t SIM_ROW_PINS[4] = {14, 15, 16, 0};
+static const uint8_t SIM_COL_PINS[4] = {13, 12, 4, 2};
+static const int SIM_KEY_MAP[4][4] = {
+  {1, 2, 3, KEY_APPROVE},
+  {4, 5, 6, KEY_DENY},
+  {7, 8, 9, KEY_RETRY},
+  {KEY_STAR, 0, KEY_HASH, KEY_OVERRIDE}
+};
+
+void sim_motion(bool present) {
+  sim_gpio_set(SIM_PIR_PIN, present ? HIGH : LOW);
+}
+
+bool sim_key_press(int key) {
+  for (int row = 0; row < 4; row++) {
+    for (int col = 0; col < 4; col++) {
+      if (SIM_KEY_MAP[row][col] == key) {
+        return sim_gpio_close_switch(SIM_ROW_PINS[row], SIM_COL_PINS[col], SIM_KEY_HOLD_MS);
+      }
+    }
+  }
+  return false;
+}
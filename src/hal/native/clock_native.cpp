@@ -0,0 +1,26 @@
+#include "sim_hal.h"
+#include "../../utils/clock.h"
+#include <atomic>
+
+static std::atomic<unsigned long> virtual_ms(0);
+
+static unsigned long virtual_clock_read() {
+  return virtual_ms;
+}
+
+void sim_clock_install(unsigned long start_ms) {
+  virtual_ms = start_ms;
+  clock_set_source(virtual_clock_read);
+}
+
+void sim_clock_uninstall() {
+  clock_set_source(NULL);
+}
+
+void sim_clock_set_ms(unsigned long ms) {
+  virtual_ms = ms;
+}
+
+void sim_clock_advance_ms(unsigned long ms) {
+  virtual_ms += ms;
+}
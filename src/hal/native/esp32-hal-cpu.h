@@ -0,0 +1,10 @@
+#ifndef NATIVE_ESP32_HAL_CPU_H
+#define NATIVE_ESP32_HAL_CPU_H
+
+#include <stdint.h>
+
+// Frequency is only recorded, so sleep-mode transitions can be observed
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+uint32_t getCpuFrequencyMhz();
+
+#endif
@@ -0,0 +1,501 @@
+#include "../../modules/esp_cam_module.h"
+#include "../../modules/esp_cam_config.h"
+#include "sim_hal.h"
+#include "../../utils/helpers.h"
+#include "../../utils/logger.h"
+#include "../../utils/clock.h"
+#include <vector>
+#include <mutex>
+
+// Grayscale frames stand in for the OV2640's JPEGs. The "JPEG" handed to the
+// pipeline is the frame as a binary PGM, so payload sizes and the encode path
+// stay representative once the face crop has shrunk it. JPEG quality is not
+// modelled, so only a profile's crop side changes the payload here.
+
+// The device's init frame size with PSRAM (VGA)
+#define SIM_FRAME_WIDTH 640
+#define SIM_FRAME_HEIGHT 480
+
+struct SimFrame {
+  uint16_t width;
+  uint16_t height;
+  std::vector<uint8_t> pixels;
+  std::vector<uint8_t> encoded;  // PGM bytes
+  float score;
+  unsigned long captured_at;
+  bool valid;
+};
+
+static std::mutex source_lock;
+static SimFrame source_file;       // Loaded PGM, used instead of the synthetic face
+static String source_subject = "default";
+static unsigned long capture_delay_ms = 0;
+static unsigned long frames_grabbed = 0;
+
+bool cam_initialized = false;
+bool cam_sleeping = false;
+bool quick_ae_enabled = true;
+int capture_profile = 0;
+
+SimFrame frame;
+LumaImage frame_luma;
+bool frame_luma_valid = false;
+LumaImage candidate_luma;
+SimFrame precapture_ring[PRECAPTURE_SLOTS];
+bool precapture_active = false;
+int precapture_next = 0;
+unsigned long precapture_last_grab = 0;
+
+CameraBurstStats burst_stats = {0, 0, 0, 0};
+CameraWakeStats wake_stats = {0, 0, 0, 0, 0};
+
+static uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+}
+
+static uint32_t subject_seed(const String& subject) {
+  uint32_t h = 2166136261u;
+  for (unsigned int i = 0; i < subject.length(); i++) {
+    h = (h ^ (uint8_t)subject[i]) * 16777619u;
+  }
+  return h;
+}
+
+// Face-like test card: textured background, a brighter face square with a
+// dark eye band split by a bright bridge. Texture and placement depend on the
+// subject, so each student gets a stable descriptor; a little per-frame noise
+// keeps bursts from being identical.
+static void synthesize_frame(const String& subject, uint32_t frame_seq, uint16_t width, uint16_t height,
+                             std::vector<uint8_t>& pixels) {
+  uint32_t seed = subject_seed(subject);
+  int side = height * (55 + seed % 15) / 100;
+  int face_x = (width - side) / 2 + (int)(seed >> 8) % 9 - 4;
+  int face_y = (height - side) / 2 + (int)(seed >> 12) % 9 - 4;
+
+  pixels.resize((size_t)width * height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int block = hash32(seed ^ ((y / 8) * 1024 + x / 8)) % 41 - 20;
+      int value = 110 + block;
+
+      int fx = (x - face_x) * 20;
+      int fy = (y - face_y) * 20;
+      if (fx >= 0 && fy >= 0 && fx < 20 * side && fy < 20 * side) {
+        fx /= side;
+        fy /= side;
+        value = 165 + block / 2;
+        if (fy >= 5 && fy < 9 && fx >= 3 && fx < 17) {
+          value = (fx >= 8 && fx < 12) ? 185 : 65 + block / 2;
+        } else if (fy >= 10 && fy < 14 && fx >= 3 && fx < 17) {
+          value = 175 + block / 2;
+        }
+      }
+
+      value += (int)(hash32(frame_seq * 2654435761u ^ (y * width + x)) % 7) - 3;
+      pixels[(size_t)y * width + x] = value < 0 ? 0 : value > 255 ? 255 : value;
+    }
+  }
+}
+
+static void encode_pgm(SimFrame& f) {
+  char header[32];
+  int len = snprintf(header, sizeof(header), "P5\n%u %u\n255\n", f.width, f.height);
+  f.encoded.assign(header, header + len);
+  f.encoded.insert(f.encoded.end(), f.pixels.begin(), f.pixels.end());
+}
+
+// Nearest-neighbour resample of a loaded file to the frame size
+static void resample(const SimFrame& src, uint16_t width, uint16_t height, std::vector<uint8_t>& out) {
+  out.resize((size_t)width * height);
+  for (int y = 0; y < height; y++) {
+    const uint8_t* row = src.pixels.data() + (size_t)(y * src.height / height) * src.width;
+    for (int x = 0; x < width; x++) {
+      out[(size_t)y * width + x] = row[x * src.width / width];
+    }
+  }
+}
+
+static bool grab_frame(SimFrame& out) {
+  if (capture_delay_ms > 0) {
+    delay(capture_delay_ms);
+  }
+
+  out.width = SIM_FRAME_WIDTH;
+  out.height = SIM_FRAME_HEIGHT;
+  {
+    std::lock_guard<std::mutex> guard(source_lock);
+    if (source_file.valid) {
+      resample(source_file, out.width, out.height, out.pixels);
+    } else {
+      synthesize_frame(source_subject, frames_grabbed, out.width, out.height, out.pixels);
+    }
+    frames_grabbed++;
+  }
+  encode_pgm(out);
+  out.captured_at = clock_millis();
+  out.valid = true;
+  return true;
+}
+
+// 8x8 area average, the host counterpart of the 1/8-scale JPEG decode
+static bool decode_luma(const SimFrame& f, LumaImage& out) {
+  uint16_t width = f.width / 8;
+  uint16_t height = f.height / 8;
+  if (width > LUMA_MAX_WIDTH || height > LUMA_MAX_HEIGHT || width == 0 || height == 0) {
+    return false;
+  }
+
+  out.width = width;
+  out.height = height;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint32_t sum = 0;
+      for (int dy = 0; dy < 8; dy++) {
+        const uint8_t* row = f.pixels.data() + (size_t)(y * 8 + dy) * f.width + x * 8;
+        for (int dx = 0; dx < 8; dx++) {
+          sum += row[dx];
+        }
+      }
+      out.pixels[y * width + x] = sum / 64;
+    }
+  }
+  return true;
+}
+
+// Same ranking as the device: sharpness weighted by the face score
+static float score_frame(const SimFrame& f, LumaImage& luma) {
+  if (!decode_luma(f, luma)) {
+    return -1.0;
+  }
+
+  FaceBox face;
+  float sharpness = image_laplacian_variance(luma);
+  if (image_find_face(luma, 0.35, face)) {
+    return sharpness * (1.0 + face.score);
+  }
+  return sharpness * 0.1;
+}
+
+bool esp_cam_init() {
+  cam_initialized = true;
+  Logger::logInfo("Camera: Initialized (simulated sensor)");
+  return true;
+}
+
+void esp_cam_sleep() {
+  if (!cam_initialized || cam_sleeping) {
+    return;
+  }
+  esp_cam_cleanup();
+  precapture_active = false;
+  cam_sleeping = true;
+  Logger::logInfo("Camera: Sleeping");
+}
+
+bool esp_cam_wake() {
+  if (!cam_sleeping) {
+    return true;
+  }
+  cam_sleeping = false;
+  wake_stats.wakes++;
+  wake_stats.restore_us = 0;
+  wake_stats.last_usable_us = 0;
+  Logger::logInfo("Camera: Awake");
+  return true;
+}
+
+bool esp_cam_is_sleeping() {
+  return cam_sleeping;
+}
+
+CameraWakeStats esp_cam_get_wake_stats() {
+  return wake_stats;
+}
+
+// Exposure is fixed on the host
+void esp_cam_preload_exposure() {
+}
+
+bool esp_cam_quick_ae() {
+  return true;
+}
+
+void esp_cam_set_quick_ae(bool enabled) {
+  quick_ae_enabled = enabled;
+}
+
+bool esp_cam_apply_profile(int level) {
+  if (level < 0 || level >= CAPTURE_PROFILE_COUNT) {
+    return false;
+  }
+  capture_profile = level;
+  return true;
+}
+
+int esp_cam_get_profile() {
+  return capture_profile;
+}
+
+int esp_cam_profile_count() {
+  return CAPTURE_PROFILE_COUNT;
+}
+
+bool esp_cam_capture_frame() {
+  if (!cam_initialized || cam_sleeping) {
+    return false;
+  }
+  esp_cam_cleanup();
+  return grab_frame(frame);
+}
+
+bool esp_cam_capture_burst(int burst_size) {
+  if (!cam_initialized || cam_sleeping) {
+    return false;
+  }
+  if (burst_size < 1) {
+    burst_size = 1;
+  }
+
+  esp_cam_cleanup();
+
+  unsigned long start = micros();
+  unsigned long score_us = 0;
+  float best_score = -2.0;
+  SimFrame grab;
+  for (int i = 0; i < burst_size; i++) {
+    grab_frame(grab);
+    unsigned long score_start = micros();
+    float score = score_frame(grab, candidate_luma);
+    score_us += micros() - score_start;
+
+    if (score > best_score) {
+      std::swap(frame, grab);
+      best_score = score;
+      frame_luma_valid = score >= 0.0;
+      if (frame_luma_valid) {
+        frame_luma = candidate_luma;
+      }
+    }
+  }
+
+  burst_stats.bursts++;
+  burst_stats.frames += burst_size;
+  burst_stats.total_burst_us += micros() - start;
+  burst_stats.total_score_us += score_us;
+
+  Logger::logInfo("Camera: Burst of " + String(burst_size) + " in " + String((micros() - start) / 1000) +
+                  " ms, best score " + String(best_score, 1));
+  return true;
+}
+
+String esp_cam_get_base64_jpeg() {
+  if (!frame.valid) {
+    return "";
+  }
+  return Helpers::base64Encode(frame.encoded.data(), frame.encoded.size());
+}
+
+const LumaImage* esp_cam_get_luma() {
+  if (!frame.valid) {
+    return nullptr;
+  }
+  if (!frame_luma_valid) {
+    frame_luma_valid = decode_luma(frame, frame_luma);
+  }
+  return frame_luma_valid ? &frame_luma : nullptr;
+}
+
+bool esp_cam_crop_to_face(const FaceBox& face) {
+  const LumaImage* luma = esp_cam_get_luma();
+  if (luma == nullptr) {
+    return false;
+  }
+
+  uint16_t crop_size = CAPTURE_PROFILES[capture_profile].crop_size;
+  CropRect rect;
+  if (!image_face_crop_rect(face, luma->width, luma->height, frame.width, frame.height,
+                            FACE_CROP_PADDING, rect)) {
+    return false;
+  }
+
+  // Run the device's RGB888 crop on a gray-expanded copy, then keep one channel
+  std::vector<uint8_t> rgb(frame.pixels.size() * 3);
+  for (size_t i = 0; i < frame.pixels.size(); i++) {
+    rgb[i * 3] = rgb[i * 3 + 1] = rgb[i * 3 + 2] = frame.pixels[i];
+  }
+  std::vector<uint8_t> scaled(crop_size * crop_size * 3);
+  if (!image_crop_scale_rgb888(rgb.data(), frame.width, frame.height, rect,
+                               scaled.data(), crop_size, crop_size)) {
+    return false;
+  }
+
+  size_t source_len = frame.encoded.size();
+  frame.width = crop_size;
+  frame.height = crop_size;
+  frame.pixels.resize(crop_size * crop_size);
+  for (size_t i = 0; i < frame.pixels.size(); i++) {
+    frame.pixels[i] = scaled[i * 3];
+  }
+  encode_pgm(frame);
+  frame_luma_valid = false;
+
+  Logger::logInfo("Camera: Face crop " + String(source_len) + " -> " + String(frame.encoded.size()) + " bytes");
+  return true;
+}
+
+void esp_cam_cleanup() {
+  frame.valid = false;
+  frame_luma_valid = false;
+}
+
+size_t esp_cam_get_frame_size() {
+  return frame.valid ? frame.encoded.size() : 0;
+}
+
+bool esp_cam_precapture_start() {
+  if (!cam_initialized || cam_sleeping) {
+    return false;
+  }
+  for (int i = 0; i < PRECAPTURE_SLOTS; i++) {
+    precapture_ring[i].valid = false;
+  }
+  precapture_next = 0;
+  precapture_last_grab = 0;
+  precapture_active = true;
+  return true;
+}
+
+void esp_cam_precapture_stop() {
+  precapture_active = false;
+}
+
+void esp_cam_precapture_poll() {
+  if (!precapture_active || cam_sleeping || clock_millis() - precapture_last_grab < PRECAPTURE_INTERVAL_MS) {
+    return;
+  }
+  precapture_last_grab = clock_millis();
+
+  SimFrame& slot = precapture_ring[precapture_next];
+  grab_frame(slot);
+  slot.score = score_frame(slot, candidate_luma);
+  precapture_next = (precapture_next + 1) % PRECAPTURE_SLOTS;
+}
+
+bool esp_cam_take_precaptured() {
+  int best = -1;
+  unsigned long now = clock_millis();
+  for (int i = 0; i < PRECAPTURE_SLOTS; i++) {
+    SimFrame& slot = precapture_ring[i];
+    if (!slot.valid || now - slot.captured_at > PRECAPTURE_MAX_AGE_MS) {
+      continue;
+    }
+    if (best < 0 || slot.score > precapture_ring[best].score) {
+      best = i;
+    }
+  }
+
+  if (best < 0) {
+    return false;
+  }
+
+  esp_cam_cleanup();
+  SimFrame& slot = precapture_ring[best];
+  std::swap(frame, slot);
+  slot.valid = false; // Hand out each frame once
+
+  Logger::logInfo("Camera: Using pre-captured frame (" + String(now - frame.captured_at) + " ms old)");
+  return true;
+}
+
+CameraBurstStats esp_cam_get_burst_stats() {
+  return burst_stats;
+}
+
+void esp_cam_log_burst_stats() {
+  if (burst_stats.bursts == 0) {
+    return;
+  }
+
+  Logger::logf("[INFO] Camera: %lu bursts, %.1f frames/burst, %lu us/burst, %lu us scoring/frame",
+               burst_stats.bursts,
+               (float)burst_stats.frames / burst_stats.bursts,
+               burst_stats.total_burst_us / burst_stats.bursts,
+               burst_stats.frames > 0 ? burst_stats.total_score_us / burst_stats.frames : 0);
+}
+
+// ---- Simulator control ----
+
+static bool read_pgm_token(FILE* f, unsigned long& value) {
+  int c;
+  do {
+    c = fgetc(f);
+    if (c == '#') {
+      while (c != '\n' && c != EOF) {
+        c = fgetc(f);
+      }
+    }
+  } while (c != EOF && isspace(c));
+
+  if (c == EOF || !isdigit(c)) {
+    return false;
+  }
+  value = 0;
+  while (c != EOF && isdigit(c)) {
+    value = value * 10 + (c - '0');
+    c = fgetc(f);
+  }
+  return true;  // The single whitespace after maxval is consumed here
+}
+
+bool sim_camera_load_frame(const char* path) {
+  std::lock_guard<std::mutex> guard(source_lock);
+  if (path == NULL || path[0] == '\0') {
+    source_file.valid = false;
+    return true;
+  }
+
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    Logger::logError("Sim Camera: Cannot open " + String(path));
+    return false;
+  }
+
+  unsigned long width = 0;
+  unsigned long height = 0;
+  unsigned long maxval = 0;
+  bool ok = fgetc(f) == 'P' && fgetc(f) == '5' &&
+            read_pgm_token(f, width) && read_pgm_token(f, height) && read_pgm_token(f, maxval) &&
+            maxval == 255 && width >= 8 && height >= 8 && width <= 4096 && height <= 4096;
+  if (ok) {
+    source_file.width = width;
+    source_file.height = height;
+    source_file.pixels.resize(width * height);
+    ok = fread(source_file.pixels.data(), 1, source_file.pixels.size(), f) == source_file.pixels.size();
+  }
+  fclose(f);
+
+  source_file.valid = ok;
+  if (!ok) {
+    Logger::logError("Sim Camera: " + String(path) + " is not an 8-bit binary PGM");
+  }
+  return ok;
+}
+
+void sim_camera_set_subject(const char* subject) {
+  std::lock_guard<std::mutex> guard(source_lock);
+  source_subject = subject;
+}
+
+void sim_camera_set_capture_ms(unsigned long ms) {
+  capture_delay_ms = ms;
+}
+
+unsigned long sim_camera_frames() {
+  std::lock_guard<std::mutex> guard(source_lock);
+  return frames_grabbed;
+}
@@ -0,0 +1,6 @@
+#ifndef NATIVE_ESP_PM_H
+#define NATIVE_ESP_PM_H
+
+// Power management has no effect on the host
+
+#endif
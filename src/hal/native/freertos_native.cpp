@@ -0,0 +1,130 @@
+#include <Arduino.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+struct NativeTask {
+  const char* name;
+  uint32_t stack;
+  std::mutex lock;
+  std::condition_variable wake;
+  uint32_t notify_count;
+};
+
+struct NativeSemaphore {
+  std::recursive_timed_mutex mutex;
+};
+
+// Threads not created here (main, sim drivers) get a task block on first use
+static thread_local NativeTask* current_task = NULL;
+
+static NativeTask* new_task(const char* name, uint32_t stack) {
+  NativeTask* task = new NativeTask();
+  task->name = name;
+  task->stack = stack;
+  task->notify_count = 0;
+  return task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t entry, const char* name, uint32_t stack,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  (void)priority;
+  (void)core;
+  NativeTask* task = new_task(name, stack);
+  if (handle != NULL) {
+    *handle = task;
+  }
+
+  std::thread([task, entry, arg]() {
+    current_task = task;
+    entry(arg);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (current_task == NULL) {
+    current_task = new_task("host", 0);
+  }
+  return current_task;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return task != NULL ? task->stack : 0;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
+
+TickType_t xTaskGetTickCount() {
+  return millis();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  if (task == NULL) {
+    return pdFAIL;
+  }
+  {
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notify_count++;
+  }
+  task->wake.notify_one();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+  xTaskNotifyGive(task);
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  NativeTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> guard(task->lock);
+  auto ready = [task]() { return task->notify_count > 0; };
+  if (ticks == portMAX_DELAY) {
+    task->wake.wait(guard, ready);
+  } else {
+    task->wake.wait_for(guard, std::chrono::milliseconds(ticks), ready);
+  }
+
+  uint32_t count = task->notify_count;
+  if (count > 0) {
+    task->notify_count = clear_on_exit == pdTRUE ? 0 : count - 1;
+  }
+  return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new NativeSemaphore();
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  return new NativeSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    sem->mutex.lock();
+    return pdTRUE;
+  }
+  return sem->mutex.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  sem->mutex.unlock();
+  return pdTRUE;
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+  while (mux->locked.exchange(true, std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+  mux->locked.store(false, std::memory_order_release);
+}
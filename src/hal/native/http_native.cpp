@@ -0,0 +1,168 @@
+#include <HTTPClient.h>
+#include "sim_hal.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <string>
+
+static SimHttpHandler http_handler = NULL;
+static unsigned long http_latency_ms = 0;
+static String http_direct_host = "";
+static uint16_t http_direct_port = 0;
+
+void sim_http_set_handler(SimHttpHandler handler) {
+  http_handler = handler;
+}
+
+void sim_http_set_direct(const String& host, uint16_t port) {
+  http_direct_host = host;
+  http_direct_port = port;
+}
+
+void sim_http_set_latency_ms(unsigned long ms) {
+  http_latency_ms = ms;
+}
+
+bool HTTPClient::begin(const String& url) {
+  headers.clear();
+  response = "";
+
+  // http://host[:port]/path
+  if (!url.startsWith("http://")) {
+    return false;
+  }
+  String rest = url.substring(7);
+  int slash = rest.indexOf('/');
+  String authority = slash >= 0 ? rest.substring(0, slash) : rest;
+  path = slash >= 0 ? rest.substring(slash) : String("/");
+
+  int colon = authority.indexOf(':');
+  host = colon >= 0 ? authority.substring(0, colon) : authority;
+  port = colon >= 0 ? authority.substring(colon + 1).toInt() : 80;
+  return host.length() > 0;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+  headers.push_back(name + ": " + value);
+}
+
+int HTTPClient::GET() {
+  return send("GET", "");
+}
+
+int HTTPClient::POST(const String& payload) {
+  return send("POST", payload);
+}
+
+void HTTPClient::end() {
+  headers.clear();
+}
+
+static int connect_to(const String& host, uint16_t port, uint16_t timeout_ms) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo* result = NULL;
+  if (getaddrinfo(host.c_str(), String(port).c_str(), &hints, &result) != 0) {
+    return -1;
+  }
+
+  int fd = -1;
+  for (struct addrinfo* ai = result; ai != NULL; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(result);
+  return fd;
+}
+
+int HTTPClient::send(const char* method, const String& payload) {
+  response = "";
+  if (http_latency_ms > 0) {
+    delay(http_latency_ms);
+  }
+
+  bool direct = port == http_direct_port && host == http_direct_host;
+  if (http_handler != NULL && !direct) {
+    return http_handler(method, path, payload, response);
+  }
+
+  int fd = connect_to(host, port, timeout_ms);
+  if (fd < 0) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  std::string request = std::string(method) + " " + path.str() + " HTTP/1.1\r\n";
+  request += "Host: " + host.str() + "\r\n";
+  for (const String& header : headers) {
+    request += header.str() + "\r\n";
+  }
+  request += "Content-Length: " + std::to_string(payload.length()) + "\r\n";
+  request += "Connection: close\r\n\r\n";
+  request += payload.str();
+
+  size_t sent = 0;
+  while (sent < request.size()) {
+    ssize_t n = ::send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      close(fd);
+      return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+    sent += n;
+  }
+
+  // Connection: close, so the body ends at EOF when there is no length
+  std::string raw;
+  char buf[4096];
+  bool timed_out = false;
+  for (;;) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n == 0) {
+      break;
+    }
+    if (n < 0) {
+      timed_out = true;
+      break;
+    }
+    raw.append(buf, n);
+  }
+  close(fd);
+
+  size_t header_end = raw.find("\r\n\r\n");
+  if (header_end == std::string::npos || raw.compare(0, 5, "HTTP/") != 0) {
+    return timed_out ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+  }
+
+  int code = atoi(raw.c_str() + raw.find(' ') + 1);
+  std::string body = raw.substr(header_end + 4);
+  std::string head = raw.substr(0, header_end);
+  for (char& c : head) {
+    c = tolower((unsigned char)c);
+  }
+  size_t length_at = head.find("\r\ncontent-length:");
+  if (length_at != std::string::npos) {
+    size_t length = strtoul(head.c_str() + length_at + 17, NULL, 10);
+    if (body.size() < length) {
+      return timed_out ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+    }
+    body.resize(length);
+  }
+
+  response = String(body);
+  return code;
+}
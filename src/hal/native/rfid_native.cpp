@@ -0,0 +1,47 @@
+#include "../../modules/rfid_module.h"
+#include "sim_hal.h"
+#include "../../utils/logger.h"
+#include <deque>
+#include <mutex>
+
+// Scripted taps stand in for the MFRC522: a queued UID is "in the field"
+// until the firmware reads it
+static std::deque<String> rfid_taps;
+static std::mutex rfid_lock;
+static bool rfid_initialized = false;
+
+bool rfid_init() {
+  rfid_initialized = true;
+  Logger::logInfo("RFID: Initialized (simulated reader)");
+  return true;
+}
+
+bool rfid_detect_card() {
+  std::lock_guard<std::mutex> guard(rfid_lock);
+  return rfid_initialized && !rfid_taps.empty();
+}
+
+String rfid_read_uid() {
+  std::lock_guard<std::mutex> guard(rfid_lock);
+  if (rfid_taps.empty()) {
+    return "";
+  }
+  String uid = rfid_taps.front();
+  rfid_taps.pop_front();
+  return uid;
+}
+
+void rfid_stop() {
+}
+
+void sim_rfid_tap(const char* uid) {
+  String normalized(uid);
+  normalized.toUpperCase();
+  std::lock_guard<std::mutex> guard(rfid_lock);
+  rfid_taps.push_back(normalized);
+}
+
+size_t sim_rfid_pending() {
+  std::lock_guard<std::mutex> guard(rfid_lock);
+  return rfid_taps.size();
+}
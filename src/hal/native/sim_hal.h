@@ -0,0 +1,69 @@
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+// Control side of the host peripherals. Firmware code never includes this;
+// the simulator and benchmarks use it to play the part of the outside world.
+
+#include <Arduino.h>
+
+// Serial: firmware log lines go to stdout unless muted
+void sim_serial_set_echo(bool echo);
+
+// Clock: virtual time behind clock_millis(). It only moves when set or
+// advanced, so a day of windows and timeouts passes in no time. millis(),
+// micros() and task delays stay on the host clock.
+void sim_clock_install(unsigned long start_ms);
+void sim_clock_uninstall();
+void sim_clock_set_ms(unsigned long ms);
+void sim_clock_advance_ms(unsigned long ms);
+
+// Pins
+void sim_gpio_set(uint8_t pin, int level);  // Drive a pin from outside, fires attached interrupts
+void sim_gpio_release(uint8_t pin);
+bool sim_gpio_close_switch(uint8_t a, uint8_t b, unsigned long hold_ms);
+
+// Board wiring: PIR output and keypad matrix, same pins as the device
+void sim_motion(bool present);
+bool sim_key_press(int key);  // KEY_* or 0-9, held long enough for one scan
+
+// RFID: queued taps, each presented to the reader once
+void sim_rfid_tap(const char* uid);
+size_t sim_rfid_pending();
+
+// Camera: frames come from binary PGM files, or a synthetic face seeded by
+// the subject name when no file is set
+bool sim_camera_load_frame(const char* path);
+void sim_camera_set_subject(const char* subject);
+void sim_camera_set_capture_ms(unsigned long ms);  // Sensor readout time per frame
+unsigned long sim_camera_frames();
+
+// OLED: text layer of the last frame sent, top to bottom
+String sim_oled_text();
+unsigned long sim_oled_frames();
+void sim_oled_set_echo(bool echo);  // Print every new frame to stdout
+
+// WiFi link and HTTP. With a handler set, requests never leave the process;
+// without one they go to the real host:port over TCP. So do requests to the
+// one host:port set with sim_http_set_direct(), e.g. a hub in another sim.
+typedef int (*SimHttpHandler)(const String& method, const String& path, const String& body, String& response);
+void sim_wifi_set_available(bool available);
+void sim_http_set_handler(SimHttpHandler handler);
+void sim_http_set_direct(const String& host, uint16_t port);
+void sim_http_set_latency_ms(unsigned long ms);
+// Outgoing UDP datagrams dropped at random, for exercising repair
+void sim_udp_set_loss_percent(int percent);
+
+// Device-side routes (status server), served in-process, or to other
+// processes on 127.0.0.1:port once listening
+int sim_web_dispatch(const String& method, const String& path, String& response,
+                     const String& body = String());
+bool sim_web_listen(uint16_t port);
+
+// Filesystem: SPIFFS lives in memory for the life of the process, unless
+// carried from one run to the next in a host file
+void sim_fs_format();
+size_t sim_fs_used_bytes();
+bool sim_fs_save(const char* path);
+bool sim_fs_load(const char* path);
+
+#endif
@@ -0,0 +1,212 @@
+#include "SPIFFS.h"
+#include "sim_hal.h"
+#include <map>
+#include <mutex>
+
+#define SIM_FS_TOTAL_BYTES (1408 * 1024)  // Default 4 MB partition table's SPIFFS size
+
+struct NativeFileNode {
+  std::string data;
+};
+
+SPIFFSFS SPIFFS;
+
+static std::map<std::string, std::shared_ptr<NativeFileNode>> fs_files;
+static std::recursive_mutex fs_lock;
+
+File::File(std::shared_ptr<NativeFileNode> node, const String& path, bool writable, size_t position)
+    : node(node), path(path), position_(position), writable(writable) {}
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  if (!node || !writable) {
+    return 0;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  if (position_ > node->data.size()) {
+    position_ = node->data.size();
+  }
+  node->data.replace(position_, std::min(size, node->data.size() - position_), (const char*)buffer, size);
+  position_ += size;
+  return size;
+}
+
+int File::available() {
+  if (!node) {
+    return 0;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  return position_ < node->data.size() ? node->data.size() - position_ : 0;
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (!node) {
+    return -1;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  return position_ < node->data.size() ? (uint8_t)node->data[position_] : -1;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+  if (!node) {
+    return 0;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  if (position_ >= node->data.size()) {
+    return 0;
+  }
+  size_t count = std::min(size, node->data.size() - position_);
+  memcpy(buffer, node->data.data() + position_, count);
+  position_ += count;
+  return count;
+}
+
+bool File::seek(uint32_t pos) {
+  if (!node) {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  if (pos > node->data.size()) {
+    return false;
+  }
+  position_ = pos;
+  return true;
+}
+
+size_t File::size() const {
+  if (!node) {
+    return 0;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  return node->data.size();
+}
+
+void File::close() {
+  node.reset();
+}
+
+bool SPIFFSFS::begin(bool format_on_fail) {
+  (void)format_on_fail;
+  return true;
+}
+
+bool SPIFFSFS::format() {
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  fs_files.clear();
+  return true;
+}
+
+bool SPIFFSFS::exists(const String& path) {
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  return fs_files.count(path.str()) > 0;
+}
+
+File SPIFFSFS::open(const String& path, const char* mode) {
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  auto it = fs_files.find(path.str());
+
+  if (mode[0] == 'r') {
+    if (it == fs_files.end()) {
+      return File();
+    }
+    return File(it->second, path, mode[1] == '+', 0);
+  }
+
+  // "w" truncates, "a" appends; both create the file
+  if (it == fs_files.end()) {
+    it = fs_files.emplace(path.str(), std::make_shared<NativeFileNode>()).first;
+  }
+  if (mode[0] == 'w') {
+    it->second->data.clear();
+  }
+  return File(it->second, path, true, mode[0] == 'a' ? it->second->data.size() : 0);
+}
+
+bool SPIFFSFS::remove(const String& path) {
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  return fs_files.erase(path.str()) > 0;
+}
+
+bool SPIFFSFS::rename(const String& from, const String& to) {
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  auto it = fs_files.find(from.str());
+  if (it == fs_files.end()) {
+    return false;
+  }
+  std::shared_ptr<NativeFileNode> node = it->second;
+  fs_files.erase(it);
+  fs_files[to.str()] = node;
+  return true;
+}
+
+size_t SPIFFSFS::totalBytes() {
+  return SIM_FS_TOTAL_BYTES;
+}
+
+size_t SPIFFSFS::usedBytes() {
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  size_t used = 0;
+  for (const auto& entry : fs_files) {
+    used += entry.second->data.size();
+  }
+  return used;
+}
+
+void sim_fs_format() {
+  SPIFFS.format();
+}
+
+size_t sim_fs_used_bytes() {
+  return SPIFFS.usedBytes();
+}
+
+// Image: per file, u32 name length, name, u32 data length, data
+bool sim_fs_save(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (f == NULL) {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  for (const auto& entry : fs_files) {
+    uint32_t name_len = entry.first.size();
+    uint32_t data_len = entry.second->data.size();
+    fwrite(&name_len, sizeof(name_len), 1, f);
+    fwrite(entry.first.data(), 1, name_len, f);
+    fwrite(&data_len, sizeof(data_len), 1, f);
+    fwrite(entry.second->data.data(), 1, data_len, f);
+  }
+  return fclose(f) == 0;
+}
+
+bool sim_fs_load(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> guard(fs_lock);
+  fs_files.clear();
+  uint32_t name_len;
+  while (fread(&name_len, sizeof(name_len), 1, f) == 1) {
+    std::string name(name_len, '\0');
+    uint32_t data_len = 0;
+    if (fread(&name[0], 1, name_len, f) != name_len || fread(&data_len, sizeof(data_len), 1, f) != 1) {
+      break;
+    }
+    std::shared_ptr<NativeFileNode> node = std::make_shared<NativeFileNode>();
+    node->data.resize(data_len);
+    if (fread(&node->data[0], 1, data_len, f) != data_len) {
+      break;
+    }
+    fs_files[name] = node;
+  }
+  fclose(f);
+  return true;
+}
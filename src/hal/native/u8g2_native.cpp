@@ -0,0 +1,61 @@
+#include <U8g2lib.h>
+#include <Wire.h>
+#include "sim_hal.h"
+#include <mutex>
+#include <algorithm>
+
+TwoWire Wire;
+
+// Last frame sent to the panel, read by the simulator from another thread
+static std::vector<U8g2TextItem> oled_frame;
+static unsigned long oled_frame_count = 0;
+static bool oled_echo = false;
+static std::mutex oled_lock;
+
+int U8G2_SSD1306_128X64_NONAME_F_HW_I2C::drawStr(int x, int y, const char* s) {
+  buffer.push_back({x, y, String(s)});
+  return getStrWidth(s);
+}
+
+static String frame_text(std::vector<U8g2TextItem> items) {
+  std::stable_sort(items.begin(), items.end(),
+                   [](const U8g2TextItem& a, const U8g2TextItem& b) { return a.y < b.y; });
+  String text;
+  for (size_t i = 0; i < items.size(); i++) {
+    if (i > 0) {
+      text += items[i].y == items[i - 1].y ? " | " : "\n";
+    }
+    text += items[i].text;
+  }
+  return text;
+}
+
+void U8G2_SSD1306_128X64_NONAME_F_HW_I2C::sendBuffer() {
+  String echo;
+  {
+    std::lock_guard<std::mutex> guard(oled_lock);
+    oled_frame = buffer;
+    oled_frame_count++;
+    if (oled_echo) {
+      echo = frame_text(oled_frame);
+    }
+  }
+  if (oled_echo) {
+    Serial.println("[OLED] " + echo);
+  }
+}
+
+String sim_oled_text() {
+  std::lock_guard<std::mutex> guard(oled_lock);
+  return frame_text(oled_frame);
+}
+
+unsigned long sim_oled_frames() {
+  std::lock_guard<std::mutex> guard(oled_lock);
+  return oled_frame_count;
+}
+
+void sim_oled_set_echo(bool echo) {
+  std::lock_guard<std::mutex> guard(oled_lock);
+  oled_echo = echo;
+}
@@ -0,0 +1,146 @@
+#include <WiFiUdp.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "sim_hal.h"
+
+static volatile int udp_loss_percent = 0;
+
+static in_addr to_in_addr(IPAddress ip) {
+  in_addr addr;
+  uint8_t octets[4] = {ip[0], ip[1], ip[2], ip[3]};
+  memcpy(&addr.s_addr, octets, 4);
+  return addr;
+}
+
+static bool link_up() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress group_ip, uint16_t port) {
+  stop();
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    return 0;
+  }
+
+  // Every simulated terminal binds the same port
+  int on = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family = AF_INET;
+  local.sin_port = htons(port);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  ip_mreq membership;
+  membership.imr_multiaddr = to_in_addr(group_ip);
+  membership.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+  in_addr loopback;
+  loopback.s_addr = htonl(INADDR_LOOPBACK);
+  unsigned char loop = 1;
+
+  if (bind(sock, (sockaddr*)&local, sizeof(local)) < 0 ||
+      setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0 ||
+      setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) < 0 ||
+      setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+    stop();
+    return 0;
+  }
+
+  group = group_ip;
+  group_port = port;
+  return 1;
+}
+
+void WiFiUDP::stop() {
+  if (sock >= 0) {
+    close(sock);
+  }
+  sock = -1;
+  rx_len = rx_pos = 0;
+  tx_len = 0;
+}
+
+int WiFiUDP::beginMulticastPacket() {
+  return beginPacket(group, group_port);
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+  if (sock < 0) {
+    return 0;
+  }
+  tx_to = ip;
+  tx_port = port;
+  tx_len = 0;
+  return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size) {
+  size_t n = min(size, sizeof(tx_buffer) - tx_len);
+  memcpy(tx_buffer + tx_len, buffer, n);
+  tx_len += n;
+  return n;
+}
+
+int WiFiUDP::endPacket() {
+  if (sock < 0 || !link_up()) {
+    return 0;
+  }
+  size_t len = tx_len;
+  tx_len = 0;
+
+  // A lossy link drops the datagram after the sender let go of it
+  if (udp_loss_percent > 0 && random(100) < udp_loss_percent) {
+    return 1;
+  }
+
+  sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons(tx_port);
+  to.sin_addr = to_in_addr(tx_to);
+  return sendto(sock, tx_buffer, len, 0, (sockaddr*)&to, sizeof(to)) == (ssize_t)len ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket() {
+  rx_len = rx_pos = 0;
+  if (sock < 0) {
+    return 0;
+  }
+
+  for (;;) {
+    sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n = recvfrom(sock, rx_buffer, sizeof(rx_buffer), MSG_DONTWAIT, (sockaddr*)&from, &from_len);
+    if (n <= 0) {
+      return 0;
+    }
+    // With the link down the radio hears nothing
+    if (!link_up()) {
+      continue;
+    }
+    uint8_t octets[4];
+    memcpy(octets, &from.sin_addr.s_addr, 4);
+    rx_from = IPAddress(octets[0], octets[1], octets[2], octets[3]);
+    rx_len = n;
+    return rx_len;
+  }
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t len) {
+  int n = min((int)len, available());
+  if (n <= 0) {
+    return 0;
+  }
+  memcpy(buffer, rx_buffer + rx_pos, n);
+  rx_pos += n;
+  return n;
+}
+
+void sim_udp_set_loss_percent(int percent) {
+  udp_loss_percent = constrain(percent, 0, 100);
+}
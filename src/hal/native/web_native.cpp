@@ -0,0 +1,147 @@
+#include <ESPAsyncWebServer.h>
+#include "sim_hal.h"
+#include "../../services/status_server.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define SIM_WEB_MAX_REQUEST (64 * 1024)
+
+// Handlers run one at a time, as on the single async TCP task
+static std::mutex web_lock;
+
+static String url_decode(const String& text) {
+  std::string out;
+  for (size_t i = 0; i < text.length(); i++) {
+    char c = text[i];
+    if (c == '+') {
+      out += ' ';
+    } else if (c == '%' && i + 2 < text.length()) {
+      out += (char)strtol(text.substring(i + 1, i + 3).c_str(), NULL, 16);
+      i += 2;
+    } else {
+      out += c;
+    }
+  }
+  return String(out);
+}
+
+int AsyncWebServer::dispatch(WebRequestMethod method, const String& url, const String& body,
+                             String& response) {
+  int question = url.indexOf('?');
+  String path = question >= 0 ? url.substring(0, question) : url;
+
+  for (const Route& route : routes) {
+    if (route.uri != path || (route.method & method) == 0) {
+      continue;
+    }
+    AsyncWebServerRequest request(method, path);
+    String query = question >= 0 ? url.substring(question + 1) : String();
+    while (query.length() > 0) {
+      int amp = query.indexOf('&');
+      String pair = amp >= 0 ? query.substring(0, amp) : query;
+      query = amp >= 0 ? query.substring(amp + 1) : String();
+      int eq = pair.indexOf('=');
+      request.params.push_back(AsyncWebParameter(url_decode(eq >= 0 ? pair.substring(0, eq) : pair),
+                                                 url_decode(eq >= 0 ? pair.substring(eq + 1) : String())));
+    }
+    if (route.body && body.length() > 0) {
+      route.body(&request, (uint8_t*)body.c_str(), body.length(), 0, body.length());
+    }
+    route.handler(&request);
+    response = request.body;
+    return request.code;
+  }
+  response = "";
+  return 404;
+}
+
+int sim_web_dispatch(const String& method, const String& path, String& response, const String& body) {
+  AsyncWebServer* server = status_server_get();
+  if (server == NULL) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> guard(web_lock);
+  return server->dispatch(method == "POST" ? HTTP_POST : HTTP_GET, path, body, response);
+}
+
+// One request per connection, answered with Connection: close
+static void serve_connection(int fd) {
+  std::string raw;
+  char buf[4096];
+  size_t header_end = std::string::npos;
+  size_t content_length = 0;
+  while (raw.size() < SIM_WEB_MAX_REQUEST) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      break;
+    }
+    raw.append(buf, n);
+    if (header_end == std::string::npos) {
+      header_end = raw.find("\r\n\r\n");
+      if (header_end != std::string::npos) {
+        std::string head = raw.substr(0, header_end);
+        for (char& c : head) {
+          c = tolower((unsigned char)c);
+        }
+        size_t at = head.find("\r\ncontent-length:");
+        content_length = at != std::string::npos ? strtoul(head.c_str() + at + 17, NULL, 10) : 0;
+      }
+    }
+    if (header_end != std::string::npos && raw.size() >= header_end + 4 + content_length) {
+      break;
+    }
+  }
+
+  int code = 400;
+  String response;
+  size_t first_space = raw.find(' ');
+  size_t second_space = first_space != std::string::npos ? raw.find(' ', first_space + 1) : std::string::npos;
+  if (header_end != std::string::npos && second_space != std::string::npos) {
+    String method(raw.substr(0, first_space));
+    String target(raw.substr(first_space + 1, second_space - first_space - 1));
+    String body(raw.substr(header_end + 4, content_length));
+    code = sim_web_dispatch(method, target, response, body);
+    if (code < 0) {
+      code = 503;
+    }
+  }
+
+  std::string reply = "HTTP/1.1 " + std::to_string(code) + " -\r\n"
+                      "Content-Type: application/json\r\n"
+                      "Content-Length: " + std::to_string(response.length()) + "\r\n"
+                      "Connection: close\r\n\r\n" + response.str();
+  send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+  close(fd);
+}
+
+bool sim_web_listen(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+    close(fd);
+    return false;
+  }
+
+  std::thread([fd]() {
+    for (;;) {
+      int client = accept(fd, NULL, NULL);
+      if (client >= 0) {
+        serve_connection(client);
+      }
+    }
+  }).detach();
+  return true;
+}
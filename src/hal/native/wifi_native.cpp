@@ -0,0 +1,40 @@
+#include <WiFi.h>
+#include "sim_hal.h"
+
+#define SIM_WIFI_RSSI -55
+
+WiFiClass WiFi;
+
+static volatile bool wifi_available = true;  // Access point in range
+static volatile bool wifi_joined = false;    // Station asked to connect
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+  (void)password;
+  wifi_joined = ssid != NULL && ssid[0] != '\0';
+  return status();
+}
+
+bool WiFiClass::disconnect(bool wifi_off) {
+  (void)wifi_off;
+  wifi_joined = false;
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  if (!wifi_joined) {
+    return WL_DISCONNECTED;
+  }
+  return wifi_available ? WL_CONNECTED : WL_CONNECTION_LOST;
+}
+
+int8_t WiFiClass::RSSI() {
+  return status() == WL_CONNECTED ? SIM_WIFI_RSSI : 0;
+}
+
+IPAddress WiFiClass::localIP() {
+  return status() == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+void sim_wifi_set_available(bool available) {
+  wifi_available = available;
+}
@@ -0,0 +1,297 @@
+// Load generator for the device API: many simulated terminals, each a
+// forked process running the host build of api_client against a backend
+// (normally tools/mock_backend.py).
+//
+//   loadgen [--backend host:port] [--terminals N] [--duration S]
+//           [--image-bytes B] [--sync-every K] [--sync-batch M] [--think-ms T]
+//
+// A terminal loops: face-verify with a B-byte image, transaction log, and
+// every K serves a balance lookup and an M-record offline sync batch. Each
+// call is timed end to end, api_call's retries included. Against the mock
+// backend the report also shows how many requests retries added.
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../hal/native/sim_hal.h"
+#include "../config/data_types.h"
+#include "../services/api_client.h"
+#include "../services/wifi_manager.h"
+#include "../utils/helpers.h"
+
+enum LoadEndpoint {
+  LOAD_VERIFY,
+  LOAD_LOG,
+  LOAD_BALANCE,
+  LOAD_SYNC,
+  LOAD_ENDPOINT_COUNT
+};
+
+// Also the keys of the mock backend's /mock/stats
+static const char* LOAD_ENDPOINT_NAMES[] = {"face-verify", "log", "balance", "sync-batch"};
+
+struct LoadSample {
+  uint8_t endpoint;
+  uint8_t ok;
+  uint32_t latency_us;
+};
+
+struct LoadOptions {
+  String host;
+  int port;
+  int terminals;
+  unsigned long duration_ms;
+  size_t image_bytes;
+  int sync_every;
+  int sync_batch;
+  unsigned long think_ms;
+};
+
+static Transaction load_transaction(int terminal, unsigned long serial, const FaceVerificationResult& fvr) {
+  Transaction t;
+  t.id = "TXN_" + String(terminal) + "_" + String(serial);
+  t.timestamp = Helpers::getCurrentTimestamp();
+  t.student_id = fvr.student_id;
+  t.student_name = fvr.student_name;
+  t.rfid_uid = fvr.student_id.substring(4);
+  t.status = "approved";
+  t.balance_before = fvr.balance;
+  t.balance_after = fvr.balance - 5.0;
+  t.reason = "Auto-approved - matched credentials";
+  t.fraud_alert = false;
+  t.face_confidence = fvr.confidence;
+  t.synced = false;
+  t.offline_mode = true;
+  return t;
+}
+
+static void record(std::vector<LoadSample>& samples, LoadEndpoint endpoint, bool ok, unsigned long start_us) {
+  samples.push_back({(uint8_t)endpoint, (uint8_t)ok, (uint32_t)(micros() - start_us)});
+}
+
+// One terminal: runs in its own process, so api_client's globals are its own
+static void run_terminal(int terminal, const LoadOptions& options, int out_fd) {
+  sim_serial_set_echo(false);
+  randomSeed(terminal + 1);
+  wifi_init("loadgen", "loadgen");
+  api_set_server(options.host, options.port);
+
+  char device[24];
+  snprintf(device, sizeof(device), "loadgen_%02d", terminal);
+  api_set_device_id(device);
+
+  std::vector<uint8_t> image(options.image_bytes);
+  for (size_t i = 0; i < image.size(); i++) {
+    image[i] = (uint8_t)random(0, 256);
+  }
+  String face = Helpers::base64Encode(image.data(), image.size());
+
+  std::vector<LoadSample> samples;
+  std::vector<Transaction> unsynced;
+  unsigned long serial = 0;
+  unsigned long deadline = millis() + options.duration_ms;
+  while ((long)(millis() - deadline) < 0) {
+    char uid[16];
+    snprintf(uid, sizeof(uid), "%02X%06lX", terminal, serial % 500);
+    serial++;
+
+    unsigned long start = micros();
+    String response = api_face_verify(uid, face);
+    FaceVerificationResult fvr = FaceVerificationResult::fromJson(response);
+    record(samples, LOAD_VERIFY, fvr.success, start);
+    if (fvr.success) {
+      Transaction t = load_transaction(terminal, serial, fvr);
+      start = micros();
+      bool logged = api_log_transaction(t);
+      record(samples, LOAD_LOG, logged, start);
+      unsynced.push_back(t);
+    }
+
+    if (serial % options.sync_every == 0) {
+      start = micros();
+      String balance = api_get_balance(fvr.student_id);
+      record(samples, LOAD_BALANCE, balance.indexOf("\"success\"") >= 0, start);
+
+      // Sync batches are padded with earlier records up to the configured size
+      std::vector<Transaction> batch;
+      for (int i = 0; i < options.sync_batch && !unsynced.empty(); i++) {
+        batch.push_back(unsynced[(unsynced.size() - 1 - i % unsynced.size())]);
+      }
+      if (!batch.empty()) {
+        start = micros();
+        std::vector<String> acked;
+        bool synced = api_sync_offline_transactions(batch, acked) && acked.size() == batch.size();
+        record(samples, LOAD_SYNC, synced, start);
+        if (synced) {
+          unsynced.clear();
+        }
+      }
+    }
+
+    if (options.think_ms > 0) {
+      delay(options.think_ms);
+    }
+  }
+
+  // Written once at the end so a full pipe never stalls the load
+  const uint8_t* data = (const uint8_t*)samples.data();
+  size_t left = samples.size() * sizeof(LoadSample);
+  while (left > 0) {
+    ssize_t n = write(out_fd, data, left);
+    if (n <= 0) {
+      break;
+    }
+    data += n;
+    left -= n;
+  }
+  close(out_fd);
+}
+
+static double percentile_ms(const std::vector<uint32_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t index = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+  return sorted[index] / 1000.0;
+}
+
+// Server-side request counts, when the backend is tools/mock_backend.py
+static bool mock_request_counts(const LoadOptions& options, unsigned long counts[LOAD_ENDPOINT_COUNT]) {
+  HTTPClient http;
+  http.begin("http://" + options.host + ":" + String(options.port) + "/mock/stats");
+  int code = http.GET();
+  String body = http.getString();
+  http.end();
+  if (code != 200) {
+    return false;
+  }
+
+  JsonDocument doc;
+  if (deserializeJson(doc, body) != DeserializationError::Ok) {
+    return false;
+  }
+  for (int i = 0; i < LOAD_ENDPOINT_COUNT; i++) {
+    counts[i] = doc["endpoints"][LOAD_ENDPOINT_NAMES[i]]["requests"] | 0;
+  }
+  return true;
+}
+
+static void print_report(const LoadOptions& options, const std::vector<LoadSample>& samples,
+                         unsigned long before[LOAD_ENDPOINT_COUNT], bool have_mock) {
+  unsigned long after[LOAD_ENDPOINT_COUNT] = {0};
+  have_mock = have_mock && mock_request_counts(options, after);
+  double seconds = options.duration_ms / 1000.0;
+
+  printf("\n==== Load report: %d terminals, %.0f s, %u-byte images ====\n", options.terminals, seconds,
+         (unsigned)options.image_bytes);
+  printf("%-12s %8s %8s %8s %9s %9s %9s %9s %9s\n", "endpoint", "calls", "failed", "calls/s",
+         "p50 ms", "p95 ms", "p99 ms", "max ms", "retries");
+
+  unsigned long synced_records = 0;
+  for (int e = 0; e < LOAD_ENDPOINT_COUNT; e++) {
+    std::vector<uint32_t> latencies;
+    unsigned long failed = 0;
+    for (const LoadSample& s : samples) {
+      if (s.endpoint != e) {
+        continue;
+      }
+      latencies.push_back(s.latency_us);
+      if (!s.ok) {
+        failed++;
+      } else if (e == LOAD_SYNC) {
+        synced_records += options.sync_batch;
+      }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    String retries = "-";
+    if (have_mock) {
+      long extra = (long)(after[e] - before[e]) - (long)latencies.size();
+      retries = String(extra > 0 ? extra : 0);
+    }
+    printf("%-12s %8u %8lu %8.1f %9.1f %9.1f %9.1f %9.1f %9s\n", LOAD_ENDPOINT_NAMES[e],
+           (unsigned)latencies.size(), failed, latencies.size() / seconds, percentile_ms(latencies, 0.50),
+           percentile_ms(latencies, 0.95), percentile_ms(latencies, 0.99),
+           latencies.empty() ? 0.0 : latencies.back() / 1000.0, retries.c_str());
+  }
+  printf("\nSync throughput:     %.1f records/s acknowledged\n", synced_records / seconds);
+  printf("Total:               %.1f calls/s\n", samples.size() / seconds);
+}
+
+int main(int argc, char** argv) {
+  LoadOptions options = {"127.0.0.1", 5000, 8, 10000, 25 * 1024, 10, 20, 0};
+  for (int i = 1; i < argc; i++) {
+    String arg(argv[i]);
+    if (arg == "--backend" && i + 1 < argc) {
+      String backend = argv[++i];
+      int colon = backend.indexOf(':');
+      options.host = colon >= 0 ? backend.substring(0, colon) : backend;
+      options.port = colon >= 0 ? backend.substring(colon + 1).toInt() : 80;
+    } else if (arg == "--terminals" && i + 1 < argc) {
+      options.terminals = atoi(argv[++i]);
+    } else if (arg == "--duration" && i + 1 < argc) {
+      options.duration_ms = strtoul(argv[++i], NULL, 10) * 1000;
+    } else if (arg == "--image-bytes" && i + 1 < argc) {
+      options.image_bytes = strtoul(argv[++i], NULL, 10);
+    } else if (arg == "--sync-every" && i + 1 < argc) {
+      options.sync_every = std::max(1, atoi(argv[++i]));
+    } else if (arg == "--sync-batch" && i + 1 < argc) {
+      options.sync_batch = atoi(argv[++i]);
+    } else if (arg == "--think-ms" && i + 1 < argc) {
+      options.think_ms = strtoul(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr,
+              "usage: %s [--backend host:port] [--terminals N] [--duration S]\n"
+              "          [--image-bytes B] [--sync-every K] [--sync-batch M] [--think-ms T]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  unsigned long before[LOAD_ENDPOINT_COUNT] = {0};
+  bool have_mock = mock_request_counts(options, before);
+
+  std::vector<int> pipes;
+  std::vector<pid_t> children;
+  for (int t = 0; t < options.terminals; t++) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      perror("loadgen: pipe");
+      return 1;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      run_terminal(t, options, fds[1]);
+      _exit(0);
+    }
+    close(fds[1]);
+    pipes.push_back(fds[0]);
+    children.push_back(pid);
+  }
+
+  // Children write only when done; read every pipe to EOF
+  std::vector<LoadSample> samples;
+  for (int fd : pipes) {
+    std::vector<uint8_t> raw;
+    uint8_t buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      raw.insert(raw.end(), buf, buf + n);
+    }
+    close(fd);
+    const LoadSample* s = (const LoadSample*)raw.data();
+    samples.insert(samples.end(), s, s + raw.size() / sizeof(LoadSample));
+  }
+  for (pid_t pid : children) {
+    waitpid(pid, NULL, 0);
+  }
+
+  print_report(options, samples, before, have_mock);
+  return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef ESP_CAM_CONFIG_H
+#define ESP_CAM_CONFIG_H
+
+#include <stdint.h>
+
+// Camera pipeline constants shared by esp_cam_module.cpp and its host
+// counterpart (hal/native/esp_cam_native.cpp), so the simulator crops,
+// pre-captures and steps profiles exactly as the device does.
+
+// Face crop sent for verification instead of the whole frame; the largest
+// crop side, profiles may send a smaller one
+#define FACE_CROP_SIZE 160
+#define FACE_CROP_PADDING 0.25
+
+// Capture profiles from best quality (0) to smallest upload. The upload is
+// the face crop, so profiles trade crop side and JPEG quality; the frame
+// stays at the init size, where the face box is large enough for the local
+// descriptor and the crop. sensor_quality is the OV2640 JPEG scale (0-63,
+// lower is better) of the frame, sent only when no face crop could be made.
+// crop_quality is fmt2jpg (1-100). payload_pct is the crop's typical size
+// relative to profile 0, used until the tuner has measured the profile.
+struct CaptureProfile {
+  int sensor_quality;
+  uint16_t crop_size;
+  int crop_quality;
+  int payload_pct;
+};
+
+const CaptureProfile CAPTURE_PROFILES[] = {
+  {10, 160, 85, 100},
+  {12, 160, 70, 70},
+  {14, 128, 60, 40},
+  {16, 112, 50, 25}
+};
+const int CAPTURE_PROFILE_COUNT = sizeof(CAPTURE_PROFILES) / sizeof(CAPTURE_PROFILES[0]);
+
+// Pre-capture ring: frames grabbed between motion and card tap (PSRAM only)
+#define PRECAPTURE_SLOTS 3
+#define PRECAPTURE_SLOT_BYTES (96 * 1024)
+#define PRECAPTURE_INTERVAL_MS 150
+#define PRECAPTURE_MAX_AGE_MS 1500
+
+#endif
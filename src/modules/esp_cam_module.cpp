@@ -1,7 +1,15 @@
 #include "esp_cam_module.h"
+#include "esp_cam_config.h"
 #include "esp_camera.h"
+#include "img_converters.h"
+#include "driver/ledc.h"
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include <time.h>
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 #include "../utils/helpers.h"
+#include "../services/frame_quality.h"
 
 #define PWDN_GPIO_NUM     32
 #define RESET_GPIO_NUM    -1
@@ -20,8 +28,78 @@
 #define HREF_GPIO_NUM     23
 #define PCLK_GPIO_NUM     22
 
+// Exposure presets per time-of-day bucket (3 h each), persisted across reboots
+#define EXPOSURE_BUCKETS 8
+#define EXPOSURE_FILE "/exposure.json"
+#define AEC_VALUE_MAX 1200
+#define AGC_GAIN_MAX 30
+
+// Quick AE loop on QQVGA preview frames
+#define QUICK_AE_TARGET 128
+#define QUICK_AE_TOLERANCE 20
+#define QUICK_AE_MAX_STEPS 4
+
+struct ExposurePreset {
+  uint16_t aec_value;
+  uint8_t agc_gain;
+  uint8_t wb_mode;
+  bool valid;
+};
+
+// Pre-capture ring slot (PSRAM only)
+struct PrecaptureSlot {
+  uint8_t* buf;
+  size_t len;
+  uint16_t width;
+  uint16_t height;
+  float score;
+  unsigned long captured_at;
+  bool valid;
+};
+
 bool cam_initialized = false;
+bool cam_sleeping = false;
 camera_fb_t* fb = nullptr;
+int capture_profile = 0;
+
+// Sensor register state captured before power-down, replayed on wake
+camera_status_t cached_sensor_status;
+unsigned long wake_started_us = 0;
+bool wake_pending = false;
+CameraWakeStats wake_stats = {0, 0, 0, 0, 0};
+
+ExposurePreset exposure_presets[EXPOSURE_BUCKETS];
+bool exposure_presets_loaded = false;
+bool quick_ae_enabled = true;
+
+static bool decode_luma(const uint8_t* buf, size_t len, uint16_t width, uint16_t height, LumaImage& out);
+
+// Current frame: either the live camera buffer or a pre-captured slot
+const uint8_t* frame_buf = nullptr;
+size_t frame_len = 0;
+uint16_t frame_width = 0;
+uint16_t frame_height = 0;
+
+// 1/8-scale decode of the current frame, shared by on-device analysis
+LumaImage frame_luma;
+bool frame_luma_valid = false;
+uint8_t luma_decode_buf[LUMA_MAX_WIDTH * LUMA_MAX_HEIGHT * 2];
+
+// Full-frame RGB888 decode and resampled crop (PSRAM), re-encoded crop JPEG (heap)
+uint8_t* crop_rgb_buf = nullptr;
+size_t crop_rgb_capacity = 0;
+uint8_t* crop_scaled_buf = nullptr;
+uint8_t* crop_jpeg = nullptr;
+
+// Scratch luma for ranking burst candidates against the current best
+LumaImage candidate_luma;
+CameraBurstStats burst_stats = {0, 0, 0, 0};
+
+PrecaptureSlot precapture_ring[PRECAPTURE_SLOTS];
+bool precapture_allocated = false;
+bool precapture_active = false;
+int precapture_next = 0;
+unsigned long precapture_last_grab = 0;
 
 bool esp_cam_init() {
   if (cam_initialized) {
@@ -69,21 +147,364 @@ bool esp_cam_init() {
   }
   
   cam_initialized = true;
+  esp_cam_apply_profile(capture_profile);
+  esp_cam_preload_exposure();
   Logger::logInfo("ESP-CAM: Initialized successfully");
   return true;
 }
 
-bool esp_cam_capture_frame() {
+static bool restore_sensor_settings(sensor_t* sensor, const camera_status_t& st) {
+  int failures = 0;
+  failures += sensor->set_framesize(sensor, st.framesize) != 0;
+  failures += sensor->set_quality(sensor, st.quality) != 0;
+  failures += sensor->set_brightness(sensor, st.brightness) != 0;
+  failures += sensor->set_contrast(sensor, st.contrast) != 0;
+  failures += sensor->set_saturation(sensor, st.saturation) != 0;
+  failures += sensor->set_special_effect(sensor, st.special_effect) != 0;
+  failures += sensor->set_whitebal(sensor, st.awb) != 0;
+  failures += sensor->set_awb_gain(sensor, st.awb_gain) != 0;
+  failures += sensor->set_wb_mode(sensor, st.wb_mode) != 0;
+  failures += sensor->set_exposure_ctrl(sensor, st.aec) != 0;
+  failures += sensor->set_aec2(sensor, st.aec2) != 0;
+  failures += sensor->set_ae_level(sensor, st.ae_level) != 0;
+  failures += sensor->set_aec_value(sensor, st.aec_value) != 0;
+  failures += sensor->set_gain_ctrl(sensor, st.agc) != 0;
+  failures += sensor->set_agc_gain(sensor, st.agc_gain) != 0;
+  failures += sensor->set_gainceiling(sensor, (gainceiling_t)st.gainceiling) != 0;
+  failures += sensor->set_bpc(sensor, st.bpc) != 0;
+  failures += sensor->set_wpc(sensor, st.wpc) != 0;
+  failures += sensor->set_raw_gma(sensor, st.raw_gma) != 0;
+  failures += sensor->set_lenc(sensor, st.lenc) != 0;
+  failures += sensor->set_hmirror(sensor, st.hmirror) != 0;
+  failures += sensor->set_vflip(sensor, st.vflip) != 0;
+  failures += sensor->set_dcw(sensor, st.dcw) != 0;
+  return failures == 0;
+}
+
+void esp_cam_sleep() {
+  if (!cam_initialized || cam_sleeping) {
+    return;
+  }
+  
+  esp_cam_precapture_stop();
+  esp_cam_cleanup();
+  
+  sensor_t* sensor = esp_camera_sensor_get();
+  if (sensor != nullptr) {
+    cached_sensor_status = sensor->status;
+  }
+  
+  // Sensor into standby first, then stop the 20 MHz XCLK
+  digitalWrite(PWDN_GPIO_NUM, HIGH);
+  ledc_timer_pause(LEDC_HIGH_SPEED_MODE, LEDC_TIMER_0);
+  
+  cam_sleeping = true;
+  wake_pending = false;
+  Logger::logInfo("Camera: Powered down");
+}
+
+bool esp_cam_wake() {
+  if (!cam_initialized || !cam_sleeping) {
+    return cam_initialized;
+  }
+  
+  wake_started_us = micros();
+  
+  ledc_timer_resume(LEDC_HIGH_SPEED_MODE, LEDC_TIMER_0);
+  digitalWrite(PWDN_GPIO_NUM, LOW);
+  delay(2); // Sensor needs a few XCLK cycles after PWDN release
+  cam_sleeping = false;
+  
+  sensor_t* sensor = esp_camera_sensor_get();
+  bool restored = sensor != nullptr && restore_sensor_settings(sensor, cached_sensor_status);
+  
+  if (!restored) {
+    // Warm restore failed, fall back to a full driver re-init
+    Logger::logError("Camera: Warm restore failed, re-initializing");
+    esp_camera_deinit();
+    cam_initialized = false;
+    if (!esp_cam_init()) {
+      return false;
+    }
+    wake_stats.full_reinits++;
+  }
+  
+  wake_pending = true;
+  
+  // Start from the exposure that worked at this time of day instead of waiting for AE
+  esp_cam_preload_exposure();
+  if (quick_ae_enabled) {
+    esp_cam_quick_ae();
+  }
+  
+  wake_stats.restore_us = micros() - wake_started_us;
+  return true;
+}
+
+static int exposure_bucket() {
+  // Wall clock once NTP has set it, otherwise uptime hours (only consistent within a boot)
+  time_t now = time(nullptr);
+  int hour;
+  if (now > 1600000000) {
+    struct tm local;
+    localtime_r(&now, &local);
+    hour = local.tm_hour;
+  } else {
+    hour = (Helpers::getCurrentTimestamp() / 3600) % 24;
+  }
+  return hour / (24 / EXPOSURE_BUCKETS);
+}
+
+static void load_exposure_presets() {
+  exposure_presets_loaded = true;
+  for (int i = 0; i < EXPOSURE_BUCKETS; i++) {
+    exposure_presets[i].valid = false;
+  }
+  
+  if (!SPIFFS.exists(EXPOSURE_FILE)) {
+    return;
+  }
+  
+  File file = SPIFFS.open(EXPOSURE_FILE, "r");
+  if (!file) {
+    return;
+  }
+  String content = file.readString();
+  file.close();
+  
+  JsonDocument doc;
+  if (deserializeJson(doc, content) != DeserializationError::Ok) {
+    return;
+  }
+  
+  JsonArray arr = doc["presets"].as<JsonArray>();
+  for (JsonObject obj : arr) {
+    int bucket = obj["bucket"] | -1;
+    if (bucket < 0 || bucket >= EXPOSURE_BUCKETS) {
+      continue;
+    }
+    exposure_presets[bucket].aec_value = obj["aec_value"] | 300;
+    exposure_presets[bucket].agc_gain = obj["agc_gain"] | 0;
+    exposure_presets[bucket].wb_mode = obj["wb_mode"] | 0;
+    exposure_presets[bucket].valid = true;
+  }
+}
+
+static void save_exposure_presets() {
+  JsonDocument doc;
+  JsonArray arr = doc["presets"].to<JsonArray>();
+  for (int i = 0; i < EXPOSURE_BUCKETS; i++) {
+    if (!exposure_presets[i].valid) {
+      continue;
+    }
+    JsonObject obj = arr.add<JsonObject>();
+    obj["bucket"] = i;
+    obj["aec_value"] = exposure_presets[i].aec_value;
+    obj["agc_gain"] = exposure_presets[i].agc_gain;
+    obj["wb_mode"] = exposure_presets[i].wb_mode;
+  }
+  
+  File file = SPIFFS.open(EXPOSURE_FILE, "w");
+  if (file) {
+    serializeJson(doc, file);
+    file.close();
+  }
+}
+
+// Manual values are written first, then auto control resumes from them
+static void apply_exposure(sensor_t* sensor, uint16_t aec_value, uint8_t agc_gain, bool resume_auto) {
+  sensor->set_exposure_ctrl(sensor, 0);
+  sensor->set_gain_ctrl(sensor, 0);
+  sensor->set_aec_value(sensor, aec_value);
+  sensor->set_agc_gain(sensor, agc_gain);
+  if (resume_auto) {
+    sensor->set_exposure_ctrl(sensor, 1);
+    sensor->set_gain_ctrl(sensor, 1);
+  }
+}
+
+void esp_cam_preload_exposure() {
+  sensor_t* sensor = esp_camera_sensor_get();
+  if (!cam_initialized || sensor == nullptr) {
+    return;
+  }
+  
+  if (!exposure_presets_loaded) {
+    load_exposure_presets();
+  }
+  
+  const ExposurePreset& preset = exposure_presets[exposure_bucket()];
+  if (!preset.valid) {
+    return;
+  }
+  
+  // OV2640 white balance is only exposed as presets; auto (0) keeps AWB running
+  sensor->set_wb_mode(sensor, preset.wb_mode);
+  apply_exposure(sensor, preset.aec_value, preset.agc_gain, true);
+}
+
+void esp_cam_set_quick_ae(bool enabled) {
+  quick_ae_enabled = enabled;
+}
+
+static int preview_brightness() {
+  // Drop the frame exposed with the previous settings, measure the next one
+  camera_fb_t* stale = esp_camera_fb_get();
+  if (stale) {
+    esp_camera_fb_return(stale);
+  }
+  
+  camera_fb_t* preview = esp_camera_fb_get();
+  if (!preview) {
+    return -1;
+  }
+  
+  int brightness = -1;
+  if (decode_luma(preview->buf, preview->len, preview->width, preview->height, candidate_luma)) {
+    brightness = image_mean_brightness(candidate_luma);
+  }
+  esp_camera_fb_return(preview);
+  return brightness;
+}
+
+bool esp_cam_quick_ae() {
+  sensor_t* sensor = esp_camera_sensor_get();
+  if (!cam_initialized || cam_sleeping || sensor == nullptr) {
+    return false;
+  }
+  
+  if (!exposure_presets_loaded) {
+    load_exposure_presets();
+  }
+  
+  int bucket = exposure_bucket();
+  ExposurePreset& preset = exposure_presets[bucket];
+  int aec = preset.valid ? preset.aec_value : sensor->status.aec_value;
+  int gain = preset.valid ? preset.agc_gain : sensor->status.agc_gain;
+  if (aec <= 0) {
+    aec = 300;
+  }
+  
+  framesize_t frame_size = sensor->status.framesize;
+  sensor->set_framesize(sensor, FRAMESIZE_QQVGA);
+  
+  bool converged = false;
+  int steps = 0;
+  for (; steps < QUICK_AE_MAX_STEPS; steps++) {
+    apply_exposure(sensor, aec, gain, false);
+    int brightness = preview_brightness();
+    if (brightness < 0) {
+      break;
+    }
+    if (abs(brightness - QUICK_AE_TARGET) <= QUICK_AE_TOLERANCE) {
+      converged = true;
+      break;
+    }
+    
+    // Exposure scales roughly linearly with brightness; gain only once exposure saturates
+    float scale = (float)QUICK_AE_TARGET / (brightness > 4 ? brightness : 4);
+    scale = constrain(scale, 0.25, 4.0);
+    int next_aec = (int)(aec * scale);
+    if (next_aec > AEC_VALUE_MAX) {
+      aec = AEC_VALUE_MAX;
+      gain = min(gain + 4, AGC_GAIN_MAX);
+    } else if (scale < 1.0 && gain > 0) {
+      gain = max(gain - 4, 0);
+    } else {
+      aec = max(next_aec, 1);
+    }
+  }
+  
+  // Back to the capture profile, auto exposure takes over from the converged point
+  sensor->set_framesize(sensor, frame_size);
+  apply_exposure(sensor, aec, gain, true);
+  
+  if (converged) {
+    bool changed = !preset.valid || abs((int)preset.aec_value - aec) > aec / 10 || preset.agc_gain != gain;
+    preset.aec_value = aec;
+    preset.agc_gain = gain;
+    preset.wb_mode = sensor->status.wb_mode;
+    preset.valid = true;
+    if (changed) {
+      save_exposure_presets();
+    }
+  }
+  
+  Logger::logInfo("Camera: Quick AE " + String(converged ? "converged" : "gave up") + " after " +
+                  String(steps + 1) + " steps (aec " + String(aec) + ", gain " + String(gain) + ")");
+  return converged;
+}
+
+bool esp_cam_is_sleeping() {
+  return cam_sleeping;
+}
+
+// Called with every decoded frame; the first correctly exposed one after a wake ends the measurement
+static void note_wake_frame(const LumaImage& luma) {
+  if (!wake_pending) {
+    return;
+  }
+  
+  uint8_t brightness = image_mean_brightness(luma);
+  if (brightness < QUALITY_MIN_BRIGHTNESS || brightness > QUALITY_MAX_BRIGHTNESS) {
+    return;
+  }
+  wake_pending = false;
+  
+  unsigned long latency_us = micros() - wake_started_us;
+  wake_stats.wakes++;
+  wake_stats.last_usable_us = latency_us;
+  wake_stats.total_usable_us += latency_us;
+  
+  Logger::logInfo("Camera: Wake to usable frame " + String(latency_us / 1000) + " ms (restore " +
+                  String(wake_stats.restore_us / 1000) + " ms)");
+}
+
+CameraWakeStats esp_cam_get_wake_stats() {
+  return wake_stats;
+}
+
+bool esp_cam_apply_profile(int level) {
+  if (level < 0 || level >= CAPTURE_PROFILE_COUNT) {
+    return false;
+  }
+  
+  capture_profile = level;
   if (!cam_initialized) {
+    return true; // Applied on init
+  }
+  
+  // The crop settings are read at crop time; only the frame's JPEG quality is a register
+  sensor_t* sensor = esp_camera_sensor_get();
+  if (sensor == nullptr) {
     return false;
   }
   
-  // Free previous frame if exists
-  if (fb != nullptr) {
-    esp_camera_fb_return(fb);
-    fb = nullptr;
+  if (sensor->set_quality(sensor, CAPTURE_PROFILES[level].sensor_quality) != 0) {
+    Logger::logError("Camera: Failed to apply capture profile " + String(level));
+    return false;
   }
   
+  Logger::logInfo("Camera: Capture profile " + String(level));
+  return true;
+}
+
+int esp_cam_get_profile() {
+  return capture_profile;
+}
+
+int esp_cam_profile_count() {
+  return CAPTURE_PROFILE_COUNT;
+}
+
+bool esp_cam_capture_frame() {
+  if (!cam_initialized || cam_sleeping) {
+    return false;
+  }
+  
+  // Free previous frame if exists
+  esp_cam_cleanup();
+  
   // Capture frame
   fb = esp_camera_fb_get();
   if (!fb) {
@@ -91,16 +512,68 @@ bool esp_cam_capture_frame() {
     return false;
   }
   
+  frame_buf = fb->buf;
+  frame_len = fb->len;
+  frame_width = fb->width;
+  frame_height = fb->height;
+  
   Logger::logInfo("Camera: Frame captured (" + String(fb->len) + " bytes)");
   return true;
 }
 
 String esp_cam_get_base64_jpeg() {
-  if (fb == nullptr || fb->buf == nullptr) {
+  if (frame_buf == nullptr) {
     return "";
   }
   
-  return Helpers::base64Encode(fb->buf, fb->len);
+  return Helpers::base64Encode((uint8_t*)frame_buf, frame_len);
+}
+
+static bool decode_luma(const uint8_t* buf, size_t len, uint16_t width, uint16_t height, LumaImage& out) {
+  width /= 8;
+  height /= 8;
+  if (width > LUMA_MAX_WIDTH || height > LUMA_MAX_HEIGHT) {
+    Logger::logError("Camera: Frame too large for luma decode");
+    return false;
+  }
+  
+  if (!jpg2rgb565(buf, len, luma_decode_buf, JPG_SCALE_8X)) {
+    Logger::logError("Camera: JPEG decode failed");
+    return false;
+  }
+  
+  return image_rgb565_to_luma(luma_decode_buf, width, height, out);
+}
+
+// Sharpness weighted by the face score, so blurred frames and closed eyes
+// (weak eye band contrast) rank low; frames without a face only count a little
+static float score_frame(const camera_fb_t* frame, LumaImage& luma) {
+  if (!decode_luma(frame->buf, frame->len, frame->width, frame->height, luma)) {
+    return -1.0;
+  }
+  note_wake_frame(luma);
+  
+  FaceBox face;
+  float sharpness = image_laplacian_variance(luma);
+  if (image_find_face(luma, 0.35, face)) {
+    return sharpness * (1.0 + face.score);
+  }
+  return sharpness * 0.1;
+}
+
+const LumaImage* esp_cam_get_luma() {
+  if (frame_buf == nullptr) {
+    return nullptr;
+  }
+  
+  if (!frame_luma_valid) {
+    frame_luma_valid = decode_luma(frame_buf, frame_len, frame_width, frame_height, frame_luma);
+    if (frame_luma_valid) {
+      note_wake_frame(frame_luma);
+    }
+  }
+  
+  return frame_luma_valid ? &frame_luma : nullptr;
 }
 
 void esp_cam_cleanup() {
@@ -108,12 +581,246 @@ void esp_cam_cleanup() {
     esp_camera_fb_return(fb);
     fb = nullptr;
   }
+  if (crop_jpeg != nullptr) {
+    free(crop_jpeg);
+    crop_jpeg = nullptr;
+  }
+  frame_buf = nullptr;
+  frame_len = 0;
+  frame_luma_valid = false;
 }
 
 size_t esp_cam_get_frame_size() {
+  return frame_len;
+}
+
+bool esp_cam_crop_to_face(const FaceBox& face) {
+  const LumaImage* luma = esp_cam_get_luma();
+  if (luma == nullptr || !psramFound()) {
+    return false;
+  }
+  
+  unsigned long start = micros();
+  const CaptureProfile& profile = CAPTURE_PROFILES[capture_profile];
+  
+  CropRect rect;
+  if (!image_face_crop_rect(face, luma->width, luma->height, frame_width, frame_height,
+                            FACE_CROP_PADDING, rect)) {
+    return false;
+  }
+  
+  size_t rgb_size = (size_t)frame_width * frame_height * 3;
+  if (rgb_size > crop_rgb_capacity) {
+    free(crop_rgb_buf);
+    crop_rgb_buf = (uint8_t*)ps_malloc(rgb_size);
+    crop_rgb_capacity = crop_rgb_buf != nullptr ? rgb_size : 0;
+  }
+  if (crop_scaled_buf == nullptr) {
+    crop_scaled_buf = (uint8_t*)ps_malloc(FACE_CROP_SIZE * FACE_CROP_SIZE * 3);
+  }
+  if (crop_rgb_buf == nullptr || crop_scaled_buf == nullptr) {
+    Logger::logError("Camera: Face crop PSRAM allocation failed");
+    return false;
+  }
+  
+  if (!fmt2rgb888(frame_buf, frame_len, PIXFORMAT_JPEG, crop_rgb_buf)) {
+    Logger::logError("Camera: Face crop decode failed");
+    return false;
+  }
+  
+  if (!image_crop_scale_rgb888(crop_rgb_buf, frame_width, frame_height, rect,
+                               crop_scaled_buf, profile.crop_size, profile.crop_size)) {
+    return false;
+  }
+  
+  uint8_t* jpeg = nullptr;
+  size_t jpeg_len = 0;
+  if (!fmt2jpg(crop_scaled_buf, profile.crop_size * profile.crop_size * 3, profile.crop_size, profile.crop_size,
+               PIXFORMAT_RGB888, profile.crop_quality, &jpeg, &jpeg_len)) {
+    Logger::logError("Camera: Face crop encode failed");
+    return false;
+  }
+  
+  Logger::logInfo("Camera: Face crop " + String(frame_len) + " -> " + String(jpeg_len) +
+                  " bytes in " + String((micros() - start) / 1000) + " ms");
+  
+  // The crop becomes the current frame; the source buffer is released
+  esp_cam_cleanup();
+  crop_jpeg = jpeg;
+  frame_buf = crop_jpeg;
+  frame_len = jpeg_len;
+  frame_width = profile.crop_size;
+  frame_height = profile.crop_size;
+  return true;
+}
+
+bool esp_cam_precapture_start() {
+  if (!cam_initialized || cam_sleeping || !psramFound()) {
+    return false;
+  }
+  
+  if (!precapture_allocated) {
+    for (int i = 0; i < PRECAPTURE_SLOTS; i++) {
+      precapture_ring[i].buf = (uint8_t*)ps_malloc(PRECAPTURE_SLOT_BYTES);
+      if (precapture_ring[i].buf == nullptr) {
+        Logger::logError("Camera: Pre-capture PSRAM allocation failed");
+        return false;
+      }
+    }
+    precapture_allocated = true;
+  }
+  
+  for (int i = 0; i < PRECAPTURE_SLOTS; i++) {
+    precapture_ring[i].valid = false;
+  }
+  precapture_next = 0;
+  precapture_last_grab = 0;
+  precapture_active = true;
+  return true;
+}
+
+void esp_cam_precapture_stop() {
+  precapture_active = false;
+}
+
+void esp_cam_precapture_poll() {
+  if (!precapture_active || cam_sleeping || clock_millis() - precapture_last_grab < PRECAPTURE_INTERVAL_MS) {
+    return;
+  }
+  precapture_last_grab = clock_millis();
+  
+  camera_fb_t* grab = esp_camera_fb_get();
+  if (!grab) {
+    return;
+  }
+  
+  if (grab->len > PRECAPTURE_SLOT_BYTES) {
+    esp_camera_fb_return(grab);
+    return;
+  }
+  
+  float score = score_frame(grab, candidate_luma);
+  
+  PrecaptureSlot& slot = precapture_ring[precapture_next];
+  memcpy(slot.buf, grab->buf, grab->len);
+  slot.len = grab->len;
+  slot.width = grab->width;
+  slot.height = grab->height;
+  slot.score = score;
+  slot.captured_at = clock_millis();
+  slot.valid = true;
+  precapture_next = (precapture_next + 1) % PRECAPTURE_SLOTS;
+  
+  esp_camera_fb_return(grab);
+}
+
+bool esp_cam_take_precaptured() {
+  int best = -1;
+  unsigned long now = clock_millis();
+  for (int i = 0; i < PRECAPTURE_SLOTS; i++) {
+    PrecaptureSlot& slot = precapture_ring[i];
+    if (!slot.valid || now - slot.captured_at > PRECAPTURE_MAX_AGE_MS) {
+      continue;
+    }
+    if (best < 0 || slot.score > precapture_ring[best].score) {
+      best = i;
+    }
+  }
+  
+  if (best < 0) {
+    return false;
+  }
+  
+  esp_cam_cleanup();
+  PrecaptureSlot& slot = precapture_ring[best];
+  slot.valid = false; // Hand out each frame once
+  frame_buf = slot.buf;
+  frame_len = slot.len;
+  frame_width = slot.width;
+  frame_height = slot.height;
+  
+  Logger::logInfo("Camera: Using pre-captured frame (" + String(now - slot.captured_at) + " ms old)");
+  return true;
+}
+
+
+bool esp_cam_capture_burst(int burst_size) {
+  if (!cam_initialized || cam_sleeping) {
+    return false;
+  }
+  
+  // Holding the best frame while grabbing the next needs the second frame buffer
+  if (burst_size < 1 || !psramFound()) {
+    burst_size = 1;
+  }
+  
+  esp_cam_cleanup();
+  
+  unsigned long start = micros();
+  unsigned long score_us = 0;
+  float best_score = -2.0;
+  int captured = 0;
+  
+  for (int i = 0; i < burst_size; i++) {
+    camera_fb_t* grab = esp_camera_fb_get();
+    if (!grab) {
+      break;
+    }
+    captured++;
+    
+    unsigned long score_start = micros();
+    float score = score_frame(grab, candidate_luma);
+    score_us += micros() - score_start;
+    
+    if (score > best_score) {
+      if (fb != nullptr) {
+        esp_camera_fb_return(fb);
+      }
+      fb = grab;
+      best_score = score;
+      if (score >= 0.0) {
+        memcpy(&frame_luma, &candidate_luma, sizeof(frame_luma));
+        frame_luma_valid = true;
+      } else {
+        frame_luma_valid = false;
+      }
+    } else {
+      esp_camera_fb_return(grab);
+    }
+  }
+  
+  burst_stats.bursts++;
+  burst_stats.frames += captured;
+  burst_stats.total_burst_us += micros() - start;
+  burst_stats.total_score_us += score_us;
+  
   if (fb == nullptr) {
-    return 0;
+    Logger::logError("Camera: Burst capture failed");
+    return false;
   }
-  return fb->len;
+  
+  frame_buf = fb->buf;
+  frame_len = fb->len;
+  frame_width = fb->width;
+  frame_height = fb->height;
+  
+  Logger::logInfo("Camera: Burst of " + String(captured) + " in " + String((micros() - start) / 1000) +
+                  " ms, best score " + String(best_score, 1));
+  return true;
+}
+
+CameraBurstStats esp_cam_get_burst_stats() {
+  return burst_stats;
 }
 
+void esp_cam_log_burst_stats() {
+  if (burst_stats.bursts == 0) {
+    return;
+  }
+  
+  Logger::logf("[INFO] Camera: %lu bursts, %.1f frames/burst, %lu us/burst, %lu us scoring/frame",
+               burst_stats.bursts,
+               (float)burst_stats.frames / burst_stats.bursts,
+               burst_stats.total_burst_us / burst_stats.bursts,
+               burst_stats.frames > 0 ? burst_stats.total_score_us / burst_stats.frames : 0);
+}
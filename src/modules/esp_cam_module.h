@@ -2,12 +2,55 @@
 #define ESP_CAM_MODULE_H
 
 #include <Arduino.h>
+#include "../utils/image_utils.h"
+
+struct CameraBurstStats {
+  unsigned long bursts;
+  unsigned long frames;
+  unsigned long total_burst_us;  // Capture + scoring wall time
+  unsigned long total_score_us;  // Decode + sharpness + face scoring only
+};
+
+struct CameraWakeStats {
+  unsigned long wakes;
+  unsigned long full_reinits;     // Warm restore failed, esp_camera_init() was needed
+  unsigned long restore_us;       // Last XCLK resume + register restore + exposure preload/AE
+  unsigned long last_usable_us;   // Last wake to first correctly exposed frame
+  unsigned long total_usable_us;
+};
 
 bool esp_cam_init();
+
+// Idle power-down: PWDN high and XCLK stopped, registers replayed on wake
+void esp_cam_sleep();
+bool esp_cam_wake();
+bool esp_cam_is_sleeping();
+CameraWakeStats esp_cam_get_wake_stats();
+
+// Per time-of-day exposure presets and the optional preview-frame AE loop run on wake
+void esp_cam_preload_exposure();
+bool esp_cam_quick_ae();
+void esp_cam_set_quick_ae(bool enabled);
+
+bool esp_cam_apply_profile(int level);
+int esp_cam_get_profile();
+int esp_cam_profile_count();
 bool esp_cam_capture_frame();
+bool esp_cam_capture_burst(int burst_size);
 String esp_cam_get_base64_jpeg();
+const LumaImage* esp_cam_get_luma();
+bool esp_cam_crop_to_face(const FaceBox& face);
 void esp_cam_cleanup();
 size_t esp_cam_get_frame_size();
 
+// Pre-capture ring, filled while waiting for the card tap
+bool esp_cam_precapture_start();
+void esp_cam_precapture_stop();
+void esp_cam_precapture_poll();
+bool esp_cam_take_precaptured();
+
+CameraBurstStats esp_cam_get_burst_stats();
+void esp_cam_log_burst_stats();
+
 #endif
 
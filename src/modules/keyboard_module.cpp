@@ -1,6 +1,7 @@
 #include "keyboard_module.h"
 #include <Arduino.h>
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 
 // ESP32-CAM AI-Thinker Pinout (8 GPIO pins available):
 // Left side: GPIO 12, 13, 15, 14, 2, 4
@@ -54,7 +55,7 @@ void keyboard_init() {
 }
 
 int keyboard_get_key() {
-  unsigned long now = millis();
+  unsigned long now = clock_millis();
   
   // Scan matrix
   for (int row = 0; row < 4; row++) {
@@ -1,6 +1,7 @@
 #include "motion_sensor.h"
 #include <Arduino.h>
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 
 // ESP32-CAM AI-Thinker: GPIO 16 (U2RXD) - Right side pin 2
 // Shared with Keyboard Row 3
@@ -13,17 +14,29 @@ unsigned long last_motion_time = 0;
 unsigned long last_high_time = 0;
 bool consecutive_high = false;
 void (*motion_callback)() = nullptr;
+TaskHandle_t motion_wake_task = NULL;
+
+static void IRAM_ATTR motion_isr() {
+  if (motion_wake_task != NULL) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(motion_wake_task, &woken);
+    if (woken == pdTRUE) {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
 
 void motion_init() {
   pinMode(PIR_PIN, INPUT);
   motion_state = false;
   last_motion_time = 0;
+  attachInterrupt(digitalPinToInterrupt(PIR_PIN), motion_isr, RISING);
   Logger::logInfo("Motion Sensor: Initialized");
 }
 
 bool motion_detected() {
   bool current_read = digitalRead(PIR_PIN) == HIGH;
-  unsigned long now = millis();
+  unsigned long now = clock_millis();
   
   if (current_read) {
     if (!consecutive_high) {
@@ -55,6 +68,10 @@ bool motion_detected() {
   return motion_state;
 }
 
+bool motion_active() {
+  return motion_state;
+}
+
 unsigned long motion_last_time() {
   return last_motion_time;
 }
@@ -63,3 +80,7 @@ void motion_set_callback(void (*callback)()) {
   motion_callback = callback;
 }
 
+void motion_set_wake_task(TaskHandle_t task) {
+  motion_wake_task = task;
+}
+
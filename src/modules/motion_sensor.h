@@ -5,8 +5,11 @@
 
 void motion_init();
 bool motion_detected();
+bool motion_active(); // Last debounced state, without sampling the pin
 unsigned long motion_last_time();
 void motion_set_callback(void (*callback)());
+// Task notified from the PIR rising-edge interrupt, so it can sample at once
+void motion_set_wake_task(TaskHandle_t task);
 
 #endif
 
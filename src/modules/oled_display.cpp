@@ -2,11 +2,128 @@
 #include <U8g2lib.h>
 #include <Wire.h>
 #include "../utils/logger.h"
+#include "../utils/clock.h"
+#include "../utils/spsc_queue.h"
+
+#define WAITING_ANIMATION_MS 500
 
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE);
 
 bool oled_initialized = false;
 
+// Screen requests from the state machine, rendered by the UI task once
+// async mode is on. Repeats of the screen already queued are dropped.
+enum DisplayCommandType {
+  DISPLAY_NONE,
+  DISPLAY_STATUS,
+  DISPLAY_WAITING,
+  DISPLAY_ERROR,
+  DISPLAY_APPROVAL,
+  DISPLAY_CLEAR
+};
+
+struct DisplayCommand {
+  DisplayCommandType type;
+  bool approved;
+  String text;
+  String detail;
+  String extra;
+  
+  DisplayCommand() : type(DISPLAY_NONE), approved(false) {}
+  
+  bool operator==(const DisplayCommand& other) const {
+    return type == other.type && approved == other.approved &&
+           text == other.text && detail == other.detail && extra == other.extra;
+  }
+};
+
+SpscQueue<DisplayCommand, OLED_QUEUE_DEPTH> display_queue;
+TaskHandle_t display_renderer = NULL;
+DisplayCommand display_last_posted;  // Producer side
+DisplayCommand display_current;      // UI task side
+unsigned long display_last_render = 0;
+
+static void render_status(String status, String balance, bool approved);
+static void render_waiting(String msg);
+static void render_error(String error_msg);
+static void render_approval(String student_name, String id, String reason);
+static void render_clear();
+
+static void render(const DisplayCommand& cmd) {
+  switch (cmd.type) {
+    case DISPLAY_STATUS:
+      render_status(cmd.text, cmd.detail, cmd.approved);
+      break;
+    case DISPLAY_WAITING:
+      render_waiting(cmd.text);
+      break;
+    case DISPLAY_ERROR:
+      render_error(cmd.text);
+      break;
+    case DISPLAY_APPROVAL:
+      render_approval(cmd.text, cmd.detail, cmd.extra);
+      break;
+    case DISPLAY_CLEAR:
+      render_clear();
+      break;
+    default:
+      break;
+  }
+}
+
+static void post(const DisplayCommand& cmd) {
+  if (display_renderer == NULL) {
+    render(cmd);
+    return;
+  }
+  
+  if (cmd == display_last_posted) {
+    return;
+  }
+  
+  if (display_queue.push(cmd)) {
+    display_last_posted = cmd;
+    xTaskNotifyGive(display_renderer);
+  }
+}
+
+void oled_set_async(TaskHandle_t renderer) {
+  display_renderer = renderer;
+}
+
+unsigned long oled_service() {
+  // Only the newest screen matters, skip anything queued behind it
+  DisplayCommand cmd;
+  bool changed = false;
+  while (display_queue.pop(cmd)) {
+    display_current = cmd;
+    changed = true;
+  }
+  
+  // Waiting screens animate their dots without new requests
+  bool waiting = display_current.type == DISPLAY_WAITING;
+  unsigned long since_render = clock_millis() - display_last_render;
+  if (changed || (waiting && since_render >= WAITING_ANIMATION_MS)) {
+    render(display_current);
+    display_last_render = clock_millis();
+    since_render = 0;
+  }
+  
+  return waiting ? WAITING_ANIMATION_MS - since_render : 0;
+}
+
+size_t oled_queue_depth() {
+  return display_queue.size();
+}
+
+size_t oled_queue_max_depth() {
+  return display_queue.max_depth();
+}
+
+unsigned long oled_queue_drops() {
+  return display_queue.drops();
+}
+
 bool oled_init() {
   if (oled_initialized) {
     return true;
@@ -26,6 +143,44 @@ bool oled_init() {
 }
 
 void display_status(String status, String balance, bool approved) {
+  DisplayCommand cmd;
+  cmd.type = DISPLAY_STATUS;
+  cmd.text = status;
+  cmd.detail = balance;
+  cmd.approved = approved;
+  post(cmd);
+}
+
+void display_waiting(String msg) {
+  DisplayCommand cmd;
+  cmd.type = DISPLAY_WAITING;
+  cmd.text = msg;
+  post(cmd);
+}
+
+void display_error(String error_msg) {
+  DisplayCommand cmd;
+  cmd.type = DISPLAY_ERROR;
+  cmd.text = error_msg;
+  post(cmd);
+}
+
+void display_manager_approval_screen(String student_name, String id, String reason) {
+  DisplayCommand cmd;
+  cmd.type = DISPLAY_APPROVAL;
+  cmd.text = student_name;
+  cmd.detail = id;
+  cmd.extra = reason;
+  post(cmd);
+}
+
+void clear_display() {
+  DisplayCommand cmd;
+  cmd.type = DISPLAY_CLEAR;
+  post(cmd);
+}
+
+static void render_status(String status, String balance, bool approved) {
   if (!oled_initialized) return;
   
   u8g2.clearBuffer();
@@ -55,14 +210,14 @@ void display_status(String status, String balance, bool approved) {
   u8g2.sendBuffer();
 }
 
-void display_waiting(String msg) {
+static void render_waiting(String msg) {
   if (!oled_initialized) return;
   
   static int dotCount = 0;
   static unsigned long lastUpdate = 0;
-  unsigned long now = millis();
+  unsigned long now = clock_millis();
   
-  if (now - lastUpdate > 500) {
+  if (now - lastUpdate >= WAITING_ANIMATION_MS) {
     dotCount = (dotCount + 1) % 4;
     lastUpdate = now;
   }
@@ -81,7 +236,7 @@ void display_waiting(String msg) {
   u8g2.sendBuffer();
 }
 
-void display_error(String error_msg) {
+static void render_error(String error_msg) {
   if (!oled_initialized) return;
   
   u8g2.clearBuffer();
@@ -94,7 +249,7 @@ void display_error(String error_msg) {
   String remaining = error_msg;
   while (remaining.length() > 0 && y < 64) {
     String line = "";
-    int chars = 0;
+    unsigned int chars = 0;
     while (chars < remaining.length() && u8g2.getStrWidth((line + remaining[chars]).c_str()) < 120) {
       line += remaining[chars];
       chars++;
@@ -107,7 +262,7 @@ void display_error(String error_msg) {
   u8g2.sendBuffer();
 }
 
-void display_manager_approval_screen(String student_name, String id, String reason) {
+static void render_approval(String student_name, String id, String reason) {
   if (!oled_initialized) return;
   
   u8g2.clearBuffer();
@@ -138,7 +293,7 @@ void display_manager_approval_screen(String student_name, String id, String reas
   u8g2.sendBuffer();
 }
 
-void clear_display() {
+static void render_clear() {
   if (!oled_initialized) return;
   u8g2.clearBuffer();
   u8g2.sendBuffer();
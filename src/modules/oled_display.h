@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 
+#define OLED_QUEUE_DEPTH 4
+
 bool oled_init();
 void display_status(String status, String balance, bool approved);
 void display_waiting(String msg);
@@ -10,5 +12,15 @@ void display_error(String error_msg);
 void display_manager_approval_screen(String student_name, String id, String reason);
 void clear_display();
 
+// Async mode: display_* calls queue the screen and notify the renderer task,
+// which calls oled_service(). Producers must all run on one task; NULL
+// renders synchronously again. oled_service() returns the ms until the next
+// animation frame is due, or 0 when nothing is scheduled.
+void oled_set_async(TaskHandle_t renderer);
+unsigned long oled_service();
+size_t oled_queue_depth();
+size_t oled_queue_max_depth();
+unsigned long oled_queue_drops();
+
 #endif
 
@@ -1,12 +1,12 @@
 #include "power_management.h"
 #include <esp_pm.h>
 #include <esp32-hal-cpu.h>
-#include "../modules/motion_sensor.h"
-#include "../modules/oled_display.h"
-#include "../utils/logger.h"
+#include "modules/motion_sensor.h"
+#include "modules/oled_display.h"
+#include "utils/logger.h"
+#include "utils/clock.h"
 
-unsigned long last_motion_time = 0;
-bool sleep_mode = false;
+volatile bool sleep_mode = false; // Followed by the camera task
 uint32_t original_cpu_freq = 240;
 
 void power_init() {
@@ -25,6 +25,8 @@ void enter_sleep_mode() {
   // Turn off OLED (clear display)
   clear_display();
   
+  // The camera task sees sleep_mode and powers the sensor down itself
+  
   // Reduce CPU frequency to 80MHz
   original_cpu_freq = getCpuFrequencyMhz();
   setCpuFrequencyMhz(80);
@@ -43,12 +45,14 @@ void exit_sleep_mode() {
   // Restore CPU frequency
   setCpuFrequencyMhz(original_cpu_freq);
   
+  // The camera task restores the sensor from cached registers on its next pass
+  
   // OLED will be turned on by display functions
   sleep_mode = false;
 }
 
 unsigned long get_uptime() {
-  return millis() / 1000;
+  return clock_seconds();
 }
 
 bool is_sleep_mode() {
@@ -56,7 +60,7 @@ bool is_sleep_mode() {
 }
 
 void power_check_sleep(unsigned long motion_timeout_ms) {
-  unsigned long now = millis();
+  unsigned long now = clock_millis();
   unsigned long time_since_motion = now - motion_last_time();
   
   if (time_since_motion > motion_timeout_ms && !sleep_mode) {
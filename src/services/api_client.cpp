@@ -3,26 +3,54 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 #include "../config/data_types.h"
 #include "../services/wifi_manager.h"
+#include "../services/hub_service.h"
 
 String server_base_url = "";
 int server_port = 5000;
 const int API_TIMEOUT = 5000;
 const int MAX_RETRIES = 1;
+String device_id = "esp32_device_001";
+const int HUB_TIMEOUT = 1500;  // Same LAN; a slow hub is treated as absent
+String hub_ip = "";
+int hub_port = 80;
+
+// Size and wall time of the last successful face-verify request, for link-aware tuning.
+// The time is that of the attempt that answered, without a failed attempt or retry delay
+// before it. Only the verify path updates these: transaction logging runs on the commit worker.
+size_t last_request_bytes = 0;
+unsigned long last_request_ms = 0;
 
 void api_set_server(String ip, int port) {
   server_base_url = ip;
   server_port = port;
 }
 
+void api_set_device_id(String id) {
+  device_id = id;
+}
+
+void api_set_hub(String ip, int port) {
+  hub_ip = ip;
+  hub_port = port;
+}
+
 bool api_init(String base_url) {
   server_base_url = base_url;
   Logger::logInfo("API Client: Initialized with base URL " + base_url);
   return true;
 }
 
-String api_call(String method, String endpoint, String payload, bool retry_on_timeout) {
+// code_out gets the HTTP status of the answer, or 0 when there was none;
+// elapsed_ms_out the wall time of the attempt that answered
+static String request(String host, int port, int timeout, String method, String endpoint,
+                      String payload, bool retry_on_timeout, int* code_out,
+                      unsigned long* elapsed_ms_out) {
+  if (code_out != NULL) {
+    *code_out = 0;
+  }
   if (!wifi_is_connected()) {
     Logger::logError("API: WiFi not connected");
     return "";
@@ -31,11 +59,12 @@ String api_call(String method, String endpoint, String payload, bool retry_on_ti
   int retries = retry_on_timeout ? MAX_RETRIES : 0;
   
   for (int attempt = 0; attempt <= retries; attempt++) {
+    unsigned long attempt_start = millis();
     HTTPClient http;
-    String url = "http://" + server_base_url + ":" + String(server_port) + endpoint;
+    String url = "http://" + host + ":" + String(port) + endpoint;
     
     http.begin(url);
-    http.setTimeout(API_TIMEOUT);
+    http.setTimeout(timeout);
     http.addHeader("Content-Type", "application/json");
     
     int httpCode = 0;
@@ -47,7 +76,13 @@ String api_call(String method, String endpoint, String payload, bool retry_on_ti
     
     String response = "";
     if (httpCode > 0 && httpCode < 500) {
+      if (code_out != NULL) {
+        *code_out = httpCode;
+      }
       response = http.getString();
+      if (elapsed_ms_out != NULL) {
+        *elapsed_ms_out = millis() - attempt_start;
+      }
       Logger::logInfo("API: " + method + " " + endpoint + " - Code: " + String(httpCode));
       http.end();
       return response;
@@ -65,16 +100,39 @@ String api_call(String method, String endpoint, String payload, bool retry_on_ti
   return "";
 }
 
+String api_call(String method, String endpoint, String payload, bool retry_on_timeout) {
+  return request(server_base_url, server_port, API_TIMEOUT, method, endpoint, payload,
+                 retry_on_timeout, NULL, NULL);
+}
+
+// Terminals behind a hub: 2xx from the hub, else empty and the caller
+// goes to the server itself
+static String hub_call(String method, String endpoint, String payload) {
+  if (hub_ip.length() == 0) {
+    return "";
+  }
+  int code = 0;
+  String response = request(hub_ip, hub_port, HUB_TIMEOUT, method, endpoint, payload, false, &code, NULL);
+  return code >= 200 && code < 300 ? response : String();
+}
+
 String api_face_verify(String rfid_uid, String face_base64) {
   JsonDocument doc;
   doc["rfid_uid"] = rfid_uid;
   doc["face_image"] = face_base64;
-  doc["timestamp"] = millis() / 1000;
+  doc["timestamp"] = clock_seconds();
   
   String payload;
   serializeJson(doc, payload);
   
-  return api_call("POST", "/api/auth/face-verify", payload, true);
+  unsigned long elapsed_ms = 0;
+  String response = request(server_base_url, server_port, API_TIMEOUT, "POST", "/api/auth/face-verify",
+                            payload, true, NULL, &elapsed_ms);
+  if (response.length() > 0) {
+    last_request_ms = elapsed_ms;
+    last_request_bytes = payload.length() + response.length();
+  }
+  return response;
 }
 
 bool api_log_transaction(Transaction t) {
@@ -91,17 +149,26 @@ bool api_log_transaction(Transaction t) {
   doc["timestamp"] = t.timestamp;
   doc["fraud_detected"] = t.fraud_alert;
   doc["reason"] = t.reason;
+  // For a hub: the id and name fill its roster, device_time places the
+  // timestamp on its clock
+  doc["id"] = t.id;
+  doc["student_name"] = t.student_name;
+  doc["device_time"] = clock_seconds();
   
   String payload;
   serializeJson(doc, payload);
   
+  if (hub_call("POST", "/api/transactions/log", payload).length() > 0) {
+    return true;
+  }
   String response = api_call("POST", "/api/transactions/log", payload, false);
   return response.length() > 0;
 }
 
-bool api_sync_offline_transactions(std::vector<Transaction> txns) {
+bool api_sync_offline_transactions(const std::vector<Transaction>& txns, std::vector<String>& acked) {
   JsonDocument doc;
-  doc["device_id"] = "esp32_device_001";
+  doc["device_id"] = device_id;
+  doc["device_time"] = clock_seconds();
   JsonArray arr = doc["transactions"].to<JsonArray>();
   
   for (const Transaction& t : txns) {
@@ -122,25 +189,54 @@ bool api_sync_offline_transactions(std::vector<Transaction> txns) {
   String payload;
   serializeJson(doc, payload);
   
-  String response = api_call("POST", "/api/transactions/sync-batch", payload, true);
+  String response = hub_call("POST", "/api/transactions/sync-batch", payload);
+  if (response.length() == 0) {
+    response = api_call("POST", "/api/transactions/sync-batch", payload, true);
+  }
   
   if (response.length() > 0) {
     JsonDocument respDoc;
     if (deserializeJson(respDoc, response) == DeserializationError::Ok) {
-      int synced = respDoc["synced_count"] | 0;
-      Logger::logInfo("API: Synced " + String(synced) + " transactions");
-      return synced > 0;
+      JsonArray ids = respDoc["acked"].as<JsonArray>();
+      if (!ids.isNull()) {
+        for (JsonVariant id : ids) {
+          acked.push_back(id.as<String>());
+        }
+      } else if ((respDoc["synced_count"] | 0) == (int)txns.size()) {
+        // A server without per-record acks: only a full count is trusted
+        for (const Transaction& t : txns) {
+          acked.push_back(t.id);
+        }
+      }
+      Logger::logInfo("API: Synced " + String((int)acked.size()) + " of " + String((int)txns.size()) +
+                      " transactions");
+      return true;
     }
   }
   
   return false;
 }
 
+String api_hub_lookup(String rfid_uid) {
+  if (hub_is_active()) {
+    return hub_roster_lookup(rfid_uid);
+  }
+  return hub_call("GET", "/hub/roster?uid=" + rfid_uid, "");
+}
+
 String api_get_balance(String student_id) {
   String endpoint = "/api/student/" + student_id + "/balance";
   return api_call("GET", endpoint, "", false);
 }
 
+size_t api_get_last_request_bytes() {
+  return last_request_bytes;
+}
+
+unsigned long api_get_last_request_ms() {
+  return last_request_ms;
+}
+
 bool api_is_connected() {
   return wifi_is_connected();
 }
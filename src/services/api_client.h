@@ -6,12 +6,21 @@
 
 bool api_init(String base_url);
 void api_set_server(String ip, int port);
+void api_set_device_id(String id);  // Reported with offline sync batches
+// Logs and sync batches go to this hub first (see hub_service.h); "" for none
+void api_set_hub(String ip, int port);
 String api_call(String method, String endpoint, String payload, bool retry_on_timeout);
 String api_face_verify(String rfid_uid, String face_base64);
 bool api_log_transaction(Transaction t);
-bool api_sync_offline_transactions(std::vector<Transaction> txns);
+// One sync-batch call. acked gets the ids the server confirmed storing;
+// false if there was no usable reply.
+bool api_sync_offline_transactions(const std::vector<Transaction>& txns, std::vector<String>& acked);
+// Roster entry for the card from the hub, face-verify shaped; empty if none
+String api_hub_lookup(String rfid_uid);
 String api_get_balance(String student_id);
 bool api_is_connected();
+size_t api_get_last_request_bytes();
+unsigned long api_get_last_request_ms();
 
 #endif
 
@@ -0,0 +1,109 @@
+#include "capture_tuning.h"
+#include "../modules/esp_cam_module.h"
+#include "../modules/esp_cam_config.h"
+#include "../utils/logger.h"
+
+#define TUNING_ALPHA 0.3
+
+float tuning_kbps = 0.0;
+float tuning_request_ms = 0.0;
+float tuning_confidence = 1.0;
+float tuning_bytes[CAPTURE_PROFILE_COUNT]; // Smoothed request size per profile, 0 until measured
+int tuning_votes = 0; // > 0 towards better quality, < 0 towards smaller uploads
+unsigned long tuning_changes = 0;
+volatile int tuning_profile = 0; // Applied by the camera task before its next capture
+
+static void set_profile(int level) {
+  if (level < 0 || level >= esp_cam_profile_count()) {
+    return;
+  }
+
+  if (level != tuning_profile) {
+    tuning_profile = level;
+    tuning_changes++;
+    Logger::logInfo("Capture Tuning: Profile " + String(level) + " (" + String(tuning_kbps, 0) +
+                    " kbps, " + String(tuning_request_ms, 0) + " ms, confidence " +
+                    String(tuning_confidence, 2) + ")");
+  }
+  tuning_votes = 0;
+}
+
+// Request size of a profile: measured, else scaled from the one just measured
+static float expected_bytes(int level, int measured) {
+  if (tuning_bytes[level] > 0.0) {
+    return tuning_bytes[level];
+  }
+  return tuning_bytes[measured] * CAPTURE_PROFILES[level].payload_pct / CAPTURE_PROFILES[measured].payload_pct;
+}
+
+void capture_tuning_observe(size_t request_bytes, unsigned long request_ms, float confidence, float min_confidence) {
+  if (request_ms == 0 || request_bytes == 0) {
+    return;
+  }
+
+  // The camera applies a new target before its next capture, so this
+  // request was made with the profile the camera still has
+  int measured = esp_cam_get_profile();
+  float kbps = (request_bytes * 8.0) / request_ms;
+  if (tuning_request_ms == 0.0) {
+    tuning_kbps = kbps;
+    tuning_request_ms = request_ms;
+    tuning_confidence = confidence;
+  } else {
+    tuning_kbps += TUNING_ALPHA * (kbps - tuning_kbps);
+    tuning_request_ms += TUNING_ALPHA * (request_ms - tuning_request_ms);
+    tuning_confidence += TUNING_ALPHA * (confidence - tuning_confidence);
+  }
+  if (tuning_bytes[measured] == 0.0) {
+    tuning_bytes[measured] = request_bytes;
+  } else {
+    tuning_bytes[measured] += TUNING_ALPHA * (request_bytes - tuning_bytes[measured]);
+  }
+
+  // Best quality that fits: the current profile or a smaller one within the
+  // budget, a better one only with margin. Low confidence lowers the margin,
+  // recognition needs the detail.
+  int climb_pct = tuning_confidence < min_confidence ? CAPTURE_CLIMB_LOW_CONFIDENCE_PCT : CAPTURE_CLIMB_PCT;
+  int target = esp_cam_profile_count() - 1;
+  for (int level = 0; level < esp_cam_profile_count(); level++) {
+    float predicted_ms = expected_bytes(level, measured) * 8.0 / tuning_kbps;
+    float limit_ms = level < tuning_profile ? CAPTURE_UPLOAD_BUDGET_MS * climb_pct / 100.0
+                                            : CAPTURE_UPLOAD_BUDGET_MS;
+    if (predicted_ms <= limit_ms) {
+      target = level;
+      break;
+    }
+  }
+
+  if (target > tuning_profile) {
+    tuning_votes = tuning_votes > 0 ? -1 : tuning_votes - 1;
+  } else if (target < tuning_profile) {
+    tuning_votes = tuning_votes < 0 ? 1 : tuning_votes + 1;
+  } else {
+    tuning_votes = 0;
+  }
+
+  if (tuning_votes <= -CAPTURE_TUNING_HYSTERESIS || tuning_votes >= CAPTURE_TUNING_HYSTERESIS) {
+    set_profile(target);
+  }
+}
+
+void capture_tuning_observe_timeout() {
+  // A timed-out verify is the strongest signal, step down without waiting
+  tuning_request_ms = CAPTURE_UPLOAD_BUDGET_MS * 2;
+  set_profile(tuning_profile + 1);
+}
+
+int capture_tuning_target_profile() {
+  return tuning_profile;
+}
+
+CaptureTuningStats capture_tuning_get_stats() {
+  CaptureTuningStats stats;
+  stats.kbps = tuning_kbps;
+  stats.request_ms = tuning_request_ms;
+  stats.confidence = tuning_confidence;
+  stats.profile = tuning_profile;
+  stats.changes = tuning_changes;
+  return stats;
+}
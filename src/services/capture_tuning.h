@@ -0,0 +1,33 @@
+#ifndef CAPTURE_TUNING_H
+#define CAPTURE_TUNING_H
+
+#include <Arduino.h>
+
+// Picks the camera profile (see esp_cam_config.h) whose face-verify
+// request is predicted to fit the time budget. The prediction is the
+// request size the profile produces over the measured throughput; sizes
+// are learned per profile, starting from its payload_pct.
+
+// Target wall time for a face-verify request
+#define CAPTURE_UPLOAD_BUDGET_MS 1500
+// Share of the budget a better profile must be predicted to fit before
+// climbing to it, or with low server confidence
+#define CAPTURE_CLIMB_PCT 50
+#define CAPTURE_CLIMB_LOW_CONFIDENCE_PCT 80
+// Consecutive observations needed before changing profile
+#define CAPTURE_TUNING_HYSTERESIS 3
+
+struct CaptureTuningStats {
+  float kbps;          // Smoothed request throughput, server time included
+  float request_ms;    // Smoothed face-verify wall time
+  float confidence;    // Smoothed server confidence
+  int profile;         // Current camera profile (0 = best quality)
+  unsigned long changes;
+};
+
+void capture_tuning_observe(size_t request_bytes, unsigned long request_ms, float confidence, float min_confidence);
+void capture_tuning_observe_timeout();
+int capture_tuning_target_profile();
+CaptureTuningStats capture_tuning_get_stats();
+
+#endif
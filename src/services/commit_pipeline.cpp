@@ -0,0 +1,215 @@
+#include "commit_pipeline.h"
+#include "../storage/transaction_cache.h"
+#include "../services/api_client.h"
+#include "../services/offline_service.h"
+#include "../services/fraud_window.h"
+#include "../services/hub_service.h"
+#include "../services/peer_sync.h"
+#include "../services/student_profile.h"
+#include "../utils/event_bus.h"
+#include "../utils/trace.h"
+#include "../utils/logger.h"
+
+// FIFO ring of accepted transactions. A slot is released only after its
+// cache write, so every transaction is always visible either here or in
+// the cache to the double-serving checks.
+Transaction commit_ring[COMMIT_PIPELINE_DEPTH];
+int commit_head = 0;
+int commit_count = 0;
+SemaphoreHandle_t commit_mutex = NULL;
+TaskHandle_t commit_task = NULL;
+volatile bool commit_sync_requested = false;
+
+CommitPipelineStats commit_stats = {0, 0, 0, 0, 0};
+unsigned long commit_total_ms = 0;
+
+static bool pipeline_peek(Transaction& t) {
+  bool found = false;
+  xSemaphoreTake(commit_mutex, portMAX_DELAY);
+  if (commit_count > 0) {
+    t = commit_ring[commit_head];
+    found = true;
+  }
+  xSemaphoreGive(commit_mutex);
+  return found;
+}
+
+static void pipeline_pop() {
+  xSemaphoreTake(commit_mutex, portMAX_DELAY);
+  if (commit_count > 0) {
+    commit_ring[commit_head] = Transaction();
+    commit_head = (commit_head + 1) % COMMIT_PIPELINE_DEPTH;
+    commit_count--;
+  }
+  xSemaphoreGive(commit_mutex);
+}
+
+static void commit_transaction(Transaction t, bool in_ring) {
+  unsigned long start = millis();
+
+  uint32_t cache_start = trace_begin();
+  cache_add_transaction(t);
+  profile_update(t);
+  trace_end(TRACE_CACHE_WRITE, cache_start);
+  if (in_ring) {
+    pipeline_pop(); // Now visible through the cache
+    event_post(EVENT_COMMITTED);
+  }
+
+  if (hub_is_active()) {
+    // This terminal is the hub: queued with everyone else's, and marked
+    // synced only once the server acknowledges it
+    hub_submit(t);
+  } else if (api_is_connected()) {
+    uint32_t upload_start = trace_begin();
+    bool logged = api_log_transaction(t);
+    trace_end(TRACE_LOG_UPLOAD, upload_start);
+    if (logged) {
+      cache_mark_synced(t.id);
+    }
+  } else {
+    // Queue for offline sync
+    queue_offline_transaction(t);
+  }
+
+  commit_total_ms += millis() - start;
+  commit_stats.committed++;
+  commit_stats.avg_commit_ms = commit_total_ms / commit_stats.committed;
+}
+
+bool commit_pipeline_service() {
+  bool worked = false;
+
+  // Drain in submission order
+  Transaction t;
+  while (pipeline_peek(t)) {
+    commit_transaction(t, true);
+    worked = true;
+  }
+
+  // The offline queue is only touched from the storage task once it is
+  // attached. One chunk per pass, so new commits are not held behind a
+  // long backlog.
+  if (commit_sync_requested) {
+    commit_sync_requested = false;
+    if (sync_offline_transactions() && commit_task != NULL) {
+      commit_sync_requested = true;
+      xTaskNotifyGive(commit_task);
+    }
+    worked = true;
+  }
+
+  return worked;
+}
+
+bool commit_pipeline_init() {
+  if (commit_mutex != NULL) {
+    return true;
+  }
+
+  commit_mutex = xSemaphoreCreateMutex();
+  if (commit_mutex == NULL) {
+    Logger::logError("Commit Pipeline: Mutex allocation failed");
+    return false;
+  }
+
+  Logger::logInfo("Commit Pipeline: Initialized (depth " + String(COMMIT_PIPELINE_DEPTH) + ")");
+  return true;
+}
+
+void commit_pipeline_attach(TaskHandle_t worker) {
+  commit_task = worker;
+}
+
+bool commit_pipeline_submit(Transaction t) {
+  if (commit_mutex == NULL) {
+    // Not initialized: plain synchronous commit
+    commit_stats.submitted++;
+    fraud_window_record(t);
+    peer_sync_publish(t);
+    commit_transaction(t, false);
+    return true;
+  }
+
+  xSemaphoreTake(commit_mutex, portMAX_DELAY);
+  if (commit_count >= COMMIT_PIPELINE_DEPTH) {
+    commit_stats.stalls++;
+    xSemaphoreGive(commit_mutex);
+    return false;
+  }
+
+  commit_ring[(commit_head + commit_count) % COMMIT_PIPELINE_DEPTH] = t;
+  commit_count++;
+  commit_stats.submitted++;
+  if (commit_count > commit_stats.max_in_flight) {
+    commit_stats.max_in_flight = commit_count;
+  }
+  xSemaphoreGive(commit_mutex);
+
+  // The fraud rules see it from now on, before the cache write, and so do
+  // the other terminals
+  fraud_window_record(t);
+  peer_sync_publish(t);
+
+  if (commit_task != NULL) {
+    xTaskNotifyGive(commit_task);
+  } else {
+    commit_transaction(t, true);
+  }
+  return true;
+}
+
+int commit_pipeline_in_flight() {
+  if (commit_mutex == NULL) {
+    return 0;
+  }
+
+  xSemaphoreTake(commit_mutex, portMAX_DELAY);
+  int count = commit_count;
+  xSemaphoreGive(commit_mutex);
+  return count;
+}
+
+std::vector<Transaction> commit_pipeline_pending() {
+  std::vector<Transaction> result;
+  if (commit_mutex == NULL) {
+    return result;
+  }
+
+  xSemaphoreTake(commit_mutex, portMAX_DELAY);
+  for (int i = 0; i < commit_count; i++) {
+    result.push_back(commit_ring[(commit_head + i) % COMMIT_PIPELINE_DEPTH]);
+  }
+  xSemaphoreGive(commit_mutex);
+  return result;
+}
+
+void commit_pipeline_sync_offline() {
+  if (hub_is_active()) {
+    return;  // The hub's network task sends the queue (hub_service)
+  }
+  if (commit_task != NULL) {
+    commit_sync_requested = true;
+    xTaskNotifyGive(commit_task);
+  } else {
+    while (sync_offline_transactions()) {
+    }
+  }
+}
+
+CommitPipelineStats commit_pipeline_get_stats() {
+  return commit_stats;
+}
+
+void commit_pipeline_log_stats() {
+  if (commit_stats.submitted == 0) {
+    return;
+  }
+
+  Logger::logf("[INFO] Commit Pipeline: %lu committed, %d in flight (max %d), %lu stalls, avg %lums",
+               commit_stats.committed,
+               commit_pipeline_in_flight(),
+               commit_stats.max_in_flight,
+               commit_stats.stalls,
+               commit_stats.avg_commit_ms);
+}
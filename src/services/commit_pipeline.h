@@ -0,0 +1,32 @@
+#ifndef COMMIT_PIPELINE_H
+#define COMMIT_PIPELINE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../config/data_types.h"
+
+// Transactions accepted but not yet written to the cache. When the ring is
+// full the state machine holds the next student until a slot frees up.
+#define COMMIT_PIPELINE_DEPTH 4
+
+struct CommitPipelineStats {
+  unsigned long submitted;
+  unsigned long committed;
+  unsigned long stalls;        // Submits refused because the ring was full
+  int max_in_flight;
+  unsigned long avg_commit_ms; // Cache write + server log, per transaction
+};
+
+bool commit_pipeline_init();
+// The storage task attaches itself and calls commit_pipeline_service() when
+// notified. Until a worker is attached, submits commit inline.
+void commit_pipeline_attach(TaskHandle_t worker);
+bool commit_pipeline_service();
+bool commit_pipeline_submit(Transaction t);
+int commit_pipeline_in_flight();
+std::vector<Transaction> commit_pipeline_pending();
+void commit_pipeline_sync_offline();
+CommitPipelineStats commit_pipeline_get_stats();
+void commit_pipeline_log_stats();
+
+#endif
@@ -0,0 +1,80 @@
+#include "frame_quality.h"
+#include "../utils/logger.h"
+
+FrameQualityStats quality_stats = {0, 0, 0, 0, 0, 0, 0};
+
+FrameQuality frame_quality_assess(const LumaImage& img) {
+  unsigned long start = micros();
+
+  FrameQuality q;
+  q.verdict = FRAME_OK;
+  q.sharpness = 0.0;
+  q.face.size = 0;
+  q.face.score = 0.0;
+
+  // Cheapest checks first, stop at the first failure
+  q.brightness = image_mean_brightness(img);
+  if (q.brightness < QUALITY_MIN_BRIGHTNESS) {
+    q.verdict = FRAME_TOO_DARK;
+  } else if (q.brightness > QUALITY_MAX_BRIGHTNESS) {
+    q.verdict = FRAME_TOO_BRIGHT;
+  } else {
+    q.sharpness = image_laplacian_variance(img);
+    if (q.sharpness < QUALITY_MIN_SHARPNESS) {
+      q.verdict = FRAME_BLURRED;
+    } else if (!image_find_face(img, QUALITY_MIN_FACE_SCORE, q.face)) {
+      q.verdict = FRAME_NO_FACE;
+    }
+  }
+
+  q.assess_us = micros() - start;
+
+  quality_stats.assessed++;
+  quality_stats.total_assess_us += q.assess_us;
+  switch (q.verdict) {
+    case FRAME_OK: quality_stats.accepted++; break;
+    case FRAME_TOO_DARK: quality_stats.too_dark++; break;
+    case FRAME_TOO_BRIGHT: quality_stats.too_bright++; break;
+    case FRAME_BLURRED: quality_stats.blurred++; break;
+    case FRAME_NO_FACE: quality_stats.no_face++; break;
+  }
+
+  return q;
+}
+
+String frame_quality_verdict_string(FrameVerdict verdict) {
+  switch (verdict) {
+    case FRAME_OK: return "OK";
+    case FRAME_TOO_DARK: return "TOO_DARK";
+    case FRAME_TOO_BRIGHT: return "TOO_BRIGHT";
+    case FRAME_BLURRED: return "BLURRED";
+    case FRAME_NO_FACE: return "NO_FACE";
+    default: return "UNKNOWN";
+  }
+}
+
+String frame_quality_user_hint(FrameVerdict verdict) {
+  switch (verdict) {
+    case FRAME_TOO_DARK: return "Step into light";
+    case FRAME_TOO_BRIGHT: return "Too bright";
+    case FRAME_BLURRED: return "Hold still";
+    case FRAME_NO_FACE: return "Look at camera";
+    default: return "Capturing Face";
+  }
+}
+
+FrameQualityStats frame_quality_get_stats() {
+  return quality_stats;
+}
+
+void frame_quality_log_stats() {
+  if (quality_stats.assessed == 0) {
+    return;
+  }
+
+  Logger::logf("[INFO] Frame Quality: %lu assessed, %lu ok, dark %lu, bright %lu, blur %lu, no face %lu, avg %lu us",
+               quality_stats.assessed, quality_stats.accepted,
+               quality_stats.too_dark, quality_stats.too_bright,
+               quality_stats.blurred, quality_stats.no_face,
+               quality_stats.total_assess_us / quality_stats.assessed);
+}
@@ -0,0 +1,45 @@
+#ifndef FRAME_QUALITY_H
+#define FRAME_QUALITY_H
+
+#include <Arduino.h>
+#include "../utils/image_utils.h"
+
+// Thresholds are tuned for the 1/8-scale luma image
+#define QUALITY_MIN_BRIGHTNESS 45
+#define QUALITY_MAX_BRIGHTNESS 215
+#define QUALITY_MIN_SHARPNESS 30.0
+#define QUALITY_MIN_FACE_SCORE 0.35
+
+enum FrameVerdict {
+  FRAME_OK,
+  FRAME_TOO_DARK,
+  FRAME_TOO_BRIGHT,
+  FRAME_BLURRED,
+  FRAME_NO_FACE
+};
+
+struct FrameQuality {
+  FrameVerdict verdict;
+  uint8_t brightness;
+  float sharpness;
+  FaceBox face;
+  unsigned long assess_us;
+};
+
+struct FrameQualityStats {
+  unsigned long assessed;
+  unsigned long accepted;
+  unsigned long too_dark;
+  unsigned long too_bright;
+  unsigned long blurred;
+  unsigned long no_face;
+  unsigned long total_assess_us;
+};
+
+FrameQuality frame_quality_assess(const LumaImage& img);
+String frame_quality_verdict_string(FrameVerdict verdict);
+String frame_quality_user_hint(FrameVerdict verdict);
+FrameQualityStats frame_quality_get_stats();
+void frame_quality_log_stats();
+
+#endif
@@ -1,129 +1,325 @@
 #include "fraud_detection.h"
-#include "../storage/transaction_cache.h"
+#include "fraud_window.h"
+#include "student_profile.h"
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 #include "../config/data_types.h"
-#include <vector>
 
-FraudCheckResult check_all_fraud_rules(String rfid_uid,
-                                       FaceVerificationResult fvr, 
-                                       std::vector<Transaction> recent_txns) {
+// Credential and biometric mismatch (RFID says student A, face says B) are
+// decided by the backend: a mismatch never reaches here as a success.
+
+// Ordered by precedence for the reported reason
+enum FraudAction : uint8_t {
+  FRAUD_FLAG,   // Raises severity only
+  FRAUD_REFER,  // Manager approval required
+  FRAUD_DENY    // Transaction is denied; only deny rules run after it
+};
+
+struct FraudRuleContext {
+  const FaceVerificationResult& fvr;
+  const FraudThresholds& thresholds;
+  FraudWindowCounts window;
+  bool window_loaded;
+  ProfileScore profile;
+  bool profile_loaded;
+  uint32_t hits;  // Bit per FraudRuleId
+  bool denied;
+  bool timed;
+};
+
+typedef bool (*FraudPredicate)(FraudRuleContext& ctx);
+
+struct FraudRule {
+  const char* name;
+  FraudPredicate predicate;
+  uint8_t severity;  // 1=warning, 2=critical
+  FraudAction action;
+  uint8_t cost;      // Relative: 1 field compare, 2 string compare, 8 window lookup, 12 profile score
+};
+
+FraudThresholds fraud_thresholds = {0.60, 0.75, 100.0, 6 * 3600, 600, 3, 40, 70};
+FraudRuleStats fraud_rule_stats[FRAUD_RULE_COUNT];
+unsigned long fraud_checks = 0;
+
+// ---- Predicates ----
+
+// Both history rules share one lookup, made only if a rule needs it
+static const FraudWindowCounts& rule_window(FraudRuleContext& ctx) {
+  if (!ctx.window_loaded) {
+    ctx.window = fraud_window_counts(ctx.fvr.student_id, ctx.thresholds.serve_window_sec,
+                                     ctx.thresholds.deny_window_sec);
+    ctx.window_loaded = true;
+  }
+  return ctx.window;
+}
+
+static const ProfileScore& rule_profile(FraudRuleContext& ctx) {
+  if (!ctx.profile_loaded) {
+    // No wall time, no hour to compare: the profile stays out of the decision
+    unsigned long now;
+    if (clock_to_wall(clock_seconds(), now)) {
+      ctx.profile = profile_score(ctx.fvr.student_id, ctx.fvr.confidence, now);
+    } else {
+      ctx.profile = {0, 0, 0, 0};
+    }
+    ctx.profile_loaded = true;
+  }
+  return ctx.profile;
+}
+
+static bool rule_double_serving(FraudRuleContext& ctx) {
+  return rule_window(ctx).served >= 1;
+}
+
+static bool rule_low_confidence_deny(FraudRuleContext& ctx) {
+  return ctx.fvr.confidence < ctx.thresholds.deny_confidence;
+}
+
+static bool rule_low_confidence_approval(FraudRuleContext& ctx) {
+  return (ctx.fvr.confidence >= ctx.thresholds.deny_confidence) &
+         (ctx.fvr.confidence < ctx.thresholds.approval_confidence);
+}
+
+static bool rule_insufficient_balance(FraudRuleContext& ctx) {
+  return ctx.fvr.balance <= 0;
+}
+
+static bool rule_low_balance_warning(FraudRuleContext& ctx) {
+  return (ctx.fvr.balance > 0) & (ctx.fvr.balance < ctx.thresholds.min_meal_cost);
+}
+
+static bool rule_rapid_attempts(FraudRuleContext& ctx) {
+  return rule_window(ctx).denied >= ctx.thresholds.max_denials;
+}
+
+static bool rule_meal_plan_inactive(FraudRuleContext& ctx) {
+  return ctx.fvr.meal_plan != "active";
+}
+
+static bool rule_already_served(FraudRuleContext& ctx) {
+  return ctx.fvr.already_served;
+}
+
+static bool rule_not_eligible(FraudRuleContext& ctx) {
+  return !ctx.fvr.eligible;
+}
+
+static bool rule_anomaly_warning(FraudRuleContext& ctx) {
+  int score = rule_profile(ctx).score;
+  return (score >= ctx.thresholds.anomaly_warning_score) & (score < ctx.thresholds.anomaly_alert_score);
+}
+
+static bool rule_anomaly_alert(FraudRuleContext& ctx) {
+  return rule_profile(ctx).score >= ctx.thresholds.anomaly_alert_score;
+}
+
+// ---- Rule table, indexed by FraudRuleId ----
+
+static constexpr FraudRule FRAUD_RULES[FRAUD_RULE_COUNT] = {
+  {"DOUBLE_SERVING",          rule_double_serving,          2, FRAUD_DENY,  8},
+  {"LOW_CONFIDENCE_DENY",     rule_low_confidence_deny,     2, FRAUD_DENY,  1},
+  {"LOW_CONFIDENCE_APPROVAL", rule_low_confidence_approval, 1, FRAUD_REFER, 1},
+  {"INSUFFICIENT_BALANCE",    rule_insufficient_balance,    2, FRAUD_DENY,  1},
+  {"LOW_BALANCE_WARNING",     rule_low_balance_warning,     1, FRAUD_REFER, 1},
+  {"RAPID_ATTEMPTS",          rule_rapid_attempts,          2, FRAUD_REFER, 8},
+  {"MEAL_PLAN_INACTIVE",      rule_meal_plan_inactive,      2, FRAUD_DENY,  2},
+  {"ALREADY_SERVED",          rule_already_served,          2, FRAUD_DENY,  1},
+  {"NOT_ELIGIBLE",            rule_not_eligible,            2, FRAUD_DENY,  1},
+  {"ANOMALY_WARNING",         rule_anomaly_warning,         1, FRAUD_FLAG,  12},
+  {"ANOMALY_ALERT",           rule_anomaly_alert,           2, FRAUD_FLAG,  12},
+};
+
+static_assert(FRAUD_RULE_COUNT <= 32, "hit mask is 32 bits");
+
+// Evaluation position of rule i: cheaper first, ties keep table order
+static constexpr int fraud_rank(int i, int j = 0) {
+  return j == FRAUD_RULE_COUNT ? 0 :
+         (int)(FRAUD_RULES[j].cost < FRAUD_RULES[i].cost ||
+               (FRAUD_RULES[j].cost == FRAUD_RULES[i].cost && j < i)) + fraud_rank(i, j + 1);
+}
+
+static constexpr int fraud_rule_at(int pos, int i = 0) {
+  return fraud_rank(i) == pos ? i : fraud_rule_at(pos, i + 1);
+}
+
+static_assert(FRAUD_RULES[fraud_rule_at(FRAUD_RULE_COUNT - 1)].cost >= FRAUD_RULES[fraud_rule_at(0)].cost,
+              "evaluation order is cheapest first");
+
+// The table unrolled in evaluation order. Each pass calls its predicate
+// directly and folds the result into the hit mask. Once a rule denies, the
+// refer and flag rules after it are skipped (the profile score with them),
+// but every deny rule still runs: the reason is picked by priority from the
+// hit mask, and each deny rule's hit count stays exact.
+template <int Pos>
+struct FraudPass {
+  static void run(FraudRuleContext& ctx) {
+    constexpr int id = fraud_rule_at(Pos);
+    if (FRAUD_RULES[id].action != FRAUD_DENY && ctx.denied) {
+      FraudPass<Pos + 1>::run(ctx);
+      return;
+    }
+    FraudRuleStats& stats = fraud_rule_stats[id];
+    bool hit;
+    if (ctx.timed) {
+      uint32_t start = ESP.getCycleCount();
+      hit = FRAUD_RULES[id].predicate(ctx);
+      stats.cycles += ESP.getCycleCount() - start;
+      stats.timed++;
+    } else {
+      hit = FRAUD_RULES[id].predicate(ctx);
+    }
+
+    stats.evaluated++;
+    stats.hits += hit;
+    ctx.hits |= (uint32_t)hit << id;
+    ctx.denied |= hit & (FRAUD_RULES[id].action == FRAUD_DENY);
+    FraudPass<Pos + 1>::run(ctx);
+  }
+};
+
+template <>
+struct FraudPass<FRAUD_RULE_COUNT> {
+  static void run(FraudRuleContext& ctx) {
+    (void)ctx;
+  }
+};
+
+static String rule_reason(int id, const FraudRuleContext& ctx) {
+  switch (id) {
+    case FRAUD_RULE_DOUBLE_SERVING:
+      return "Already served in last " + String(ctx.thresholds.serve_window_sec / 3600) +
+             " hours (Double-serving detected)";
+    case FRAUD_RULE_LOW_CONFIDENCE_DENY:
+      return "Face confidence too low (" + String(ctx.fvr.confidence, 2) + ")";
+    case FRAUD_RULE_LOW_CONFIDENCE_APPROVAL:
+      return "Low face confidence (" + String(ctx.fvr.confidence, 2) + ")";
+    case FRAUD_RULE_INSUFFICIENT_BALANCE:
+      return "Insufficient balance";
+    case FRAUD_RULE_LOW_BALANCE_WARNING:
+      return "Low balance (Rs. " + String(ctx.fvr.balance, 2) + ")";
+    case FRAUD_RULE_RAPID_ATTEMPTS:
+      return "Multiple failed attempts - Manager review required";
+    case FRAUD_RULE_MEAL_PLAN_INACTIVE:
+      return "Meal plan not active (" + ctx.fvr.meal_plan + ")";
+    case FRAUD_RULE_ALREADY_SERVED:
+      return "Already served today";
+    case FRAUD_RULE_NOT_ELIGIBLE:
+      return "Student not eligible";
+    case FRAUD_RULE_ANOMALY_WARNING:
+    case FRAUD_RULE_ANOMALY_ALERT:
+      return "Unusual visit pattern (score " + String(ctx.profile.score) + ": time " +
+             String(ctx.profile.time_points) + ", interval " + String(ctx.profile.interval_points) +
+             ", confidence " + String(ctx.profile.confidence_points) + ")";
+  }
+  return "";
+}
+
+void fraud_set_thresholds(FraudThresholds thresholds) {
+  // The window keeps the last FRAUD_WINDOW_DENIALS denials for 24 hours
+  thresholds.serve_window_sec = constrain(thresholds.serve_window_sec, 1UL, 24UL * 3600);
+  thresholds.deny_window_sec = constrain(thresholds.deny_window_sec, 1UL, 24UL * 3600);
+  thresholds.max_denials = constrain(thresholds.max_denials, 1, FRAUD_WINDOW_DENIALS);
+  thresholds.anomaly_alert_score = max(thresholds.anomaly_alert_score, thresholds.anomaly_warning_score);
+  fraud_thresholds = thresholds;
+  Logger::logf("[INFO] Fraud: confidence deny < %.2f, approval < %.2f, min balance Rs. %.0f, "
+               "serve window %lus, %d denials in %lus, anomaly %d/%d",
+               thresholds.deny_confidence, thresholds.approval_confidence, thresholds.min_meal_cost,
+               thresholds.serve_window_sec, thresholds.max_denials, thresholds.deny_window_sec,
+               thresholds.anomaly_warning_score, thresholds.anomaly_alert_score);
+}
+
+FraudThresholds fraud_get_thresholds() {
+  return fraud_thresholds;
+}
+
+FraudCheckResult check_all_fraud_rules(const String& rfid_uid,
+                                       const FaceVerificationResult& fvr) {
+  (void)rfid_uid;
   FraudCheckResult result;
   result.passes_all_rules = true;
   result.requires_approval = false;
   result.alert_reason = "";
   result.severity = 0;
   result.triggered_rules.clear();
-  
-  // Rule 1: Double-Serving Prevention - Check if student_id served in last 6 hours
-  unsigned long six_hours_ago = (millis() / 1000) - (6 * 3600);
-  int same_student_count = 0;
-  for (const Transaction& txn : recent_txns) {
-    if (txn.student_id == fvr.student_id && 
-        txn.status == "approved" && 
-        txn.timestamp >= six_hours_ago) {
-      same_student_count++;
-    }
-  }
-  
-  if (same_student_count >= 1) {
-    result.passes_all_rules = false;
-    result.alert_reason = "Already served in last 6 hours (Double-serving detected)";
-    result.severity = 2;
-    result.triggered_rules.push_back("DOUBLE_SERVING");
-    Logger::logError("Fraud: Double-serving detected for " + fvr.student_id);
-    return result;
-  }
-  
-  // Rule 2: Credential Mismatch - RFID UID doesn't match student record
-  // This is checked by the API, but we verify here too
-  if (rfid_uid.length() > 0 && fvr.student_id.length() > 0) {
-    // If API returned success, credentials match
-    // This rule is primarily handled by backend
-  }
-  
-  // Rule 3: Face Confidence Threshold
-  if (fvr.confidence < 0.60) {
-    result.passes_all_rules = false;
-    result.alert_reason = "Face confidence too low (" + String(fvr.confidence, 2) + ")";
-    result.severity = 2;
-    result.triggered_rules.push_back("LOW_CONFIDENCE_DENY");
-    Logger::logError("Fraud: Confidence too low - " + String(fvr.confidence, 2));
-    return result;
-  } else if (fvr.confidence < 0.75) {
-    result.requires_approval = true;
-    result.alert_reason = "Low face confidence (" + String(fvr.confidence, 2) + ")";
-    result.severity = 1;
-    result.triggered_rules.push_back("LOW_CONFIDENCE_APPROVAL");
-    Logger::logInfo("Fraud: Low confidence requires approval");
-  }
-  
-  // Rule 4: Insufficient Balance
-  const float MIN_MEAL_COST = 100.0; // Rs. 100 minimum
-  if (fvr.balance <= 0) {
-    result.passes_all_rules = false;
-    result.alert_reason = "Insufficient balance";
-    result.severity = 2;
-    result.triggered_rules.push_back("INSUFFICIENT_BALANCE");
-    Logger::logError("Fraud: Insufficient balance for " + fvr.student_id);
+
+  FraudRuleContext ctx = {fvr, fraud_thresholds, {0, 0, 0}, false, {0, 0, 0, 0}, false, 0, false,
+                          fraud_checks % FRAUD_TIMING_SAMPLE == 0};
+  FraudPass<0>::run(ctx);
+  fraud_checks++;
+  if (ctx.hits == 0) {
     return result;
-  } else if (fvr.balance < MIN_MEAL_COST) {
-    result.requires_approval = true;
-    result.alert_reason = "Low balance (Rs. " + String(fvr.balance, 2) + ")";
-    result.severity = 1;
-    result.triggered_rules.push_back("LOW_BALANCE_WARNING");
-    Logger::logInfo("Fraud: Low balance requires approval");
   }
-  
-  // Rule 5: Rapid Multiple Attempts - 3+ failed attempts in 10 minutes
-  int failed_attempts = 0;
-  unsigned long ten_min_ago = (millis() / 1000) - 600;
-  for (const Transaction& txn : recent_txns) {
-    if (txn.student_id == fvr.student_id && 
-        txn.timestamp >= ten_min_ago && 
-        (txn.status == "denied" || txn.status == "manual_denied")) {
-      failed_attempts++;
+
+  // Denial: the first denying rule in priority order gives the reason.
+  // Otherwise the last rule of the strongest action does, as the checks
+  // used to overwrite it.
+  int reason_rule = -1;
+  for (int id = 0; id < FRAUD_RULE_COUNT; id++) {
+    if (!(ctx.hits & (1UL << id))) {
+      continue;
+    }
+    const FraudRule& rule = FRAUD_RULES[id];
+    result.triggered_rules.push_back(rule.name);
+    result.severity = max(result.severity, (int)rule.severity);
+    if (rule.action == FRAUD_DENY) {
+      result.passes_all_rules = false;
+    } else if (rule.action == FRAUD_REFER) {
+      result.requires_approval = true;
+    }
+    if (reason_rule < 0 || rule.action > FRAUD_RULES[reason_rule].action ||
+        (rule.action == FRAUD_RULES[reason_rule].action && rule.action != FRAUD_DENY)) {
+      reason_rule = id;
     }
   }
-  
-  if (failed_attempts >= 3) {
-    result.requires_approval = true;
-    result.alert_reason = "Multiple failed attempts - Manager review required";
-    result.severity = 2;
-    result.triggered_rules.push_back("RAPID_ATTEMPTS");
-    Logger::logError("Fraud: Multiple failed attempts detected");
+
+  result.alert_reason = rule_reason(reason_rule, ctx);
+  if (result.severity >= 2) {
+    Logger::logError("Fraud: " + String(FRAUD_RULES[reason_rule].name) + " - " + result.alert_reason +
+                     " for " + fvr.student_id);
+  } else if (result.requires_approval) {
+    Logger::logInfo("Fraud: " + result.alert_reason + " requires approval");
+  } else {
+    Logger::logInfo("Fraud: " + result.alert_reason);
   }
-  
-  // Rule 6: Meal Plan Validation
-  if (fvr.meal_plan != "active") {
-    result.passes_all_rules = false;
-    result.alert_reason = "Meal plan not active (" + fvr.meal_plan + ")";
-    result.severity = 2;
-    result.triggered_rules.push_back("MEAL_PLAN_INACTIVE");
-    Logger::logError("Fraud: Meal plan not active");
-    return result;
+  return result;
+}
+
+const char* fraud_rule_name(FraudRuleId rule) {
+  return FRAUD_RULES[rule].name;
+}
+
+FraudRuleStats fraud_get_rule_stats(FraudRuleId rule) {
+  return fraud_rule_stats[rule];
+}
+
+unsigned long fraud_get_check_count() {
+  return fraud_checks;
+}
+
+void fraud_reset_stats() {
+  memset(fraud_rule_stats, 0, sizeof(fraud_rule_stats));
+  fraud_checks = 0;
+}
+
+void fraud_log_stats() {
+  // Rule 8 cannot fire on a boot-relative clock; say so rather than score 0 quietly
+  unsigned long wall;
+  if (!clock_to_wall(clock_seconds(), wall)) {
+    Logger::logf("[INFO] Fraud: anomaly scoring off until SNTP sets the clock, %lu serves not profiled",
+                 profile_get_stats().unsynced);
   }
-  
-  // Rule 7: Biometric Mismatch Alert (if RFID says Student A but face says Student B)
-  // This is primarily handled by backend API, but we log it here
-  if (fvr.already_served) {
-    result.passes_all_rules = false;
-    result.alert_reason = "Already served today";
-    result.severity = 2;
-    result.triggered_rules.push_back("ALREADY_SERVED");
-    Logger::logError("Fraud: Already served today");
-    return result;
+  if (fraud_checks == 0) {
+    return;
   }
-  
-  // Rule 7b: Eligibility Check
-  if (!fvr.eligible) {
-    result.passes_all_rules = false;
-    result.alert_reason = "Student not eligible";
-    result.severity = 2;
-    result.triggered_rules.push_back("NOT_ELIGIBLE");
-    Logger::logError("Fraud: Student not eligible");
-    return result;
+
+  float ns_per_cycle = 1000.0 / ESP.getCpuFreqMHz();
+  Logger::logf("[INFO] Fraud: %lu checks", fraud_checks);
+  for (int i = 0; i < FRAUD_RULE_COUNT; i++) {
+    const FraudRuleStats& s = fraud_rule_stats[i];
+    if (s.timed == 0) {
+      continue;
+    }
+    Logger::logf("[INFO] Fraud %-24s eval %6lu  hits %6lu  avg %7.0fns", FRAUD_RULES[i].name,
+                 s.evaluated, s.hits, s.cycles * ns_per_cycle / s.timed);
   }
-  
-  return result;
 }
-
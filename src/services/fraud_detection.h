@@ -2,12 +2,61 @@
 #define FRAUD_DETECTION_H
 
 #include <Arduino.h>
-#include <vector>
 #include "../config/data_types.h"
 
-FraudCheckResult check_all_fraud_rules(String rfid_uid,
-                                       FaceVerificationResult fvr, 
-                                       std::vector<Transaction> recent_txns);
+// Rules in priority order: when several deny, the reason reported is the
+// first one here. Evaluation order is by cost (see fraud_detection.cpp);
+// after a denial the remaining deny rules still run, the others do not.
+enum FraudRuleId {
+  FRAUD_RULE_DOUBLE_SERVING,
+  FRAUD_RULE_LOW_CONFIDENCE_DENY,
+  FRAUD_RULE_LOW_CONFIDENCE_APPROVAL,
+  FRAUD_RULE_INSUFFICIENT_BALANCE,
+  FRAUD_RULE_LOW_BALANCE_WARNING,
+  FRAUD_RULE_RAPID_ATTEMPTS,
+  FRAUD_RULE_MEAL_PLAN_INACTIVE,
+  FRAUD_RULE_ALREADY_SERVED,
+  FRAUD_RULE_NOT_ELIGIBLE,
+  FRAUD_RULE_ANOMALY_WARNING,
+  FRAUD_RULE_ANOMALY_ALERT,
+  FRAUD_RULE_COUNT
+};
+
+// Runtime thresholds, taken from SystemConfig at init
+struct FraudThresholds {
+  float deny_confidence;           // Below: deny
+  float approval_confidence;       // Below: manager approval
+  float min_meal_cost;             // Balance below: manager approval
+  unsigned long serve_window_sec;  // Double-serving window, at most 24 h
+  unsigned long deny_window_sec;   // Rapid-attempts window, at most 24 h
+  int max_denials;                 // Denials in the window that lock the card
+  int anomaly_warning_score;       // Profile score (0-100) raising severity to 1
+  int anomaly_alert_score;         // ... and to 2, flagging the transaction
+};
+
+// Every Nth check is timed, so the counter reads stay off most checks
+#define FRAUD_TIMING_SAMPLE 16
+
+struct FraudRuleStats {
+  unsigned long evaluated;  // Refer and flag rules are skipped after a denial
+  unsigned long hits;
+  unsigned long timed;      // Evaluations included in cycles
+  uint64_t cycles;          // CPU cycles spent in the predicate
+};
+
+void fraud_set_thresholds(FraudThresholds thresholds);
+FraudThresholds fraud_get_thresholds();
+
+// History rules read fraud_window aggregates, so transactions must be
+// recorded there (commit_pipeline_submit does) to count
+FraudCheckResult check_all_fraud_rules(const String& rfid_uid,
+                                       const FaceVerificationResult& fvr);
+
+const char* fraud_rule_name(FraudRuleId rule);
+FraudRuleStats fraud_get_rule_stats(FraudRuleId rule);
+unsigned long fraud_get_check_count();
+void fraud_reset_stats();
+void fraud_log_stats();
 
 #endif
 
@@ -0,0 +1,195 @@
+#include "fraud_window.h"
+#include "../storage/transaction_cache.h"
+#include "../utils/clock.h"
+#include "../utils/helpers.h"
+#include "../utils/logger.h"
+
+// Students idle for longer than this hold nothing any rule or the
+// served-today check can see, so their slots are free for reuse
+#define FRAUD_WINDOW_HORIZON_SEC (24 * 3600)
+
+// Timestamps are stored as seconds + 1 so that 0 can mean "none"
+struct FraudWindowSlot {
+  uint64_t key;  // FNV-1a of the student id, 0 for an empty slot
+  uint32_t served[FRAUD_WINDOW_SERVES];  // Counted serves only
+  uint32_t denied[FRAUD_WINDOW_DENIALS];
+  uint32_t last_served;                  // Newest serve of any kind, at or after every served[]
+};
+
+FraudWindowSlot fraud_slots[FRAUD_WINDOW_SLOTS];
+uint32_t fraud_latest_stamp = 0;
+FraudWindowStats fraud_window_stats = {0, 0, 0, 0};
+portMUX_TYPE fraud_window_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool is_denied_status(const String& status) {
+  return status == "denied" || status == "manual_denied";
+}
+
+static uint32_t newest_stamp(const FraudWindowSlot& slot) {
+  uint32_t newest = slot.last_served;
+  for (int i = 0; i < FRAUD_WINDOW_DENIALS; i++) {
+    newest = max(newest, slot.denied[i]);
+  }
+  return newest;
+}
+
+// Keeps the newest stamps: replaces the oldest one if this is newer. The
+// same transaction seen twice (cache rebuild after a sync) counts once.
+static void push_stamp(uint32_t* stamps, int count, uint32_t stamp) {
+  int oldest = 0;
+  for (int i = 0; i < count; i++) {
+    if (stamps[i] == stamp) {
+      return;
+    }
+    if (stamps[i] < stamps[oldest]) {
+      oldest = i;
+    }
+  }
+  if (stamp > stamps[oldest]) {
+    stamps[oldest] = stamp;
+  }
+}
+
+static int count_since(const uint32_t* stamps, int count, unsigned long since_sec) {
+  int n = 0;
+  for (int i = 0; i < count; i++) {
+    if (stamps[i] > since_sec) {
+      n++;
+    }
+  }
+  return n;
+}
+
+static FraudWindowSlot* find_slot(uint64_t key) {
+  for (int probe = 0; probe < FRAUD_WINDOW_PROBES; probe++) {
+    FraudWindowSlot& slot = fraud_slots[(key + probe) & (FRAUD_WINDOW_SLOTS - 1)];
+    if (slot.key == key) {
+      return &slot;
+    }
+  }
+  return NULL;
+}
+
+// Existing slot for the key, else an empty or expired one, else the one
+// idle the longest within the probe run
+static FraudWindowSlot* claim_slot(uint64_t key) {
+  FraudWindowSlot* found = find_slot(key);
+  if (found != NULL) {
+    return found;
+  }
+
+  unsigned long horizon = clock_window_start(FRAUD_WINDOW_HORIZON_SEC);
+  FraudWindowSlot* victim = NULL;
+  for (int probe = 0; probe < FRAUD_WINDOW_PROBES; probe++) {
+    FraudWindowSlot& slot = fraud_slots[(key + probe) & (FRAUD_WINDOW_SLOTS - 1)];
+    if (slot.key == 0) {
+      victim = &slot;
+      fraud_window_stats.students++;
+      break;
+    }
+    if (newest_stamp(slot) <= horizon) {
+      victim = &slot;
+      break;
+    }
+    if (victim == NULL || newest_stamp(slot) < newest_stamp(*victim)) {
+      victim = &slot;
+    }
+  }
+  if (victim->key != 0 && newest_stamp(*victim) > horizon) {
+    fraud_window_stats.evictions++;
+  }
+
+  memset(victim, 0, sizeof(*victim));
+  victim->key = key;
+  return victim;
+}
+
+void fraud_window_clear() {
+  portENTER_CRITICAL(&fraud_window_mux);
+  memset(fraud_slots, 0, sizeof(fraud_slots));
+  fraud_latest_stamp = 0;
+  fraud_window_stats.students = 0;
+  portEXIT_CRITICAL(&fraud_window_mux);
+}
+
+bool fraud_window_init() {
+  fraud_window_clear();
+  std::vector<Transaction> recent = cache_get_recent_transactions(FRAUD_WINDOW_HORIZON_SEC / 3600);
+  for (const Transaction& t : recent) {
+    fraud_window_record(t);
+  }
+  Logger::logInfo("Fraud Window: " + String(fraud_window_stats.students) + " students from " +
+                  String(recent.size()) + " cached transactions");
+  return true;
+}
+
+bool fraud_window_is_counted_serve(const String& status) {
+  return status == "approved";
+}
+
+// counted implies served; neither is a denial
+static void record_stamp(uint64_t key, unsigned long timestamp, bool served, bool counted) {
+  uint32_t stamp = timestamp + 1;
+
+  portENTER_CRITICAL(&fraud_window_mux);
+  FraudWindowSlot* slot = claim_slot(key);
+  if (counted) {
+    push_stamp(slot->served, FRAUD_WINDOW_SERVES, stamp);
+  }
+  if (served) {
+    slot->last_served = max(slot->last_served, stamp);
+  } else {
+    push_stamp(slot->denied, FRAUD_WINDOW_DENIALS, stamp);
+  }
+  fraud_latest_stamp = max(fraud_latest_stamp, stamp);
+  fraud_window_stats.recorded++;
+  portEXIT_CRITICAL(&fraud_window_mux);
+}
+
+void fraud_window_record(const Transaction& t) {
+  bool served = Helpers::isServedStatus(t.status);
+  if (t.student_id.length() == 0 || (!served && !is_denied_status(t.status))) {
+    return;
+  }
+  record_stamp(Helpers::hashString(t.student_id), t.timestamp, served, fraud_window_is_counted_serve(t.status));
+}
+
+void fraud_window_record_served(uint64_t key, unsigned long timestamp) {
+  if (key == 0) {
+    return;
+  }
+  record_stamp(key, timestamp, true, true);
+}
+
+FraudWindowCounts fraud_window_counts(const String& student_id, unsigned long serve_window_sec,
+                                      unsigned long deny_window_sec) {
+  FraudWindowCounts counts = {0, 0, 0};
+  uint64_t key = Helpers::hashString(student_id);
+  unsigned long serve_since = clock_window_start(serve_window_sec);
+  unsigned long deny_since = clock_window_start(deny_window_sec);
+
+  portENTER_CRITICAL(&fraud_window_mux);
+  fraud_window_stats.lookups++;
+  FraudWindowSlot* slot = find_slot(key);
+  if (slot != NULL) {
+    counts.served = count_since(slot->served, FRAUD_WINDOW_SERVES, serve_since);
+    counts.denied = count_since(slot->denied, FRAUD_WINDOW_DENIALS, deny_since);
+    counts.last_served = slot->last_served > 0 ? slot->last_served - 1 : 0;
+  }
+  portEXIT_CRITICAL(&fraud_window_mux);
+  return counts;
+}
+
+bool fraud_window_has_activity_since(unsigned long since_sec) {
+  portENTER_CRITICAL(&fraud_window_mux);
+  bool active = fraud_latest_stamp > since_sec;
+  portEXIT_CRITICAL(&fraud_window_mux);
+  return active;
+}
+
+FraudWindowStats fraud_window_get_stats() {
+  portENTER_CRITICAL(&fraud_window_mux);
+  FraudWindowStats stats = fraud_window_stats;
+  portEXIT_CRITICAL(&fraud_window_mux);
+  return stats;
+}
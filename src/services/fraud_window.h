@@ -0,0 +1,51 @@
+#ifndef FRAUD_WINDOW_H
+#define FRAUD_WINDOW_H
+
+#include <Arduino.h>
+#include "../config/data_types.h"
+
+// Per-student sliding-window aggregates for the fraud rules, updated as
+// transactions are handed to the commit pipeline. A lookup is a hash probe
+// plus a few timestamp compares; the transaction history is never scanned
+// at decision time.
+
+#define FRAUD_SERVE_WINDOW_SEC (6 * 3600)  // Default double-serving window
+#define FRAUD_DENY_WINDOW_SEC 600          // Default rapid-attempts window
+#define FRAUD_WINDOW_SLOTS 1024            // Open-addressed table, power of two
+#define FRAUD_WINDOW_PROBES 8              // Slots tried before evicting
+#define FRAUD_WINDOW_SERVES 2              // Latest serves kept per student
+#define FRAUD_WINDOW_DENIALS 3             // Latest denials kept per student
+
+struct FraudWindowCounts {
+  int served;  // Auto-approved serves within the serve window (double-serving rule)
+  int denied;  // Denied or manager denied, within the deny window
+  unsigned long last_served;  // Any serve (Helpers::isServedStatus), seconds, 0 if none is known
+};
+
+struct FraudWindowStats {
+  unsigned long recorded;
+  unsigned long lookups;
+  unsigned long evictions;  // Live students pushed out of a full probe run
+  int students;
+};
+
+// Serves the double-serving rule counts: "approved" only, as the rule always
+// has. Manager approvals and overrides still set last_served.
+bool fraud_window_is_counted_serve(const String& status);
+
+// Rebuilds the table from the transaction cache
+bool fraud_window_init();
+void fraud_window_record(const Transaction& t);
+// A counted serve seen elsewhere (another terminal), by Helpers::hashString
+// key. Recording the same serve again is a no-op.
+void fraud_window_record_served(uint64_t key, unsigned long timestamp);
+// Windows up to 24 h; counts are capped at FRAUD_WINDOW_SERVES / _DENIALS
+FraudWindowCounts fraud_window_counts(const String& student_id,
+                                      unsigned long serve_window_sec = FRAUD_SERVE_WINDOW_SEC,
+                                      unsigned long deny_window_sec = FRAUD_DENY_WINDOW_SEC);
+// Anything recorded at or after since_sec, for any student
+bool fraud_window_has_activity_since(unsigned long since_sec);
+void fraud_window_clear();
+FraudWindowStats fraud_window_get_stats();
+
+#endif
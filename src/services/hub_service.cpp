@@ -0,0 +1,403 @@
+#include "hub_service.h"
+#include <ArduinoJson.h>
+#include <vector>
+#include "api_client.h"
+#include "offline_service.h"
+#include "fraud_detection.h"
+#include "fraud_window.h"
+#include "../storage/offline_queue.h"
+#include "../utils/clock.h"
+#include "../utils/helpers.h"
+#include "../utils/logger.h"
+
+#define HUB_SERVED_TODAY_SEC (24 * 3600)
+
+bool hub_active = false;
+TaskHandle_t hub_task = NULL;
+unsigned long hub_oldest_ms = 0;  // First arrival since the queue last drained, 0 if none
+unsigned long hub_retry_at = 0;
+
+HubRosterEntry* hub_roster = NULL;  // PSRAM, HUB_ROSTER_SLOTS entries
+portMUX_TYPE hub_roster_mux = portMUX_INITIALIZER_UNLOCKED;
+HubStats hub_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static HubRosterEntry* find_entry(uint64_t key) {
+  for (int probe = 0; probe < HUB_ROSTER_PROBES; probe++) {
+    HubRosterEntry& e = hub_roster[(key + probe) & (HUB_ROSTER_SLOTS - 1)];
+    if (e.key == key) {
+      return &e;
+    }
+  }
+  return NULL;
+}
+
+// Existing entry, else an empty slot, else the one updated longest ago
+static HubRosterEntry* claim_entry(uint64_t key) {
+  HubRosterEntry* found = find_entry(key);
+  if (found != NULL) {
+    return found;
+  }
+  HubRosterEntry* victim = NULL;
+  for (int probe = 0; probe < HUB_ROSTER_PROBES; probe++) {
+    HubRosterEntry& e = hub_roster[(key + probe) & (HUB_ROSTER_SLOTS - 1)];
+    if (e.key == 0) {
+      victim = &e;
+      hub_stats.roster_size++;
+      break;
+    }
+    if (victim == NULL || e.updated < victim->updated) {
+      victim = &e;
+    }
+  }
+  memset(victim, 0, sizeof(*victim));
+  victim->key = key;
+  return victim;
+}
+
+static void roster_record(const Transaction& t, unsigned long local_ts) {
+  if (hub_roster == NULL || t.rfid_uid.length() == 0 || t.student_id.length() == 0) {
+    return;
+  }
+  uint64_t key = Helpers::hashString(t.rfid_uid);
+
+  portENTER_CRITICAL(&hub_roster_mux);
+  HubRosterEntry* e = claim_entry(key);
+  if (local_ts >= e->updated) {
+    strncpy(e->student_id, t.student_id.c_str(), sizeof(e->student_id) - 1);
+    if (t.student_name.length() > 0) {
+      strncpy(e->student_name, t.student_name.c_str(), sizeof(e->student_name) - 1);
+    }
+    e->balance = t.balance_after;
+    e->updated = local_ts;
+  }
+  portEXIT_CRITICAL(&hub_roster_mux);
+}
+
+// Into the SPIFFS offline queue before anything is acknowledged, so a hub
+// reset loses nothing a terminal has let go of
+static bool enqueue(const Transaction& t) {
+  if (!offline_queue_append(t)) {
+    hub_stats.refused++;
+    return false;
+  }
+  if (hub_oldest_ms == 0) {
+    hub_oldest_ms = millis();
+  }
+
+  if (hub_task != NULL) {
+    xTaskNotifyGive(hub_task);
+  }
+  return true;
+}
+
+// A transaction from another terminal. Its clock is not ours: the age it
+// had when sent places it on this terminal's clock for the served-today set.
+static void accept_remote(Transaction t, unsigned long device_time) {
+  unsigned long now = clock_seconds();
+  unsigned long age = device_time > t.timestamp ? device_time - t.timestamp : 0;
+  unsigned long local_ts = now > age ? now - age : 0;
+
+  roster_record(t, local_ts);
+  Transaction local = t;
+  local.timestamp = local_ts;
+  fraud_window_record(local);
+  hub_stats.received++;
+}
+
+static Transaction from_log_json(JsonDocument& doc) {
+  Transaction t;
+  t.id = doc["id"] | "";
+  t.timestamp = doc["timestamp"] | 0UL;
+  t.student_id = doc["student_id"] | "";
+  t.student_name = doc["student_name"] | "";
+  t.rfid_uid = doc["rfid_uid"] | "";
+  t.status = doc["approval_status"] | "";
+  t.balance_before = doc["balance_before"] | 0.0f;
+  t.balance_after = doc["balance_after"] | 0.0f;
+  t.reason = doc["reason"] | "";
+  t.fraud_alert = doc["fraud_detected"] | false;
+  t.face_confidence = doc["face_confidence"] | 0.0f;
+  t.synced = false;
+  t.offline_mode = false;
+  return t;
+}
+
+static Transaction from_batch_json(JsonObject obj) {
+  Transaction t;
+  t.id = obj["id"] | "";
+  t.timestamp = obj["timestamp"] | 0UL;
+  t.student_id = obj["student_id"] | "";
+  t.student_name = obj["student_name"] | "";
+  t.rfid_uid = obj["rfid_uid"] | "";
+  t.status = obj["status"] | "";
+  t.balance_before = obj["balance_before"] | 0.0f;
+  t.balance_after = obj["balance_after"] | 0.0f;
+  t.reason = obj["reason"] | "";
+  t.fraud_alert = obj["fraud_alert"] | false;
+  t.face_confidence = obj["face_confidence"] | 0.0f;
+  t.synced = false;
+  t.offline_mode = true;
+  return t;
+}
+
+// Bodies arrive in chunks on the async web task; _tempObject is freed by
+// the request
+static void collect_body(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+                         size_t total) {
+  if (total > HUB_MAX_BODY) {
+    return;
+  }
+  if (index == 0) {
+    request->_tempObject = malloc(total + 1);
+  }
+  if (request->_tempObject != NULL) {
+    memcpy((char*)request->_tempObject + index, data, len);
+    if (index + len == total) {
+      ((char*)request->_tempObject)[total] = '\0';
+    }
+  }
+}
+
+static bool parse_body(AsyncWebServerRequest* request, JsonDocument& doc) {
+  return request->_tempObject != NULL &&
+         deserializeJson(doc, (const char*)request->_tempObject) == DeserializationError::Ok;
+}
+
+static void handle_log(AsyncWebServerRequest* request) {
+  JsonDocument doc;
+  if (!parse_body(request, doc)) {
+    request->send(400, "application/json", "{\"success\":false}");
+    return;
+  }
+  Transaction t = from_log_json(doc);
+  if (!enqueue(t)) {
+    request->send(503, "application/json", "{\"success\":false,\"error\":\"hub queue full\"}");
+    return;
+  }
+  accept_remote(t, doc["device_time"] | t.timestamp);
+  request->send(200, "application/json", "{\"success\":true}");
+}
+
+static void handle_sync_batch(AsyncWebServerRequest* request) {
+  JsonDocument doc;
+  if (!parse_body(request, doc)) {
+    request->send(400, "application/json", "{\"synced_count\":0}");
+    return;
+  }
+  JsonArray txns = doc["transactions"].as<JsonArray>();
+  unsigned long device_time = doc["device_time"] | 0UL;
+
+  // Taken in order until the queue is full; the terminal resumes from the
+  // first id missing from the acks
+  JsonDocument reply;
+  JsonArray acked = reply["acked"].to<JsonArray>();
+  int offered = txns.size();
+  for (JsonObject obj : txns) {
+    Transaction t = from_batch_json(obj);
+    if (!enqueue(t)) {
+      hub_stats.refused += offered - acked.size() - 1;  // enqueue counted this one
+      break;
+    }
+    accept_remote(t, device_time > 0 ? device_time : t.timestamp);
+    acked.add(t.id);
+  }
+  if (acked.size() == 0) {
+    request->send(503, "application/json", "{\"synced_count\":0}");
+    return;
+  }
+  reply["synced_count"] = acked.size();
+  String body;
+  serializeJson(reply, body);
+  request->send(200, "application/json", body);
+}
+
+static void handle_roster(AsyncWebServerRequest* request) {
+  const AsyncWebParameter* uid = request->getParam("uid");
+  String reply = uid != NULL ? hub_roster_lookup(uid->value()) : String();
+  if (reply.length() == 0) {
+    request->send(404, "application/json", "{\"status\":\"not_found\"}");
+    return;
+  }
+  request->send(200, "application/json", reply);
+}
+
+static void handle_served(AsyncWebServerRequest* request) {
+  const AsyncWebParameter* id = request->getParam("student_id");
+  if (id == NULL) {
+    request->send(400, "application/json", "{\"served\":0}");
+    return;
+  }
+  FraudWindowCounts counts = fraud_window_counts(id->value(), fraud_get_thresholds().serve_window_sec);
+  JsonDocument doc;
+  doc["student_id"] = id->value();
+  doc["served"] = counts.served;
+  doc["last_served_age"] = counts.last_served > 0 ? (long)(clock_seconds() - counts.last_served) : -1L;
+  String reply;
+  serializeJson(doc, reply);
+  request->send(200, "application/json", reply);
+}
+
+static void handle_status(AsyncWebServerRequest* request) {
+  HubStats stats = hub_get_stats();
+  JsonDocument doc;
+  doc["queued"] = stats.queued;
+  doc["received"] = stats.received;
+  doc["forwarded"] = stats.forwarded;
+  doc["refused"] = stats.refused;
+  doc["upstream_failures"] = stats.upstream_failures;
+  doc["roster_size"] = stats.roster_size;
+  String reply;
+  serializeJson(doc, reply);
+  request->send(200, "application/json", reply);
+}
+
+bool hub_begin(AsyncWebServer* server) {
+  if (hub_active) {
+    return true;
+  }
+  if (server == NULL) {
+    Logger::logError("Hub: No status server to attach to");
+    return false;
+  }
+
+  hub_roster = (HubRosterEntry*)ps_malloc(HUB_ROSTER_SLOTS * sizeof(HubRosterEntry));
+  if (hub_roster == NULL) {
+    Logger::logError("Hub: Allocation failed");
+    return false;
+  }
+  memset(hub_roster, 0, HUB_ROSTER_SLOTS * sizeof(HubRosterEntry));
+
+  server->on("/api/transactions/log", HTTP_POST, handle_log, NULL, collect_body);
+  server->on("/api/transactions/sync-batch", HTTP_POST, handle_sync_batch, NULL, collect_body);
+  server->on("/hub/roster", HTTP_GET, handle_roster);
+  server->on("/hub/served", HTTP_GET, handle_served);
+  server->on("/hub/status", HTTP_GET, handle_status);
+
+  // Left from before a restart: send without waiting for more
+  if (offline_queue_pending() > 0) {
+    hub_oldest_ms = millis() - HUB_FLUSH_MS;
+  }
+  hub_active = true;
+  Logger::logInfo("Hub: Serving roster and relaying transactions upstream");
+  return true;
+}
+
+bool hub_is_active() {
+  return hub_active;
+}
+
+void hub_attach(TaskHandle_t worker) {
+  hub_task = worker;
+}
+
+bool hub_submit(const Transaction& t) {
+  if (!hub_active || !enqueue(t)) {
+    return false;
+  }
+  roster_record(t, t.timestamp);
+  return true;
+}
+
+String hub_roster_lookup(const String& rfid_uid) {
+  if (hub_roster == NULL) {
+    return "";
+  }
+  uint64_t key = Helpers::hashString(rfid_uid);
+
+  portENTER_CRITICAL(&hub_roster_mux);
+  HubRosterEntry* found = find_entry(key);
+  HubRosterEntry e;
+  if (found != NULL) {
+    e = *found;
+  }
+  portEXIT_CRITICAL(&hub_roster_mux);
+  if (found == NULL) {
+    hub_stats.roster_misses++;
+    return "";
+  }
+  hub_stats.roster_hits++;
+
+  // Served today by any terminal that reports here or multicasts its serves
+  FraudWindowCounts counts = fraud_window_counts(e.student_id);
+  bool served_today = counts.last_served > 0 &&
+                      counts.last_served >= clock_window_start(HUB_SERVED_TODAY_SEC);
+
+  JsonDocument doc;
+  doc["status"] = "success";
+  doc["student_id"] = e.student_id;
+  doc["student_name"] = e.student_name;
+  doc["confidence"] = 0.0;
+  doc["eligible"] = true;
+  doc["balance"] = e.balance;
+  doc["meal_plan"] = "unknown";
+  doc["already_served_today"] = served_today;
+  doc["approval_required"] = true;
+  doc["reason"] = "Server unreachable - identity from hub roster";
+  String reply;
+  serializeJson(doc, reply);
+  return reply;
+}
+
+unsigned long hub_service() {
+  if (!hub_active) {
+    return 0;
+  }
+
+  int count = offline_queue_pending();
+  if (count == 0) {
+    hub_oldest_ms = 0;
+    return 0;
+  }
+  if (hub_oldest_ms == 0) {
+    hub_oldest_ms = millis();
+  }
+  if ((long)(hub_retry_at - millis()) > 0) {
+    return hub_retry_at - millis();
+  }
+  // Wait a little for a fuller batch
+  unsigned long waited = millis() - hub_oldest_ms;
+  if (count < HUB_BATCH_SIZE && waited < HUB_FLUSH_MS) {
+    return HUB_FLUSH_MS - waited;
+  }
+  if (!api_is_connected()) {
+    return HUB_RETRY_MS;
+  }
+
+  // One upstream connection for the whole hall, one chunk per call. The
+  // queue head only moves past what the server acknowledged.
+  unsigned long acknowledged = offline_queue_get_stats().acknowledged;
+  bool more = sync_offline_transactions();
+  unsigned long sent = offline_queue_get_stats().acknowledged - acknowledged;
+  if (sent > 0) {
+    hub_stats.forwarded += sent;
+    hub_stats.batches++;
+  }
+  if (offline_queue_pending() == 0) {
+    hub_oldest_ms = 0;
+    return 0;
+  }
+  if (!more) {
+    // Refused, or acknowledged only in part: the rest goes again later
+    hub_stats.upstream_failures++;
+    hub_retry_at = millis() + HUB_RETRY_MS;
+    return HUB_RETRY_MS;
+  }
+  return 1;
+}
+
+HubStats hub_get_stats() {
+  HubStats stats = hub_stats;
+  stats.queued = offline_queue_pending();
+  return stats;
+}
+
+void hub_log_stats() {
+  if (!hub_active) {
+    return;
+  }
+  HubStats stats = hub_get_stats();
+  Logger::logf("[INFO] Hub: %lu received, %lu forwarded in %lu batches, %d queued, %lu refused, "
+               "%lu upstream failures, roster %d (%lu hits, %lu misses)",
+               stats.received, stats.forwarded, stats.batches, stats.queued, stats.refused,
+               stats.upstream_failures, stats.roster_size, stats.roster_hits, stats.roster_misses);
+}
@@ -0,0 +1,64 @@
+#ifndef HUB_SERVICE_H
+#define HUB_SERVICE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "../config/data_types.h"
+#include "offline_service.h"
+
+// Hub role: one terminal in the hall relays the others' transaction logs
+// and offline batches upstream in batches, and answers roster and
+// served-today lookups from its own tables when the server is slow or
+// gone. Relayed transactions are written to the offline queue in SPIFFS
+// before the hub acknowledges them. Routes on the status server:
+//   POST /api/transactions/log         same body as the server's
+//   POST /api/transactions/sync-batch  same body as the server's
+//   GET  /hub/roster?uid=<rfid>        face-verify shaped reply, approval required
+//   GET  /hub/served?student_id=<id>   serves within the double-serving window
+//   GET  /hub/status
+
+#define HUB_BATCH_SIZE OFFLINE_SYNC_CHUNK  // Per upstream sync-batch call
+#define HUB_FLUSH_MS 2000                  // Longest a transaction waits for a fuller batch
+#define HUB_RETRY_MS 10000                 // After an upstream failure
+#define HUB_ROSTER_SLOTS 512               // Power of two
+#define HUB_ROSTER_PROBES 8
+#define HUB_MAX_BODY (16 * 1024)
+
+struct HubRosterEntry {
+  uint64_t key;            // Helpers::hashString(rfid_uid), 0 if empty
+  char student_id[24];
+  char student_name[32];
+  float balance;           // After the student's latest transaction
+  uint32_t updated;        // Seconds timestamp of that transaction, hub clock
+};
+
+struct HubStats {
+  unsigned long received;        // Transactions from other terminals
+  unsigned long refused;         // Turned away with the queue full
+  unsigned long forwarded;       // Sent upstream
+  unsigned long batches;
+  unsigned long upstream_failures;
+  unsigned long roster_hits;
+  unsigned long roster_misses;
+  int queued;                    // Offline queue, the hub's own records included
+  int roster_size;
+};
+
+// Registers the routes; the terminal then acts as hub
+bool hub_begin(AsyncWebServer* server);
+bool hub_is_active();
+// The network task attaches itself and calls hub_service() when notified
+void hub_attach(TaskHandle_t worker);
+// This terminal's own transactions, in place of a log request to the
+// server. Queued in SPIFFS; the cache marks them synced once acknowledged.
+bool hub_submit(const Transaction& t);
+// Face-verify shaped JSON for the card, empty if the roster has no entry
+String hub_roster_lookup(const String& rfid_uid);
+// Upstream batching, from the network task so a slow server never holds
+// up the commit ring. Returns how soon it wants to run again in ms, 0 when
+// idle.
+unsigned long hub_service();
+HubStats hub_get_stats();
+void hub_log_stats();
+
+#endif
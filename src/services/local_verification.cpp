@@ -0,0 +1,212 @@
+#include "local_verification.h"
+#include <SPIFFS.h>
+#include "fraud_window.h"
+#include "../utils/clock.h"
+#include "../utils/logger.h"
+
+#define TEMPLATE_MAGIC 0x46545033 // "FTP3": face-box descriptor, with verify time
+#define TEMPLATE_PREFIX "/tpl_"
+
+struct FaceTemplateRecord {
+  uint32_t magic;
+  uint16_t samples;
+  uint8_t eligible;
+  uint8_t reserved;
+  float balance;
+  uint32_t verified_at;  // clock_seconds() of the server verify behind eligible and balance
+  uint32_t boot_tag;     // verified_at is uptime, so only comparable within one boot
+  char student_id[24];
+  char student_name[40];
+  char meal_plan[16];
+  FaceDescriptor descriptor;
+};
+
+bool local_verify_initialized = false;
+uint32_t local_boot_tag = 0;
+LocalVerifyStats local_stats = {0, 0, 0, 0, 0, 0, 0};
+
+static String template_path(String rfid_uid) {
+  return String(TEMPLATE_PREFIX) + rfid_uid;
+}
+
+static bool load_template(String rfid_uid, FaceTemplateRecord& record) {
+  String path = template_path(rfid_uid);
+  if (!SPIFFS.exists(path)) {
+    return false;
+  }
+
+  File file = SPIFFS.open(path, "r");
+  if (!file) {
+    return false;
+  }
+
+  size_t read = file.read((uint8_t*)&record, sizeof(record));
+  file.close();
+
+  return read == sizeof(record) && record.magic == TEMPLATE_MAGIC;
+}
+
+static bool store_template(String rfid_uid, const FaceTemplateRecord& record) {
+  File file = SPIFFS.open(template_path(rfid_uid), "w");
+  if (!file) {
+    Logger::logError("Local Verify: Failed to write template for " + rfid_uid);
+    return false;
+  }
+
+  size_t written = file.write((const uint8_t*)&record, sizeof(record));
+  file.close();
+  return written == sizeof(record);
+}
+
+static void copy_field(char* dst, size_t size, String value) {
+  strncpy(dst, value.c_str(), size - 1);
+  dst[size - 1] = '\0';
+}
+
+bool local_verify_init() {
+  if (local_verify_initialized) {
+    return true;
+  }
+
+  if (!SPIFFS.begin(true)) {
+    Logger::logError("Local Verify: SPIFFS init failed");
+    return false;
+  }
+
+  // Templates enrolled before this boot are stale until the server verifies again
+  local_boot_tag = (uint32_t)random(1, 0x7FFFFFFF) ^ (uint32_t)micros();
+  local_verify_initialized = true;
+  Logger::logInfo("Local Verify: Initialized");
+  return true;
+}
+
+void local_verify_derive_thresholds(SystemConfig& config) {
+  if (config.local_approve_similarity < 0.0) {
+    config.local_approve_similarity = min(config.min_face_confidence + (float)LOCAL_APPROVE_MARGIN, 0.99f);
+  }
+  if (config.local_reject_similarity < 0.0) {
+    config.local_reject_similarity = max(config.min_face_confidence - (float)LOCAL_REJECT_MARGIN, 0.0f);
+  }
+  Logger::logf("[INFO] Local Verify: approve at %.2f, reject below %.2f (0: off)",
+               config.local_approve_similarity, config.local_reject_similarity);
+}
+
+LocalMatchResult local_verify_match(String rfid_uid, const FaceDescriptor& descriptor, float approve_at,
+                                    float reject_below) {
+  LocalMatchResult result;
+  result.outcome = LOCAL_NO_TEMPLATE;
+  result.confidence = 0.0;
+  result.fvr.success = false;
+
+  local_stats.total++;
+
+  FaceTemplateRecord record;
+  if (!local_verify_initialized || !load_template(rfid_uid, record)) {
+    local_stats.no_template++;
+    return result;
+  }
+
+  result.confidence = image_descriptor_similarity(descriptor, record.descriptor);
+  unsigned long now = clock_seconds();
+  bool fresh = record.boot_tag == local_boot_tag && now >= record.verified_at &&
+               now - record.verified_at < LOCAL_TEMPLATE_MAX_AGE_SEC;
+
+  bool matched = approve_at > 0.0 && result.confidence >= approve_at;
+
+  if (matched && !fresh) {
+    result.outcome = LOCAL_FORWARD;
+    local_stats.stale++;
+  } else if (matched) {
+    result.outcome = LOCAL_APPROVE;
+    local_stats.approved++;
+
+    FaceVerificationResult& fvr = result.fvr;
+    fvr.success = true;
+    fvr.student_id = record.student_id;
+    fvr.student_name = record.student_name;
+    fvr.confidence = result.confidence;
+    fvr.eligible = record.eligible != 0;
+    fvr.balance = record.balance;
+    fvr.meal_plan = record.meal_plan;
+    // The window sees a serve from submit on, before it reaches the cache
+    unsigned long last_served = fraud_window_counts(fvr.student_id).last_served;
+    fvr.already_served = last_served > 0 && last_served >= clock_window_start(24 * 3600);
+    fvr.needs_approval = false;
+    fvr.reason = "Local match";
+  } else if (reject_below > 0.0 && result.confidence < reject_below) {
+    result.outcome = LOCAL_REJECT;
+    local_stats.rejected++;
+    result.fvr.reason = "Face does not match card (" + String(result.confidence, 2) + ")";
+  } else {
+    result.outcome = LOCAL_FORWARD;
+    local_stats.forwarded++;
+  }
+
+  Logger::logInfo("Local Verify: " + rfid_uid + " confidence " + String(result.confidence, 2));
+  return result;
+}
+
+bool local_verify_enroll(String rfid_uid, const FaceDescriptor& descriptor, FaceVerificationResult fvr) {
+  if (!local_verify_initialized || rfid_uid.length() == 0 || fvr.student_id.length() == 0) {
+    return false;
+  }
+
+  FaceTemplateRecord record;
+  if (load_template(rfid_uid, record) && fvr.student_id == record.student_id) {
+    image_blend_descriptor(record.descriptor, descriptor, record.samples);
+    if (record.samples < 0xFFFF) {
+      record.samples++;
+    }
+  } else {
+    // New card, or card re-issued to another student
+    memset(&record, 0, sizeof(record));
+    record.magic = TEMPLATE_MAGIC;
+    record.samples = 1;
+    record.descriptor = descriptor;
+  }
+
+  record.eligible = fvr.eligible ? 1 : 0;
+  record.balance = fvr.balance;
+  record.verified_at = clock_seconds();
+  record.boot_tag = local_boot_tag;
+  copy_field(record.student_id, sizeof(record.student_id), fvr.student_id);
+  copy_field(record.student_name, sizeof(record.student_name), fvr.student_name);
+  copy_field(record.meal_plan, sizeof(record.meal_plan), fvr.meal_plan);
+
+  if (!store_template(rfid_uid, record)) {
+    return false;
+  }
+
+  local_stats.enrolled++;
+  return true;
+}
+
+void local_verify_update_balance(String rfid_uid, float balance) {
+  FaceTemplateRecord record;
+  if (!local_verify_initialized || !load_template(rfid_uid, record)) {
+    return;
+  }
+
+  record.balance = balance;
+  store_template(rfid_uid, record);
+}
+
+LocalVerifyStats local_verify_get_stats() {
+  return local_stats;
+}
+
+void local_verify_log_stats() {
+  if (local_stats.total == 0) {
+    return;
+  }
+
+  float total = (float)local_stats.total;
+  Logger::logf("[INFO] Local Verify: %lu scans - approved %.0f%%, rejected %.0f%%, server %.0f%% "
+               "(no template %.0f%%, stale %.0f%%)",
+               local_stats.total,
+               local_stats.approved * 100.0 / total,
+               local_stats.rejected * 100.0 / total,
+               (local_stats.forwarded + local_stats.no_template + local_stats.stale) * 100.0 / total,
+               local_stats.no_template * 100.0 / total,
+               local_stats.stale * 100.0 / total);
+}
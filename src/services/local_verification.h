@@ -0,0 +1,56 @@
+#ifndef LOCAL_VERIFICATION_H
+#define LOCAL_VERIFICATION_H
+
+#include <Arduino.h>
+#include "../config/data_types.h"
+#include "../utils/image_utils.h"
+
+// The local score is the correlation of two 16x16 luma descriptors, not
+// the server's face-recognition confidence, and different students in the
+// same framing can score high on it. The approve and reject thresholds are
+// their own settings (local_approve_similarity and local_reject_similarity).
+// Left unset they follow min_face_confidence, with the approve side raised
+// by a margin; calibrate them on site from the logged scores, or set 0 to
+// turn a side off.
+#define LOCAL_APPROVE_MARGIN 0.10  // Approve at min_face_confidence + this
+#define LOCAL_REJECT_MARGIN 0.35   // Reject below min_face_confidence - this
+
+// Balance and eligibility in a template are the server's as of its last
+// verify; older than this, the scan goes to the server again
+#define LOCAL_TEMPLATE_MAX_AGE_SEC (24 * 3600)
+
+enum LocalMatchOutcome {
+  LOCAL_NO_TEMPLATE,  // Nothing cached for this card, server must decide
+  LOCAL_APPROVE,      // Confident local match, skip the server round trip
+  LOCAL_REJECT,       // Clearly a different face
+  LOCAL_FORWARD       // Ambiguous band, stale template, or threshold off
+};
+
+struct LocalMatchResult {
+  LocalMatchOutcome outcome;
+  float confidence;
+  FaceVerificationResult fvr; // Filled from the cached profile on LOCAL_APPROVE
+};
+
+struct LocalVerifyStats {
+  unsigned long total;
+  unsigned long approved;
+  unsigned long rejected;
+  unsigned long forwarded;
+  unsigned long no_template;
+  unsigned long stale;        // Forwarded because the template was too old
+  unsigned long enrolled;
+};
+
+bool local_verify_init();
+// Fills unset (negative) local thresholds from min_face_confidence
+void local_verify_derive_thresholds(SystemConfig& config);
+// approve_at / reject_below on the descriptor similarity scale, 0 for off
+LocalMatchResult local_verify_match(String rfid_uid, const FaceDescriptor& descriptor, float approve_at,
+                                    float reject_below);
+bool local_verify_enroll(String rfid_uid, const FaceDescriptor& descriptor, FaceVerificationResult fvr);
+void local_verify_update_balance(String rfid_uid, float balance);
+LocalVerifyStats local_verify_get_stats();
+void local_verify_log_stats();
+
+#endif
@@ -1,12 +1,15 @@
 #include "offline_service.h"
 #include "../storage/transaction_cache.h"
+#include "../storage/offline_queue.h"
 #include "../services/api_client.h"
 #include "../services/wifi_manager.h"
+#include "../services/fraud_window.h"
+#include "../services/fraud_detection.h"
+#include "../utils/clock.h"
 #include "../utils/logger.h"
 #include <vector>
 
 bool offline_mode_active = false;
-std::vector<Transaction> offline_queue;
 
 bool is_offline_mode() {
   offline_mode_active = !wifi_is_connected();
@@ -20,16 +23,9 @@ FraudCheckResult check_offline_eligibility(String student_id) {
   result.alert_reason = "Offline mode - Limited verification";
   result.severity = 1;
   
-  // Check local cache for double-serving (last 6 hours)
-  std::vector<Transaction> recent_txns = cache_get_recent_transactions(6);
-  int served_count = 0;
-  for (const Transaction& txn : recent_txns) {
-    if (txn.student_id == student_id && txn.status == "approved") {
-      served_count++;
-    }
-  }
-  
-  if (served_count >= 1) {
+  // Check local history for double-serving, same window as the fraud rules
+  unsigned long serve_window_sec = fraud_get_thresholds().serve_window_sec;
+  if (fraud_window_counts(student_id, serve_window_sec).served >= 1) {
     result.passes_all_rules = false;
     result.alert_reason = "Already served today (offline check)";
     result.severity = 2;
@@ -37,7 +33,7 @@ FraudCheckResult check_offline_eligibility(String student_id) {
   }
   
   // If no data available, require manager approval
-  if (recent_txns.size() == 0) {
+  if (!fraud_window_has_activity_since(clock_window_start(serve_window_sec))) {
     result.requires_approval = true;
     result.alert_reason = "No local data - Manager approval required";
     return result;
@@ -59,36 +55,87 @@ bool transaction_can_proceed_offline(String student_id) {
 void queue_offline_transaction(Transaction t) {
   t.offline_mode = true;
   t.synced = false;
-  offline_queue.push_back(t);
-  Logger::logInfo("Offline: Queued transaction " + t.id);
+  if (offline_queue_append(t)) {
+    Logger::logInfo("Offline: Queued transaction " + t.id);
+  }
 }
 
-void sync_offline_transactions() {
-  if (!wifi_is_connected() || offline_queue.size() == 0) {
-    return;
+static bool acknowledged(const std::vector<String>& acked, const String& id) {
+  for (const String& a : acked) {
+    if (a == id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool sync_offline_transactions() {
+  int pending = offline_queue_pending();
+  if (!wifi_is_connected() || pending == 0) {
+    return false;
   }
   
-  Logger::logInfo("Offline: Syncing " + String(offline_queue.size()) + " transactions");
+  std::vector<Transaction> chunk;
+  std::vector<uint32_t> ends;
+  uint32_t generation = 0;
+  int count = offline_queue_peek(chunk, ends, OFFLINE_SYNC_CHUNK, OFFLINE_SYNC_MAX_BYTES, generation);
+  if (count == 0) {
+    return false;
+  }
+  Logger::logInfo("Offline: Syncing " + String(count) + " of " + String(pending) + " transactions");
   
-  if (api_sync_offline_transactions(offline_queue)) {
-    // Mark as synced in cache
-    for (Transaction& t : offline_queue) {
-      t.synced = true;
-      cache_add_transaction(t); // Update cache with synced flag
+  std::vector<Transaction> batch;
+  for (const Transaction& t : chunk) {
+    if (t.id.length() > 0) {
+      batch.push_back(t);
     }
-    
-    offline_queue.clear();
-    Logger::logInfo("Offline: All transactions synced");
-  } else {
+  }
+  std::vector<String> acked;
+  if (!batch.empty() && !api_sync_offline_transactions(batch, acked)) {
     Logger::logError("Offline: Sync failed, will retry later");
+    return false;
   }
+  
+  // The head moves past the acknowledged prefix only; from the first gap
+  // on, records are sent again and the server drops the ones it has
+  int prefix = 0;
+  while (prefix < count && (chunk[prefix].id.length() == 0 || acknowledged(acked, chunk[prefix].id))) {
+    prefix++;
+  }
+  for (const String& id : acked) {
+    cache_mark_synced(id);
+  }
+  if (prefix > 0) {
+    offline_queue_advance(generation, ends[prefix - 1], prefix);
+  }
+  if (prefix < count) {
+    Logger::logError("Offline: Server acknowledged " + String(prefix) + " of " + String(count) +
+                     ", resuming from " + chunk[prefix].id);
+    return false;
+  }
+  
+  if (offline_queue_pending() == 0) {
+    Logger::logInfo("Offline: All transactions synced");
+    return false;
+  }
+  return true;
 }
 
 std::vector<Transaction> get_offline_queue() {
-  return offline_queue;
+  std::vector<Transaction> records;
+  std::vector<uint32_t> ends;
+  uint32_t generation = 0;
+  offline_queue_peek(records, ends, offline_queue_pending(), OFFLINE_QUEUE_MAX_BYTES, generation);
+  std::vector<Transaction> queue;
+  for (const Transaction& t : records) {
+    if (t.id.length() > 0) {
+      queue.push_back(t);
+    }
+  }
+  return queue;
 }
 
 int get_offline_queue_size() {
-  return offline_queue.size();
+  return offline_queue_pending();
 }
 
@@ -5,11 +5,17 @@
 #include <vector>
 #include "../config/data_types.h"
 
+// Offline sync goes one sync-batch call at a time, bounded both ways so the
+// request document stays small after a long outage
+#define OFFLINE_SYNC_CHUNK 16                // Records per call
+#define OFFLINE_SYNC_MAX_BYTES (8 * 1024)    // Queue log bytes per call
+
 bool is_offline_mode();
 FraudCheckResult check_offline_eligibility(String student_id);
 bool transaction_can_proceed_offline(String student_id);
 void queue_offline_transaction(Transaction t);
-void sync_offline_transactions();
+// Sends the next chunk; true if it was acknowledged in full and more wait
+bool sync_offline_transactions();
 std::vector<Transaction> get_offline_queue();
 int get_offline_queue_size();
 
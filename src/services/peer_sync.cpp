@@ -0,0 +1,393 @@
+#include "peer_sync.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "fraud_window.h"
+#include "wifi_manager.h"
+#include "../utils/clock.h"
+#include "../utils/helpers.h"
+#include "../utils/spsc_queue.h"
+#include "../utils/logger.h"
+
+#define PEER_MAGIC 0x5350   // "PS"
+#define PEER_VERSION 1
+#define PEER_REPAIR_SPAN 64 // Sequence numbers one repair request covers
+#define PEER_TIMEOUT_MS (5 * PEER_SYNC_HEARTBEAT_MS)  // Silent peers get no repair requests
+
+enum PeerPacketType : uint8_t {
+  PEER_UPDATE = 1,     // Entries, new or resent
+  PEER_HEARTBEAT = 2,  // Header only
+  PEER_REPAIR = 3      // Repair requests, one per peer with gaps
+};
+
+// Wire format, little-endian on both ESP32 and the host. Timestamps travel
+// as ages, so terminals need not agree on the time of day.
+struct __attribute__((packed)) PeerHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t type;
+  uint32_t origin;      // Sending terminal
+  uint32_t epoch;       // New on every boot; sequence numbers restart with it
+  uint32_t latest_seq;  // Newest serve the sender has published
+  uint32_t oldest_seq;  // Oldest it can still resend
+  uint16_t count;       // Entries or repair requests that follow
+  uint16_t reserved;
+};
+
+struct __attribute__((packed)) PeerEntry {
+  uint64_t key;      // Helpers::hashString(student_id)
+  uint32_t seq;
+  uint32_t age_sec;  // Seconds between the serve and sending this packet
+};
+
+struct __attribute__((packed)) PeerRepair {
+  uint32_t target;    // Terminal asked to resend
+  uint32_t epoch;
+  uint32_t base_seq;
+  uint32_t reserved;
+  uint64_t missing;   // Bit i asks for base_seq + i
+};
+
+struct PeerLogEntry {
+  uint64_t key;
+  uint32_t seq;
+  uint32_t timestamp;  // Seconds, this terminal's clock
+};
+
+// What one terminal knows about another's sequence
+struct PeerState {
+  uint32_t origin;     // 0 for an unused slot
+  uint32_t epoch;
+  uint32_t contiguous; // Every seq up to here is received or given up on
+  uint64_t received;   // Bit i: contiguous + 1 + i arrived early
+  uint32_t latest;     // Newest seq the peer has announced
+  unsigned long last_heard_ms;
+};
+
+WiFiUDP peer_udp;
+IPAddress peer_group;
+int peer_port = PEER_SYNC_PORT;
+bool peer_enabled = false;
+bool peer_joined = false;
+uint32_t peer_origin = 0;
+uint32_t peer_epoch = 0;
+uint32_t peer_seq = 0;  // Last sequence number handed out
+unsigned long peer_last_heartbeat = 0;
+TaskHandle_t peer_task = NULL;
+
+PeerLogEntry peer_log[PEER_SYNC_LOG_SIZE];
+PeerState peers[PEER_SYNC_MAX_PEERS];
+SpscQueue<PeerLogEntry, 32> peer_outbox;  // app -> network
+PeerEntry peer_batch[PEER_SYNC_BATCH];
+int peer_batch_count = 0;
+PeerSyncStats peer_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static uint32_t oldest_logged_seq() {
+  return peer_seq >= PEER_SYNC_LOG_SIZE ? peer_seq - PEER_SYNC_LOG_SIZE + 1 : 1;
+}
+
+static bool send_packet(uint8_t type, const void* body, size_t body_len, uint16_t count) {
+  PeerHeader header = {PEER_MAGIC, PEER_VERSION, type, peer_origin, peer_epoch,
+                       peer_seq, oldest_logged_seq(), count, 0};
+  if (!peer_udp.beginMulticastPacket()) {
+    peer_stats.send_errors++;
+    return false;
+  }
+  peer_udp.write((const uint8_t*)&header, sizeof(header));
+  if (body_len > 0) {
+    peer_udp.write((const uint8_t*)body, body_len);
+  }
+  if (!peer_udp.endPacket()) {
+    peer_stats.send_errors++;
+    return false;
+  }
+  return true;
+}
+
+static void flush_batch() {
+  if (peer_batch_count > 0) {
+    send_packet(PEER_UPDATE, peer_batch, peer_batch_count * sizeof(PeerEntry), peer_batch_count);
+    peer_batch_count = 0;
+  }
+}
+
+static void batch_entry(const PeerLogEntry& entry, unsigned long now_sec) {
+  PeerEntry& out = peer_batch[peer_batch_count++];
+  out.key = entry.key;
+  out.seq = entry.seq;
+  out.age_sec = now_sec > entry.timestamp ? now_sec - entry.timestamp : 0;
+  if (peer_batch_count == PEER_SYNC_BATCH) {
+    flush_batch();
+  }
+}
+
+// Moves contiguous up to seq, giving up on anything not received below it
+static void skip_to(PeerState& peer, uint32_t seq, bool count_lost) {
+  uint32_t gap = seq - peer.contiguous;
+  uint64_t passed = gap >= 64 ? peer.received : peer.received & ((1ULL << gap) - 1);
+  if (count_lost) {
+    peer_stats.unrecoverable += gap - __builtin_popcountll(passed);
+  }
+  peer.received = gap >= 64 ? 0 : peer.received >> gap;
+  peer.contiguous = seq;
+  while (peer.received & 1) {
+    peer.received >>= 1;
+    peer.contiguous++;
+  }
+}
+
+// True the first time a sequence number arrives
+static bool accept_seq(PeerState& peer, uint32_t seq) {
+  if (seq <= peer.contiguous) {
+    return false;
+  }
+  if (seq - peer.contiguous > PEER_REPAIR_SPAN) {
+    skip_to(peer, seq - PEER_REPAIR_SPAN, true);
+  }
+  uint64_t bit = 1ULL << (seq - peer.contiguous - 1);
+  if (peer.received & bit) {
+    return false;
+  }
+  peer.received |= bit;
+  while (peer.received & 1) {
+    peer.received >>= 1;
+    peer.contiguous++;
+  }
+  return true;
+}
+
+// State for the sender of a packet. A new peer, or a known one after a
+// reboot, starts at the oldest serve it can still resend, so the whole log
+// is asked for.
+static PeerState* track_peer(const PeerHeader& header) {
+  PeerState* peer = NULL;
+  for (int i = 0; i < PEER_SYNC_MAX_PEERS; i++) {
+    if (peers[i].origin == header.origin) {
+      peer = &peers[i];
+      break;
+    }
+    if (peer == NULL || peers[i].last_heard_ms < peer->last_heard_ms) {
+      peer = &peers[i];
+    }
+  }
+
+  if (peer->origin != header.origin || peer->epoch != header.epoch) {
+    peer->origin = header.origin;
+    peer->epoch = header.epoch;
+    peer->contiguous = header.oldest_seq > 0 ? header.oldest_seq - 1 : 0;
+    peer->received = 0;
+    peer->latest = 0;
+  }
+  if (header.oldest_seq > peer->contiguous + 1) {
+    skip_to(*peer, header.oldest_seq - 1, true);
+  }
+  peer->latest = max(peer->latest, header.latest_seq);
+  peer->last_heard_ms = millis();
+  return peer;
+}
+
+static void merge_entries(PeerState& peer, const PeerEntry* entries, int count) {
+  unsigned long now_sec = clock_seconds();
+  for (int i = 0; i < count; i++) {
+    PeerEntry entry;
+    memcpy(&entry, &entries[i], sizeof(entry));
+    if (!accept_seq(peer, entry.seq)) {
+      peer_stats.duplicates++;
+      continue;
+    }
+    // Older than this terminal's clock goes back: pin to its start, which
+    // every window up to 24 h still covers
+    unsigned long timestamp = now_sec > entry.age_sec ? now_sec - entry.age_sec : 0;
+    fraud_window_record_served(entry.key, timestamp);
+    peer_stats.merged++;
+  }
+}
+
+static void answer_repairs(const PeerRepair* requests, int count) {
+  unsigned long now_sec = clock_seconds();
+  uint32_t oldest = oldest_logged_seq();
+  for (int i = 0; i < count; i++) {
+    PeerRepair request;
+    memcpy(&request, &requests[i], sizeof(request));
+    if (request.target != peer_origin || request.epoch != peer_epoch) {
+      continue;
+    }
+    for (int bit = 0; bit < PEER_REPAIR_SPAN; bit++) {
+      uint32_t seq = request.base_seq + bit;
+      if (!(request.missing >> bit & 1) || seq < oldest || seq > peer_seq) {
+        continue;
+      }
+      batch_entry(peer_log[seq & (PEER_SYNC_LOG_SIZE - 1)], now_sec);
+      peer_stats.repaired++;
+    }
+  }
+  flush_batch();
+}
+
+static void handle_packet(int length) {
+  static uint8_t buffer[sizeof(PeerHeader) + PEER_SYNC_BATCH * sizeof(PeerEntry)];
+  if (length > (int)sizeof(buffer) || length < (int)sizeof(PeerHeader)) {
+    peer_stats.bad_packets++;
+    return;
+  }
+  peer_udp.read(buffer, length);
+
+  PeerHeader header;
+  memcpy(&header, buffer, sizeof(header));
+  if (header.magic != PEER_MAGIC || header.version != PEER_VERSION) {
+    peer_stats.bad_packets++;
+    return;
+  }
+  if (header.origin == peer_origin) {
+    return;  // Our own datagram looped back
+  }
+
+  size_t item = header.type == PEER_REPAIR ? sizeof(PeerRepair) : sizeof(PeerEntry);
+  if (sizeof(header) + header.count * item > (size_t)length) {
+    peer_stats.bad_packets++;
+    return;
+  }
+
+  PeerState* peer = track_peer(header);
+  const uint8_t* body = buffer + sizeof(header);
+  if (header.type == PEER_UPDATE) {
+    merge_entries(*peer, (const PeerEntry*)body, header.count);
+  } else if (header.type == PEER_REPAIR) {
+    answer_repairs((const PeerRepair*)body, header.count);
+  }
+}
+
+// One request per peer that announced serves we do not have
+static void request_repairs() {
+  PeerRepair requests[PEER_SYNC_MAX_PEERS];
+  int count = 0;
+  unsigned long now = millis();
+  for (int i = 0; i < PEER_SYNC_MAX_PEERS; i++) {
+    PeerState& peer = peers[i];
+    if (peer.origin == 0 || now - peer.last_heard_ms > PEER_TIMEOUT_MS ||
+        peer.latest <= peer.contiguous) {
+      continue;
+    }
+    uint32_t span = min(peer.latest - peer.contiguous, (uint32_t)PEER_REPAIR_SPAN);
+    uint64_t wanted = span == 64 ? ~0ULL : (1ULL << span) - 1;
+    uint64_t missing = wanted & ~peer.received;
+    if (missing == 0) {
+      continue;
+    }
+    PeerRepair& request = requests[count++];
+    request.target = peer.origin;
+    request.epoch = peer.epoch;
+    request.base_seq = peer.contiguous + 1;
+    request.reserved = 0;
+    request.missing = missing;
+  }
+  if (count > 0 && send_packet(PEER_REPAIR, requests, count * sizeof(PeerRepair), count)) {
+    peer_stats.repair_requests += count;
+  }
+}
+
+bool peer_sync_init(const String& device_id, const String& group, int port) {
+  if (!peer_group.fromString(group)) {
+    Logger::logError("Peer Sync: Bad group address " + group);
+    return false;
+  }
+  uint64_t hash = Helpers::hashString(device_id);
+  peer_origin = (uint32_t)(hash ^ (hash >> 32));
+  peer_origin = peer_origin != 0 ? peer_origin : 1;
+  peer_epoch = (uint32_t)random(1, 0x7FFFFFFF) ^ (uint32_t)micros();
+  peer_epoch = peer_epoch != 0 ? peer_epoch : 1;
+  peer_port = port;
+  peer_seq = 0;
+  peer_joined = false;
+  memset(peers, 0, sizeof(peers));
+  peer_enabled = true;
+
+  Logger::logf("[INFO] Peer Sync: Terminal %08lx, group %s:%d", (unsigned long)peer_origin,
+               group.c_str(), port);
+  return true;
+}
+
+void peer_sync_attach(TaskHandle_t worker) {
+  peer_task = worker;
+}
+
+void peer_sync_publish(const Transaction& t) {
+  // Only serves the double-serving rule counts; peers record them as such
+  if (!peer_enabled || t.student_id.length() == 0 || !fraud_window_is_counted_serve(t.status)) {
+    return;
+  }
+  PeerLogEntry entry = {Helpers::hashString(t.student_id), 0, (uint32_t)t.timestamp};
+  peer_outbox.push(entry);
+  if (peer_task != NULL) {
+    xTaskNotifyGive(peer_task);
+  }
+}
+
+unsigned long peer_sync_service() {
+  if (!peer_enabled) {
+    return 0;
+  }
+
+  // Serves get their sequence numbers even while the link is down; peers
+  // ask for them once it is back
+  bool connected = wifi_is_connected();
+  unsigned long now_sec = clock_seconds();
+  PeerLogEntry entry;
+  while (peer_outbox.pop(entry)) {
+    entry.seq = ++peer_seq;
+    peer_log[entry.seq & (PEER_SYNC_LOG_SIZE - 1)] = entry;
+    peer_stats.published++;
+    if (connected && peer_joined) {
+      batch_entry(entry, now_sec);
+    }
+  }
+
+  if (!connected) {
+    if (peer_joined) {
+      peer_udp.stop();
+      peer_joined = false;
+    }
+    return 0;
+  }
+  if (!peer_joined) {
+    peer_joined = peer_udp.beginMulticast(peer_group, peer_port);
+    if (!peer_joined) {
+      peer_stats.send_errors++;
+      return 0;
+    }
+    peer_last_heartbeat = millis() - PEER_SYNC_HEARTBEAT_MS;  // Announce right away
+  }
+  flush_batch();
+
+  int length;
+  while ((length = peer_udp.parsePacket()) > 0) {
+    handle_packet(length);
+  }
+
+  if (millis() - peer_last_heartbeat >= PEER_SYNC_HEARTBEAT_MS) {
+    peer_last_heartbeat = millis();
+    send_packet(PEER_HEARTBEAT, NULL, 0, 0);
+    request_repairs();
+  }
+  return PEER_SYNC_POLL_MS;
+}
+
+PeerSyncStats peer_sync_get_stats() {
+  PeerSyncStats stats = peer_stats;
+  stats.peers = 0;
+  unsigned long now = millis();
+  for (int i = 0; i < PEER_SYNC_MAX_PEERS; i++) {
+    stats.peers += peers[i].origin != 0 && now - peers[i].last_heard_ms <= PEER_TIMEOUT_MS;
+  }
+  return stats;
+}
+
+void peer_sync_log_stats() {
+  if (!peer_enabled) {
+    return;
+  }
+  PeerSyncStats stats = peer_sync_get_stats();
+  Logger::logf("[INFO] Peer Sync: %d peers, %lu published, %lu merged, %lu duplicate, "
+               "%lu repair requests, %lu resent, %lu unrecoverable, %lu send errors",
+               stats.peers, stats.published, stats.merged, stats.duplicates,
+               stats.repair_requests, stats.repaired, stats.unrecoverable, stats.send_errors);
+}
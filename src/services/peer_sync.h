@@ -0,0 +1,47 @@
+#ifndef PEER_SYNC_H
+#define PEER_SYNC_H
+
+#include <Arduino.h>
+#include "../config/data_types.h"
+
+// Served-today sharing between terminals in the same hall. Each serve is
+// multicast as a (student key, age) pair with a per-terminal sequence
+// number; receivers merge it into their fraud window, so a student served
+// at one counter is denied at the next even while the server is down.
+// Heartbeats carry each terminal's latest sequence, and receivers ask for
+// the numbers they missed while the sender still holds them.
+
+#define PEER_SYNC_GROUP "239.10.0.1"
+#define PEER_SYNC_PORT 4210
+#define PEER_SYNC_MAX_PEERS 8
+#define PEER_SYNC_LOG_SIZE 256      // Own serves kept for repair, power of two
+#define PEER_SYNC_BATCH 64          // Entries per datagram
+#define PEER_SYNC_HEARTBEAT_MS 2000
+#define PEER_SYNC_POLL_MS 100       // Receive latency while joined
+
+struct PeerSyncStats {
+  unsigned long published;     // Own serves sent
+  unsigned long merged;        // Peer serves added to the fraud window
+  unsigned long duplicates;    // Peer serves already seen
+  unsigned long repair_requests;  // Gap requests sent to peers
+  unsigned long repaired;      // Own serves sent again on request
+  unsigned long unrecoverable; // Peer serves that left the sender's log first
+  unsigned long send_errors;
+  unsigned long bad_packets;
+  int peers;
+};
+
+// Joins the group once WiFi is up; the terminal id is a hash of device_id
+bool peer_sync_init(const String& device_id, const String& group = PEER_SYNC_GROUP,
+                    int port = PEER_SYNC_PORT);
+// The network task attaches itself and calls peer_sync_service() when notified
+void peer_sync_attach(TaskHandle_t worker);
+// Served transactions only; one producer (the commit path)
+void peer_sync_publish(const Transaction& t);
+// Sends, receives and repairs. Returns how soon it wants to run again in
+// ms, 0 when idle.
+unsigned long peer_sync_service();
+PeerSyncStats peer_sync_get_stats();
+void peer_sync_log_stats();
+
+#endif
@@ -0,0 +1,35 @@
+#include "status_server.h"
+#include "../utils/trace.h"
+#include "../utils/logger.h"
+
+AsyncWebServer* status_server = NULL;
+
+bool status_server_begin(int port) {
+  if (status_server != NULL) {
+    return true;
+  }
+
+  status_server = new AsyncWebServer(port);
+
+  // Handlers run on the async TCP task; trace reads take their own snapshot
+  status_server->on("/trace", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", trace_summary_json());
+  });
+
+  status_server->on("/trace/recent", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", trace_recent_json());
+  });
+
+  status_server->on("/trace/reset", HTTP_POST, [](AsyncWebServerRequest* request) {
+    trace_reset();
+    request->send(200, "application/json", "{\"success\":true}");
+  });
+
+  status_server->begin();
+  Logger::logInfo("Status Server: Listening on port " + String(port));
+  return true;
+}
+
+AsyncWebServer* status_server_get() {
+  return status_server;
+}
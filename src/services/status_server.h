@@ -0,0 +1,16 @@
+#ifndef STATUS_SERVER_H
+#define STATUS_SERVER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#define STATUS_SERVER_PORT 80
+
+// Read-only diagnostics over HTTP:
+//   GET  /trace         per-stage latency percentiles
+//   GET  /trace/recent  raw stage records, oldest first
+//   POST /trace/reset   clear histograms and ring
+bool status_server_begin(int port);
+AsyncWebServer* status_server_get(); // For modules that add their own routes
+
+#endif
@@ -0,0 +1,246 @@
+#include "student_profile.h"
+#include <SPIFFS.h>
+#include "../utils/helpers.h"
+#include "../utils/logger.h"
+#include "../utils/clock.h"
+
+#define PROFILE_EWMA_SHIFT 3            // New sample weighs 1/8
+#define PROFILE_MIN_DEV_MIN 30          // Interval deviation floor, minutes
+#define PROFILE_CONFIDENCE_SLACK 3277   // 0.10 in Q15 before a drop counts
+
+StudentProfile* profile_table = NULL;  // PSRAM, PROFILE_SLOTS records
+ProfileStats profile_stats = {0, 0, 0, 0, 0, 0};
+portMUX_TYPE profile_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static int hour_bin(unsigned long wall_sec) {
+  return (wall_sec / 3600) % PROFILE_HOUR_BINS;
+}
+
+static int32_t ewma(int32_t average, int32_t sample) {
+  return average + ((sample - average) >> PROFILE_EWMA_SHIFT);
+}
+
+static StudentProfile* find_profile(uint64_t key) {
+  for (int probe = 0; probe < PROFILE_PROBES; probe++) {
+    StudentProfile& p = profile_table[(key + probe) & (PROFILE_SLOTS - 1)];
+    if (p.key == key) {
+      return &p;
+    }
+  }
+  return NULL;
+}
+
+// Existing profile, else an empty slot, else the one unseen the longest
+static StudentProfile* claim_profile(uint64_t key) {
+  StudentProfile* found = find_profile(key);
+  if (found != NULL) {
+    return found;
+  }
+
+  StudentProfile* victim = NULL;
+  for (int probe = 0; probe < PROFILE_PROBES; probe++) {
+    StudentProfile& p = profile_table[(key + probe) & (PROFILE_SLOTS - 1)];
+    if (p.key == 0) {
+      victim = &p;
+      profile_stats.students++;
+      break;
+    }
+    if (victim == NULL || p.last_visit < victim->last_visit) {
+      victim = &p;
+    }
+  }
+  if (victim->key != 0) {
+    profile_stats.evictions++;
+  }
+
+  memset(victim, 0, sizeof(*victim));
+  victim->key = key;
+  return victim;
+}
+
+static void persist_profile(int slot, const StudentProfile& copy) {
+  File file = SPIFFS.open(PROFILE_FILE, "r+");
+  if (!file || !file.seek(slot * sizeof(StudentProfile)) ||
+      file.write((const uint8_t*)&copy, sizeof(copy)) != sizeof(copy)) {
+    profile_stats.write_errors++;
+  }
+  if (file) {
+    file.close();
+  }
+}
+
+bool profile_init() {
+  if (profile_table == NULL) {
+    profile_table = (StudentProfile*)ps_malloc(PROFILE_SLOTS * sizeof(StudentProfile));
+    if (profile_table == NULL) {
+      Logger::logError("Profile: Table allocation failed");
+      return false;
+    }
+  }
+  memset(profile_table, 0, PROFILE_SLOTS * sizeof(StudentProfile));
+  profile_stats.students = 0;
+
+  size_t table_bytes = PROFILE_SLOTS * sizeof(StudentProfile);
+  if (SPIFFS.exists(PROFILE_FILE)) {
+    File file = SPIFFS.open(PROFILE_FILE, "r");
+    if (file && file.size() == table_bytes) {
+      file.read((uint8_t*)profile_table, table_bytes);
+      file.close();
+      for (int i = 0; i < PROFILE_SLOTS; i++) {
+        profile_stats.students += profile_table[i].key != 0;
+      }
+      Logger::logInfo("Profile: Loaded " + String(profile_stats.students) + " students");
+      return true;
+    }
+    if (file) {
+      file.close();
+    }
+    Logger::logError("Profile: Layout changed, starting empty");
+  }
+
+  // Full-size file up front, so updates only ever overwrite a record
+  File file = SPIFFS.open(PROFILE_FILE, "w");
+  if (!file) {
+    Logger::logError("Profile: Failed to create " + String(PROFILE_FILE));
+    return false;
+  }
+  file.write((const uint8_t*)profile_table, table_bytes);
+  file.close();
+  Logger::logInfo("Profile: Initialized");
+  return true;
+}
+
+void profile_update(const Transaction& t) {
+  if (profile_table == NULL || t.student_id.length() == 0 || !Helpers::isServedStatus(t.status)) {
+    return;
+  }
+  unsigned long visit;
+  if (!clock_to_wall(t.timestamp, visit)) {
+    portENTER_CRITICAL(&profile_mux);
+    profile_stats.unsynced++;
+    portEXIT_CRITICAL(&profile_mux);
+    return;
+  }
+  uint64_t key = Helpers::hashString(t.student_id);
+
+  portENTER_CRITICAL(&profile_mux);
+  StudentProfile* p = claim_profile(key);
+
+  // Time of day: halve every bin when one would overflow, so old habits fade
+  uint8_t* bin = &p->hours[hour_bin(visit)];
+  if (*bin == 255) {
+    for (int i = 0; i < PROFILE_HOUR_BINS; i++) {
+      p->hours[i] >>= 1;
+    }
+  }
+  (*bin)++;
+
+  // Interval since the previous serve, in minutes
+  if (p->visits > 0 && visit > p->last_visit) {
+    int32_t interval = min((unsigned long)65535, (visit - p->last_visit) / 60);
+    if (p->visits == 1) {
+      p->interval_min = interval;
+      p->interval_dev_min = interval / 2;
+    } else {
+      int32_t deviation = abs(interval - (int32_t)p->interval_min);
+      p->interval_min = ewma(p->interval_min, interval);
+      p->interval_dev_min = ewma(p->interval_dev_min, min(deviation, (int32_t)65535));
+    }
+  }
+
+  // Face confidence; local and server matches both report one
+  if (t.face_confidence > 0) {
+    int32_t confidence = constrain((int32_t)(t.face_confidence * 32768), 0, 65535);
+    p->confidence_q15 = p->visits == 0 ? confidence : ewma(p->confidence_q15, confidence);
+  }
+
+  p->visits = p->visits < 65535 ? p->visits + 1 : p->visits;
+  p->last_visit = max(p->last_visit, (uint32_t)visit);
+  profile_stats.updates++;
+  int slot = p - profile_table;
+  StudentProfile copy = *p;
+  portEXIT_CRITICAL(&profile_mux);
+
+  persist_profile(slot, copy);
+}
+
+ProfileScore profile_score(const String& student_id, float confidence, unsigned long now_sec) {
+  ProfileScore result = {0, 0, 0, 0};
+  if (profile_table == NULL) {
+    return result;
+  }
+  uint64_t key = Helpers::hashString(student_id);
+
+  portENTER_CRITICAL(&profile_mux);
+  profile_stats.scores++;
+  StudentProfile* found = find_profile(key);
+  StudentProfile p;
+  bool usable = found != NULL && found->visits >= PROFILE_MIN_VISITS;
+  if (usable) {
+    p = *found;
+  }
+  portEXIT_CRITICAL(&profile_mux);
+  if (!usable) {
+    return result;
+  }
+
+  // Time of day: weight of this hour and its neighbours against the
+  // student's busiest hour, smoothed the same way
+  int32_t peak = 0;
+  int32_t weight = 0;
+  int now_bin = hour_bin(now_sec);
+  for (int b = 0; b < PROFILE_HOUR_BINS; b++) {
+    int32_t w = 2 * p.hours[b] + p.hours[(b + PROFILE_HOUR_BINS - 1) % PROFILE_HOUR_BINS] +
+                p.hours[(b + 1) % PROFILE_HOUR_BINS];
+    peak = max(peak, w);
+    if (b == now_bin) {
+      weight = w;
+    }
+  }
+  if (peak > 0) {
+    result.time_points = PROFILE_TIME_POINTS * (peak - weight) / peak;
+  }
+
+  // Interval: 0 points up to 2 deviations early, all points at 4 (z in Q4)
+  if (now_sec > p.last_visit) {
+    int32_t since = min((unsigned long)65535, (now_sec - p.last_visit) / 60);
+    int32_t early = (int32_t)p.interval_min - since;
+    if (early > 0) {
+      int32_t z_q4 = early * 16 / max((int32_t)p.interval_dev_min, (int32_t)PROFILE_MIN_DEV_MIN);
+      result.interval_points = constrain((z_q4 - 32) * PROFILE_INTERVAL_POINTS / 32, 0,
+                                         PROFILE_INTERVAL_POINTS);
+    }
+  }
+
+  // Confidence: 0 points up to 0.10 below the usual, all points at 0.30
+  int32_t drop = (int32_t)p.confidence_q15 - (int32_t)(confidence * 32768);
+  if (p.confidence_q15 > 0 && drop > PROFILE_CONFIDENCE_SLACK) {
+    result.confidence_points = min((drop - PROFILE_CONFIDENCE_SLACK) * PROFILE_CONFIDENCE_POINTS /
+                                   (2 * PROFILE_CONFIDENCE_SLACK), (int32_t)PROFILE_CONFIDENCE_POINTS);
+  }
+
+  // A young profile has seen too few meals to call an hour or gap unusual
+  int32_t maturity = min((int32_t)p.visits, (int32_t)PROFILE_MATURE_VISITS);
+  result.time_points = result.time_points * maturity / PROFILE_MATURE_VISITS;
+  result.interval_points = result.interval_points * maturity / PROFILE_MATURE_VISITS;
+
+  result.score = result.time_points + result.interval_points + result.confidence_points;
+  return result;
+}
+
+void profile_clear() {
+  if (profile_table == NULL) {
+    return;
+  }
+  portENTER_CRITICAL(&profile_mux);
+  memset(profile_table, 0, PROFILE_SLOTS * sizeof(StudentProfile));
+  profile_stats.students = 0;
+  portEXIT_CRITICAL(&profile_mux);
+}
+
+ProfileStats profile_get_stats() {
+  portENTER_CRITICAL(&profile_mux);
+  ProfileStats stats = profile_stats;
+  portEXIT_CRITICAL(&profile_mux);
+  return stats;
+}
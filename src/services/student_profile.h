@@ -0,0 +1,59 @@
+#ifndef STUDENT_PROFILE_H
+#define STUDENT_PROFILE_H
+
+#include <Arduino.h>
+#include "../config/data_types.h"
+
+// Per-student visit profiles for anomaly scoring, in fixed point. The table
+// lives in RAM and is mirrored record by record to PROFILE_FILE, so scoring
+// is a hash probe and some integer math; only commits touch flash.
+
+#define PROFILE_FILE "/profiles.bin"
+#define PROFILE_SLOTS 1024         // Power of two
+#define PROFILE_PROBES 8
+#define PROFILE_HOUR_BINS 24
+#define PROFILE_MIN_VISITS 5       // Below this a profile scores 0
+#define PROFILE_MATURE_VISITS 10   // Habit points reach full weight here
+
+// Score components, out of 100
+#define PROFILE_TIME_POINTS 40        // Visit at an hour the student rarely comes
+#define PROFILE_INTERVAL_POINTS 40    // Much sooner after the last meal than usual
+#define PROFILE_CONFIDENCE_POINTS 20  // Face match well below the student's usual
+
+struct StudentProfile {
+  uint64_t key;                      // Helpers::hashString(student_id), 0 if empty
+  uint32_t last_visit;               // Wall-clock seconds of the last serve
+  uint16_t visits;                   // Saturates at 65535
+  uint16_t interval_min;             // EWMA of minutes between serves
+  uint16_t interval_dev_min;         // EWMA of |interval - interval_min|
+  uint16_t confidence_q15;           // EWMA of face confidence, 1.0 = 32768
+  uint8_t hours[PROFILE_HOUR_BINS];  // Serves per hour of day, halved when one saturates
+};
+
+struct ProfileScore {
+  int score;  // 0-100, sum of the parts below
+  int time_points;
+  int interval_points;
+  int confidence_points;
+};
+
+struct ProfileStats {
+  unsigned long updates;
+  unsigned long scores;
+  unsigned long evictions;
+  unsigned long write_errors;
+  unsigned long unsynced;  // Serves not recorded: clock not yet set to wall time
+  int students;
+};
+
+bool profile_init();
+// Served transactions only; called from the commit path. Skipped until
+// clock_to_wall() works: boot-relative hours and gaps mean nothing across
+// reboots.
+void profile_update(const Transaction& t);
+// now_sec is wall time (clock_to_wall)
+ProfileScore profile_score(const String& student_id, float confidence, unsigned long now_sec);
+void profile_clear(); // RAM table only, the file is left as is
+ProfileStats profile_get_stats();
+
+#endif
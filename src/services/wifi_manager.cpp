@@ -3,11 +3,14 @@
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 
 #define WIFI_CREDENTIALS_FILE "/wifi_creds.json"
 #define MAX_RETRY_DELAY 30000
 #define INITIAL_RETRY_DELAY 2000
 #define CONNECTION_TIMEOUT 20000
+#define NTP_SERVER_PRIMARY "pool.ntp.org"
+#define NTP_SERVER_SECONDARY "time.nist.gov"
 
 bool wifi_initialized = false;
 bool wifi_connected = false;
@@ -16,8 +19,20 @@ String wifi_password = "";
 int retry_delay = INITIAL_RETRY_DELAY;
 unsigned long last_connection_attempt = 0;
 unsigned long last_health_check = 0;
+bool sntp_started = false;
 void (*status_callback)(bool connected) = nullptr;
 
+// Wall time for the visit profiles (clock_to_wall). Once started, SNTP
+// resyncs in the background, so the first connection is enough.
+static void start_sntp() {
+  if (sntp_started) {
+    return;
+  }
+  configTime(0, 0, NTP_SERVER_PRIMARY, NTP_SERVER_SECONDARY); // UTC
+  sntp_started = true;
+  Logger::logInfo("WiFi: SNTP started");
+}
+
 bool wifi_init(String ssid, String password) {
   wifi_ssid = ssid;
   wifi_password = password;
@@ -63,6 +78,7 @@ bool wifi_connect() {
     wifi_connected = true;
     retry_delay = INITIAL_RETRY_DELAY; // Reset on success
     Logger::logInfo("WiFi: Connected - IP: " + WiFi.localIP().toString());
+    start_sntp();
     if (status_callback) status_callback(true);
     return true;
   } else {
@@ -79,6 +95,7 @@ bool wifi_is_connected() {
       wifi_connected = true;
       retry_delay = INITIAL_RETRY_DELAY;
       Logger::logInfo("WiFi: Reconnected");
+      start_sntp();
       if (status_callback) status_callback(true);
     }
     return true;
@@ -104,7 +121,7 @@ void wifi_check_connection() {
     return;
   }
   
-  unsigned long now = millis();
+  unsigned long now = clock_millis();
   
   // Health check every 30 seconds
   if (now - last_health_check > 30000) {
@@ -121,10 +138,10 @@ void wifi_auto_reconnect() {
     return;
   }
   
-  unsigned long now = millis();
+  unsigned long now = clock_millis();
   
   // Exponential backoff: 2s, 4s, 8s, 16s, 30s max
-  if (now - last_connection_attempt < retry_delay) {
+  if (now - last_connection_attempt < (unsigned long)retry_delay) {
     return; // Still in backoff period
   }
   
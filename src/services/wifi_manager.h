@@ -4,6 +4,8 @@
 #include <Arduino.h>
 
 bool wifi_init(String ssid, String password);
+bool wifi_connect();
+void wifi_auto_reconnect();
 bool wifi_is_connected();
 int wifi_get_signal_strength();
 void wifi_check_connection();
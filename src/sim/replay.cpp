@@ -0,0 +1,269 @@
+#include "replay.h"
+#include "sim_backend.h"
+#include "../hal/native/sim_hal.h"
+#include "../config/data_types.h"
+#include "../services/api_client.h"
+#include "../services/wifi_manager.h"
+#include "../services/fraud_detection.h"
+#include "../services/fraud_window.h"
+#include "../services/student_profile.h"
+#include "../services/commit_pipeline.h"
+#include "../storage/transaction_cache.h"
+#include "../utils/helpers.h"
+#include "../utils/clock.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define REPLAY_MEAL_GAP_MS (2UL * 3600 * 1000)  // Quiet time that starts a new meal service
+#define REPLAY_DAY_MS (24UL * 3600 * 1000)
+#define REPLAY_MEAL_COST 5.0                     // Same deduction as DiningSystem::create_transaction
+#define REPLAY_FACE "cmVwbGF5"                   // Any non-empty image passes the sim backend
+
+struct ReplayScan {
+  unsigned long at_ms;  // Since midnight
+  String uid;
+  float confidence;     // < 0: backend default
+  float balance;        // < 0: backend keeps its own
+};
+
+struct ReplayMeal {
+  const char* name;
+  unsigned long start_sec;
+  unsigned long length_sec;
+  float attendance;
+};
+
+static const ReplayMeal REPLAY_MEALS[] = {
+  {"breakfast", 7 * 3600 + 1800, 2 * 3600, 0.75},
+  {"lunch", 12 * 3600, 2 * 3600, 0.90},
+  {"dinner", 19 * 3600, 2 * 3600, 0.80},
+};
+
+struct ReplayStats {
+  unsigned long scans;
+  unsigned long approved;
+  unsigned long manager_approved;
+  unsigned long denied;
+  unsigned long verify_errors;
+  unsigned long meals;
+  unsigned long served_per_hour[24];
+};
+
+static bool load_day(const char* path, std::vector<ReplayScan>& scans) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "replay: cannot open %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), f) != NULL) {
+    int h = 0, m = 0, s = 0;
+    char uid[64] = "";
+    float confidence = -1.0;
+    if (line[0] == '#' || sscanf(line, "%d:%d:%d %63s %f", &h, &m, &s, uid, &confidence) < 4) {
+      continue;
+    }
+    scans.push_back({(unsigned long)((h * 3600 + m * 60 + s) * 1000UL), String(uid), confidence, -1.0});
+  }
+  fclose(f);
+
+  std::stable_sort(scans.begin(), scans.end(),
+                   [](const ReplayScan& a, const ReplayScan& b) { return a.at_ms < b.at_ms; });
+  return true;
+}
+
+// Three meal services; arrivals peak mid-service. A few students tap twice,
+// a few have weak face matches (manager referral or deny) or low balances.
+// After the first day a few cards are also used between 03:00 and 05:00.
+static void synthetic_day(int students, unsigned long seed, int day, std::vector<ReplayScan>& scans) {
+  // Traits stay with a student from day to day; arrivals change
+  std::mt19937 trait_rng(seed);
+  std::mt19937 rng(seed + day);
+  auto uniform = [&rng]() { return (float)(rng() / (double)rng.max()); };
+
+  for (int i = 0; i < students; i++) {
+    char uid[16];
+    snprintf(uid, sizeof(uid), "%08X", 0xB2000000 + i);
+
+    float trait = (float)(trait_rng() / (double)trait_rng.max());
+    float confidence = -1.0;
+    float balance = -1.0;
+    if (trait < 0.01) {
+      confidence = 0.40 + 0.19 * uniform();  // Denied outright
+    } else if (trait < 0.06) {
+      confidence = 0.62 + 0.12 * uniform();  // Manager referral
+    } else if (trait < 0.08) {
+      balance = 60.0;                        // Under one meal
+    }
+
+    for (const ReplayMeal& meal : REPLAY_MEALS) {
+      if (uniform() >= meal.attendance) {
+        continue;
+      }
+      float offset = (uniform() + uniform()) / 2;
+      unsigned long at_ms = (meal.start_sec + (unsigned long)(offset * meal.length_sec)) * 1000UL;
+      scans.push_back({at_ms, String(uid), confidence, balance});
+      if (uniform() < 0.03) {
+        scans.push_back({at_ms + (60 + rng() % 540) * 1000UL, String(uid), confidence, balance});
+      }
+    }
+    if (day > 0 && uniform() < 0.01) {
+      scans.push_back({(3 * 3600 + rng() % (2 * 3600)) * 1000UL, String(uid), confidence, balance});
+    }
+  }
+
+  std::stable_sort(scans.begin(), scans.end(),
+                   [](const ReplayScan& a, const ReplayScan& b) { return a.at_ms < b.at_ms; });
+}
+
+static void replay_scan(const ReplayScan& scan, ReplayStats& stats) {
+  sim_clock_set_ms(scan.at_ms);
+  stats.scans++;
+  if (scan.confidence >= 0) {
+    sim_backend_set_confidence(scan.uid, scan.confidence);
+  }
+  if (scan.balance >= 0) {
+    sim_backend_set_balance(scan.uid, scan.balance);
+  }
+
+  String response = api_face_verify(scan.uid, REPLAY_FACE);
+  FaceVerificationResult fvr = FaceVerificationResult::fromJson(response);
+  if (response.length() == 0 || !fvr.success) {
+    stats.verify_errors++;
+    return;
+  }
+
+  FraudCheckResult fraud = check_all_fraud_rules(scan.uid, fvr);
+
+  // Same decision as DiningSystem::state_decision; the manager approves
+  // every referral
+  String status;
+  String reason;
+  if (!fraud.passes_all_rules) {
+    status = "denied";
+    reason = fraud.alert_reason;
+    stats.denied++;
+  } else if (fraud.requires_approval || fvr.needs_approval) {
+    status = "manual_approved";
+    reason = "Manager approved";
+    stats.manager_approved++;
+  } else {
+    status = "approved";
+    reason = "Auto-approved - matched credentials";
+    stats.approved++;
+  }
+  if (status != "denied") {
+    stats.served_per_hour[(scan.at_ms / 3600000) % 24]++;
+  }
+
+  Transaction t;
+  t.id = "TXN_" + String(clock_millis()) + "_" + String(random(1000, 9999));
+  t.timestamp = Helpers::getCurrentTimestamp();
+  t.student_id = fvr.student_id;
+  t.student_name = fvr.student_name;
+  t.rfid_uid = scan.uid;
+  t.status = status;
+  t.balance_before = fvr.balance;
+  t.balance_after = fvr.balance - REPLAY_MEAL_COST;
+  t.reason = reason;
+  t.fraud_alert = fraud.severity >= 2;
+  t.face_confidence = fvr.confidence;
+  t.synced = false;
+  t.offline_mode = false;
+  commit_pipeline_submit(t);  // Pipeline not started: commits inline
+}
+
+static String clock_string(unsigned long ms) {
+  char text[24];
+  if (ms >= REPLAY_DAY_MS) {
+    snprintf(text, sizeof(text), "day %lu %02lu:%02lu", ms / REPLAY_DAY_MS + 1, (ms / 3600000) % 24,
+             (ms / 60000) % 60);
+  } else {
+    snprintf(text, sizeof(text), "%02lu:%02lu", (ms / 3600000) % 24, (ms / 60000) % 60);
+  }
+  return String(text);
+}
+
+static void print_report(const std::vector<ReplayScan>& scans, const ReplayStats& stats, double wall_s) {
+  unsigned long first_ms = scans.front().at_ms;
+  unsigned long last_ms = scans.back().at_ms;
+  double span_s = (last_ms - first_ms) / 1000.0;
+
+  int peak_hour = 0;
+  for (int h = 1; h < 24; h++) {
+    if (stats.served_per_hour[h] > stats.served_per_hour[peak_hour]) {
+      peak_hour = h;
+    }
+  }
+
+  printf("\n==== Replay report ====\n");
+  printf("Scans:               %lu, %s-%s simulated, %lu meal services\n", stats.scans,
+         clock_string(first_ms).c_str(), clock_string(last_ms).c_str(), stats.meals);
+  printf("Wall time:           %.2f s, %.0f scans/s, %.0fx real time\n", wall_s, stats.scans / wall_s,
+         span_s / wall_s);
+  printf("Decisions:           %lu approved, %lu manager approved, %lu denied, %lu verify errors\n",
+         stats.approved, stats.manager_approved, stats.denied, stats.verify_errors);
+  printf("Peak hour:           %02d:00, %lu served (%.1f students/min)\n", peak_hour,
+         stats.served_per_hour[peak_hour], stats.served_per_hour[peak_hour] / 60.0);
+
+  // Rules in evaluation-cost order are skipped once a cheaper one denies
+  printf("\n%-24s %10s %8s %10s\n", "rule", "evaluated", "hits", "avg ns");
+  for (int i = 0; i < FRAUD_RULE_COUNT; i++) {
+    FraudRuleStats rule = fraud_get_rule_stats((FraudRuleId)i);
+    printf("%-24s %10lu %8lu %10.0f\n", fraud_rule_name((FraudRuleId)i), rule.evaluated, rule.hits,
+           rule.timed > 0 ? rule.cycles * 1000.0 / ESP.getCpuFreqMHz() / rule.timed : 0.0);
+  }
+}
+
+int replay_run(const ReplayOptions& options) {
+  std::vector<ReplayScan> scans;
+  for (int day = 0; day < max(options.days, 1); day++) {
+    std::vector<ReplayScan> day_scans;
+    if (options.path != NULL) {
+      if (!load_day(options.path, day_scans)) {
+        return 1;
+      }
+    } else {
+      synthetic_day(options.students, options.seed, day, day_scans);
+    }
+    for (ReplayScan& scan : day_scans) {
+      scan.at_ms += day * REPLAY_DAY_MS;
+      scans.push_back(scan);
+    }
+  }
+  if (scans.empty()) {
+    fprintf(stderr, "replay: no scans\n");
+    return 1;
+  }
+
+  // Day starts at midnight; transaction timestamps are seconds since then
+  sim_clock_install(0);
+  sim_http_set_handler(sim_backend_handle);
+  cache_init();
+  fraud_window_init();
+  profile_init();
+  fraud_reset_stats();
+  wifi_init("sim", "sim");
+  api_set_server("127.0.0.1", 5000);
+  sim_serial_set_echo(false);
+
+  ReplayStats stats = {};
+  unsigned long previous_ms = 0;
+  auto wall_start = std::chrono::steady_clock::now();
+  for (const ReplayScan& scan : scans) {
+    if (stats.scans == 0 || scan.at_ms - previous_ms >= REPLAY_MEAL_GAP_MS) {
+      sim_backend_reset_served();
+      stats.meals++;
+    }
+    previous_ms = scan.at_ms;
+    replay_scan(scan, stats);
+  }
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+  sim_serial_set_echo(true);
+  print_report(scans, stats, wall_s);
+  return 0;
+}
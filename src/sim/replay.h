@@ -0,0 +1,26 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <Arduino.h>
+
+// Accelerated replay of a day of scans. Each scan goes through face-verify
+// (in-process backend), the fraud rules and the commit path on the virtual
+// clock, so a full day of time windows is exercised in seconds.
+//
+// Recorded days are text files, one scan per line:
+//   HH:MM:SS <uid> [confidence]
+// Without a file a synthetic day is generated: three meal services with
+// repeat taps, weak face matches and low balances mixed in. Over several
+// days, later days also have a few night-time scans for the visit profiles
+// to flag.
+
+struct ReplayOptions {
+  const char* path;      // Recorded day, or NULL for a synthetic one
+  int students;          // Synthetic day: population size
+  unsigned long seed;    // Synthetic day: same seed, same day
+  int days;              // Consecutive days; synthetic students keep their traits
+};
+
+int replay_run(const ReplayOptions& options);
+
+#endif
@@ -0,0 +1,192 @@
+#include "sim_backend.h"
+#include <ArduinoJson.h>
+#include <map>
+#include <mutex>
+
+#define SIM_DEFAULT_BALANCE 500.0
+#define SIM_DEFAULT_CONFIDENCE 0.92
+#define SIM_MEAL_COST 100.0
+
+struct SimStudent {
+  String student_id;
+  String name;
+  float balance;
+  float confidence;
+  bool served_today;
+};
+
+static std::map<String, SimStudent> students;  // By RFID UID
+static SimBackendStats backend_stats = {0, 0, 0, 0, 0, 0, 0, 0};
+static float backend_error_rate = 0.0;
+static int backend_sync_ack_limit = 0;
+static std::recursive_mutex backend_lock;
+
+static SimStudent& student_for(const String& rfid_uid) {
+  auto it = students.find(rfid_uid);
+  if (it == students.end()) {
+    SimStudent s;
+    s.student_id = "STU_" + rfid_uid;
+    s.name = "Student " + rfid_uid;
+    s.balance = SIM_DEFAULT_BALANCE;
+    s.confidence = SIM_DEFAULT_CONFIDENCE;
+    s.served_today = false;
+    it = students.emplace(rfid_uid, s).first;
+  }
+  return it->second;
+}
+
+static SimStudent* student_by_id(const String& student_id) {
+  for (auto& entry : students) {
+    if (entry.second.student_id == student_id) {
+      return &entry.second;
+    }
+  }
+  return NULL;
+}
+
+static int handle_face_verify(const String& body, String& response) {
+  JsonDocument req;
+  if (deserializeJson(req, body) != DeserializationError::Ok) {
+    return 400;
+  }
+  backend_stats.verify_requests++;
+
+  String rfid_uid = req["rfid_uid"] | "";
+  String face = req["face_image"] | "";
+  SimStudent& s = student_for(rfid_uid);
+
+  JsonDocument doc;
+  if (face.length() == 0) {
+    doc["status"] = "error";
+    doc["reason"] = "No face image";
+  } else {
+    doc["status"] = "success";
+    doc["student_id"] = s.student_id;
+    doc["student_name"] = s.name;
+    doc["confidence"] = s.confidence;
+    doc["eligible"] = s.balance >= SIM_MEAL_COST && !s.served_today;
+    doc["balance"] = s.balance;
+    doc["meal_plan"] = "active";
+    doc["already_served_today"] = s.served_today;
+    doc["approval_required"] = false;
+    doc["reason"] = "";
+  }
+  serializeJson(doc, response);
+  return 200;
+}
+
+static int handle_log(const String& body, String& response) {
+  JsonDocument req;
+  if (deserializeJson(req, body) != DeserializationError::Ok) {
+    return 400;
+  }
+  backend_stats.log_requests++;
+
+  String status = req["approval_status"] | "";
+  SimStudent* s = student_by_id(req["student_id"] | "");
+  if (status == "denied") {
+    backend_stats.denied_logged++;
+  } else {
+    backend_stats.approved_logged++;
+    if (s != NULL) {
+      s->balance = req["balance_after"] | s->balance;
+      s->served_today = true;
+    }
+  }
+
+  response = "{\"status\":\"success\"}";
+  return 200;
+}
+
+static int handle_sync(const String& body, String& response) {
+  JsonDocument req;
+  if (deserializeJson(req, body) != DeserializationError::Ok) {
+    return 400;
+  }
+  backend_stats.sync_requests++;
+
+  JsonArray arr = req["transactions"].as<JsonArray>();
+  JsonDocument doc;
+  doc["status"] = "success";
+  JsonArray acked = doc["acked"].to<JsonArray>();
+  for (JsonObject obj : arr) {
+    if (backend_sync_ack_limit > 0 && (int)acked.size() >= backend_sync_ack_limit) {
+      break;
+    }
+    acked.add(obj["id"] | "");
+  }
+  backend_stats.synced_records += acked.size();
+  doc["synced_count"] = acked.size();
+  serializeJson(doc, response);
+  return 200;
+}
+
+static int handle_balance(const String& path, String& response) {
+  // /api/student/<id>/balance
+  String student_id = path.substring(13, path.length() - 8);
+  SimStudent* s = student_by_id(student_id);
+  if (s == NULL) {
+    response = "{\"status\":\"error\",\"reason\":\"Unknown student\"}";
+    return 404;
+  }
+
+  JsonDocument doc;
+  doc["status"] = "success";
+  doc["student_id"] = s->student_id;
+  doc["balance"] = s->balance;
+  serializeJson(doc, response);
+  return 200;
+}
+
+int sim_backend_handle(const String& method, const String& path, const String& body, String& response) {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  backend_stats.bytes_in += body.length();
+
+  int code = 404;
+  if (backend_error_rate > 0.0 && random(0, 10000) < backend_error_rate * 10000) {
+    code = 500;
+  } else if (method == "POST" && path == "/api/auth/face-verify") {
+    code = handle_face_verify(body, response);
+  } else if (method == "POST" && path == "/api/transactions/log") {
+    code = handle_log(body, response);
+  } else if (method == "POST" && path == "/api/transactions/sync-batch") {
+    code = handle_sync(body, response);
+  } else if (method == "GET" && path.startsWith("/api/student/") && path.endsWith("/balance")) {
+    code = handle_balance(path, response);
+  }
+
+  backend_stats.bytes_out += response.length();
+  return code;
+}
+
+void sim_backend_set_confidence(const String& rfid_uid, float confidence) {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  student_for(rfid_uid).confidence = confidence;
+}
+
+void sim_backend_set_balance(const String& rfid_uid, float balance) {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  student_for(rfid_uid).balance = balance;
+}
+
+void sim_backend_set_error_rate(float rate) {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  backend_error_rate = rate;
+}
+
+void sim_backend_set_sync_ack_limit(int records) {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  backend_sync_ack_limit = records;
+}
+
+void sim_backend_reset_served() {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  for (auto& entry : students) {
+    entry.second.served_today = false;
+  }
+}
+
+SimBackendStats sim_backend_get_stats() {
+  std::lock_guard<std::recursive_mutex> guard(backend_lock);
+  return backend_stats;
+}
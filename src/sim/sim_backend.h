@@ -0,0 +1,30 @@
+#ifndef SIM_BACKEND_H
+#define SIM_BACKEND_H
+
+#include <Arduino.h>
+
+// In-process stand-in for the dining server. Any card is a known student
+// ("STU_<uid>", Rs. 500) unless overridden; approved meals are deducted and
+// marked served for the day.
+
+struct SimBackendStats {
+  unsigned long verify_requests;
+  unsigned long log_requests;
+  unsigned long sync_requests;
+  unsigned long synced_records;
+  unsigned long approved_logged;
+  unsigned long denied_logged;
+  unsigned long bytes_in;
+  unsigned long bytes_out;
+};
+
+int sim_backend_handle(const String& method, const String& path, const String& body, String& response);
+
+void sim_backend_set_confidence(const String& rfid_uid, float confidence);
+void sim_backend_set_balance(const String& rfid_uid, float balance);
+void sim_backend_set_error_rate(float rate);  // Fraction of requests answered 500
+void sim_backend_set_sync_ack_limit(int records);  // Most records stored per sync-batch, 0: all
+void sim_backend_reset_served();  // New meal service: every student may eat again
+SimBackendStats sim_backend_get_stats();
+
+#endif
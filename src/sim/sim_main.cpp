@@ -0,0 +1,329 @@
+// Full-system simulator: the firmware's state machine, tasks and services on
+// host peripherals (hal/native), driven by a scan script.
+//
+//   sim [script] [--backend host:port] [--students N] [--interval MS] [--oled]
+//       [--terminal ID] [--hub-listen PORT | --hub host:port] [--flash image]
+//       [--local-match APPROVE[:REJECT]] [--blocking-results]
+//   sim --replay [day.txt] [--students N] [--seed S] [--days D]
+//
+// --replay skips the real-time run and replays a recorded or synthetic day
+// of scans on the virtual clock (see replay.h). --terminal sets the device
+// id; sims started with different ids on one machine are separate terminals
+// sharing serves over loopback multicast (see peer_sync.h). --hub-listen
+// makes this sim the hall's hub, its routes reachable on 127.0.0.1:PORT;
+// --hub points a sim at one (see hub_service.h). --flash keeps SPIFFS in a
+// host file between runs, so a second run boots on what the first left.
+// --local-match sets the local fast path's descriptor similarity thresholds
+// (see local_verification.h) instead of the ones derived from
+// min_face_confidence; 0 turns a side off.
+// --blocking-results holds each result screen and the transaction log
+// with delay() and returns through IDLE, the state machine's old
+// behaviour, as the baseline for the throughput figure.
+//
+// Script lines are "<ms> <command> [args]", times relative to "System Ready":
+//   motion on|off        PIR level
+//   tap <uid>            card tap; the synthetic camera shows that student
+//   key <k>              0-9, approve, deny, retry, override, star, hash
+//   frame <file.pgm>     camera shows this image ("frame synthetic" to go back)
+//   wifi up|down         access point in range or not
+//   camera_ms <n>        sensor readout time per frame
+//   latency_ms <n>       added to every HTTP request
+//   confidence <uid> <f> face match score the backend returns for a card
+//   peer_loss <pct>      outgoing peer datagrams dropped at random
+//   backend_errors <f>   fraction of backend requests answered 500
+//   sync_ack <n>         backend stores at most n records per sync-batch (0: all)
+//   end                  stop after the serve in progress has finished
+
+#include <Arduino.h>
+#include <vector>
+#include <thread>
+#include <unistd.h>
+#include "../hal/native/sim_hal.h"
+#include "sim_backend.h"
+#include "replay.h"
+#include "../app/dining_system.h"
+#include "../config/data_types.h"
+#include "../config/config.h"
+#include "../modules/keyboard_module.h"
+#include "../services/commit_pipeline.h"
+#include "../services/peer_sync.h"
+#include "../services/hub_service.h"
+#include "../utils/event_bus.h"
+#include "../utils/helpers.h"
+#include "../utils/trace.h"
+#include "../utils/logger.h"
+
+#define SIM_DRAIN_MS 5000  // Idle time after "end" for the last serve to finish
+
+struct SimStep {
+  unsigned long at_ms;
+  String command;
+  String arg;
+  String arg2;
+};
+
+DiningSystem diningSystem;
+volatile bool sim_running = true;
+
+static int key_code(const String& name) {
+  if (name == "approve") return KEY_APPROVE;
+  if (name == "deny") return KEY_DENY;
+  if (name == "retry") return KEY_RETRY;
+  if (name == "override") return KEY_OVERRIDE;
+  if (name == "star") return KEY_STAR;
+  if (name == "hash") return KEY_HASH;
+  return name.length() == 1 && isdigit(name[0]) ? name[0] - '0' : -1;
+}
+
+static bool load_script(const char* path, std::vector<SimStep>& steps) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "sim: cannot open %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char command[32] = "";
+    char arg[128] = "";
+    char arg2[64] = "";
+    unsigned long at_ms = 0;
+    if (line[0] == '#' || sscanf(line, "%lu %31s %127s %63s", &at_ms, command, arg, arg2) < 2) {
+      continue;
+    }
+    steps.push_back({at_ms, String(command), String(arg), String(arg2)});
+  }
+  fclose(f);
+
+  for (size_t i = 1; i < steps.size(); i++) {
+    if (steps[i].at_ms < steps[i - 1].at_ms) {
+      fprintf(stderr, "sim: %s: steps must be in time order\n", path);
+      return false;
+    }
+  }
+  return true;
+}
+
+// One student every interval, each a distinct card
+static void synthetic_script(int students, unsigned long interval_ms, std::vector<SimStep>& steps) {
+  steps.push_back({0, "motion", "on", ""});
+  for (int i = 0; i < students; i++) {
+    char uid[16];
+    snprintf(uid, sizeof(uid), "%08X", 0xA1000000 + i);
+    steps.push_back({3000 + i * interval_ms, "tap", uid, ""});
+  }
+  steps.push_back({3000 + students * interval_ms, "end", "", ""});
+}
+
+static void run_step(const SimStep& step) {
+  if (step.command == "motion") {
+    sim_motion(step.arg == "on");
+  } else if (step.command == "tap") {
+    sim_camera_set_subject(step.arg.c_str());
+    sim_rfid_tap(step.arg.c_str());
+  } else if (step.command == "key") {
+    if (!sim_key_press(key_code(step.arg))) {
+      Logger::logError("Sim: Unknown key " + step.arg);
+    }
+  } else if (step.command == "frame") {
+    sim_camera_load_frame(step.arg == "synthetic" ? "" : step.arg.c_str());
+  } else if (step.command == "wifi") {
+    sim_wifi_set_available(step.arg == "up");
+  } else if (step.command == "camera_ms") {
+    sim_camera_set_capture_ms(step.arg.toInt());
+  } else if (step.command == "latency_ms") {
+    sim_http_set_latency_ms(step.arg.toInt());
+  } else if (step.command == "confidence") {
+    sim_backend_set_confidence(step.arg, step.arg2.toFloat());
+  } else if (step.command == "peer_loss") {
+    sim_udp_set_loss_percent(step.arg.toInt());
+  } else if (step.command == "backend_errors") {
+    sim_backend_set_error_rate(step.arg.toFloat());
+  } else if (step.command == "sync_ack") {
+    sim_backend_set_sync_ack_limit(step.arg.toInt());
+  } else {
+    Logger::logError("Sim: Unknown command " + step.command);
+  }
+}
+
+static void script_driver(std::vector<SimStep> steps, unsigned long start_ms) {
+  for (const SimStep& step : steps) {
+    unsigned long due = start_ms + step.at_ms;
+    if ((long)(due - millis()) > 0) {
+      delay(due - millis());
+    }
+    if (step.command == "end") {
+      break;
+    }
+    run_step(step);
+  }
+
+  // Let the serve in progress finish, then wake the state machine to exit
+  delay(SIM_DRAIN_MS);
+  sim_running = false;
+  event_post(EVENT_NONE);
+}
+
+static void print_report(unsigned long elapsed_ms) {
+  SimBackendStats backend = sim_backend_get_stats();
+  CommitPipelineStats commits = commit_pipeline_get_stats();
+
+  printf("\n==== Simulation report (%.1f s) ====\n", elapsed_ms / 1000.0);
+  printf("State at exit:       %s\n", Helpers::getStateName(diningSystem.get_state()).c_str());
+  printf("Transactions:        %lu committed, %lu logged approved, %lu logged denied\n",
+         commits.committed, backend.approved_logged, backend.denied_logged);
+  printf("Throughput:          %.1f students/min\n", diningSystem.get_students_per_minute());
+  printf("Backend:             %lu verify, %lu log, %lu sync (%lu records), %lu B in / %lu B out\n",
+         backend.verify_requests, backend.log_requests, backend.sync_requests, backend.synced_records,
+         backend.bytes_in, backend.bytes_out);
+  PeerSyncStats peers = peer_sync_get_stats();
+  if (peers.published + peers.merged > 0) {
+    printf("Peer sync:           %d peers, %lu published, %lu merged, %lu resent, %lu unrecoverable\n",
+           peers.peers, peers.published, peers.merged, peers.repaired, peers.unrecoverable);
+  }
+  HubStats hub = hub_get_stats();
+  if (hub_is_active()) {
+    printf("Hub:                 %lu received, %lu forwarded in %lu batches, %d queued, roster %d\n",
+           hub.received, hub.forwarded, hub.batches, hub.queued, hub.roster_size);
+  }
+  printf("Camera frames:       %lu\n", sim_camera_frames());
+  printf("OLED frames:         %lu, last:\n%s\n", sim_oled_frames(), sim_oled_text().c_str());
+
+  printf("\n%-12s %8s %10s %10s %10s %10s\n", "stage", "count", "p50 ms", "p95 ms", "p99 ms", "max ms");
+  for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+    TraceSummary s = trace_get_summary((TraceStage)i);
+    if (s.count == 0) {
+      continue;
+    }
+    printf("%-12s %8u %10.2f %10.2f %10.2f %10.2f\n", trace_stage_name((TraceStage)i), s.count,
+           s.p50_us / 1000.0, s.p95_us / 1000.0, s.p99_us / 1000.0, s.max_us / 1000.0);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* script_path = NULL;
+  String backend = "";
+  String terminal = "";
+  const char* flash_path = NULL;
+  String hub = "";
+  String local_match = "";
+  int hub_listen = 0;
+  int students = -1;
+  unsigned long interval_ms = 4000;
+  unsigned long seed = 1;
+  int days = 1;
+  bool echo_oled = false;
+  bool blocking_results = false;
+  bool replay = false;
+
+  for (int i = 1; i < argc; i++) {
+    String arg(argv[i]);
+    if (arg == "--backend" && i + 1 < argc) {
+      backend = argv[++i];
+    } else if (arg == "--students" && i + 1 < argc) {
+      students = atoi(argv[++i]);
+    } else if (arg == "--interval" && i + 1 < argc) {
+      interval_ms = strtoul(argv[++i], NULL, 10);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else if (arg == "--days" && i + 1 < argc) {
+      days = atoi(argv[++i]);
+    } else if (arg == "--terminal" && i + 1 < argc) {
+      terminal = argv[++i];
+    } else if (arg == "--flash" && i + 1 < argc) {
+      flash_path = argv[++i];
+    } else if (arg == "--hub-listen" && i + 1 < argc) {
+      hub_listen = atoi(argv[++i]);
+    } else if (arg == "--hub" && i + 1 < argc) {
+      hub = argv[++i];
+    } else if (arg == "--local-match" && i + 1 < argc) {
+      local_match = argv[++i];
+    } else if (arg == "--blocking-results") {
+      blocking_results = true;
+    } else if (arg == "--oled") {
+      echo_oled = true;
+    } else if (arg == "--replay") {
+      replay = true;
+    } else if (arg.startsWith("-")) {
+      fprintf(stderr, "usage: %s [script] [--backend host:port] [--students N] [--interval MS] [--oled]\n"
+                      "          [--terminal ID] [--hub-listen PORT | --hub host:port] [--flash image]\n"
+                      "          [--local-match APPROVE[:REJECT]] [--blocking-results]\n"
+                      "       %s --replay [day.txt] [--students N] [--seed S] [--days D]\n", argv[0], argv[0]);
+      return 2;
+    } else {
+      script_path = argv[i];
+    }
+  }
+
+  if (replay) {
+    ReplayOptions options = {script_path, students > 0 ? students : 600, seed, days};
+    int status = replay_run(options);
+    fflush(stdout);
+    _exit(status);
+  }
+
+  std::vector<SimStep> steps;
+  if (script_path != NULL) {
+    if (!load_script(script_path, steps)) {
+      return 1;
+    }
+  } else {
+    synthetic_script(students > 0 ? students : 20, interval_ms, steps);
+  }
+
+  if (flash_path != NULL && sim_fs_load(flash_path)) {
+    printf("Sim: SPIFFS loaded from %s (%u bytes)\n", flash_path, (unsigned)sim_fs_used_bytes());
+  }
+  SystemConfig config = load_config();
+  config.wifi_ssid = "sim";
+  config.wifi_password = "sim";
+  config.server_ip = "127.0.0.1";
+  config.server_port = 5000;
+  if (terminal.length() > 0) {
+    config.device_id = terminal;
+  }
+  if (hub_listen > 0) {
+    config.hub_mode = true;
+    if (!sim_web_listen(hub_listen)) {
+      fprintf(stderr, "sim: cannot listen on port %d\n", hub_listen);
+      return 1;
+    }
+  } else if (hub.length() > 0) {
+    int colon = hub.indexOf(':');
+    config.hub_ip = colon >= 0 ? hub.substring(0, colon) : hub;
+    config.hub_port = colon >= 0 ? hub.substring(colon + 1).toInt() : 80;
+    sim_http_set_direct(config.hub_ip, config.hub_port);
+  }
+  if (local_match.length() > 0) {
+    int colon = local_match.indexOf(':');
+    config.local_approve_similarity = (colon >= 0 ? local_match.substring(0, colon) : local_match).toFloat();
+    config.local_reject_similarity = colon >= 0 ? local_match.substring(colon + 1).toFloat() : 0.0;
+  }
+  if (backend.length() > 0) {
+    int colon = backend.indexOf(':');
+    config.server_ip = colon >= 0 ? backend.substring(0, colon) : backend;
+    config.server_port = colon >= 0 ? backend.substring(colon + 1).toInt() : 80;
+  } else {
+    sim_http_set_handler(sim_backend_handle);
+  }
+  sim_oled_set_echo(echo_oled);
+
+  diningSystem.set_blocking_results(blocking_results);
+  diningSystem.init(config);
+
+  unsigned long start_ms = millis();
+  std::thread driver(script_driver, steps, start_ms);
+  driver.detach();
+
+  while (sim_running) {
+    diningSystem.update();
+  }
+
+  print_report(millis() - start_ms);
+  if (flash_path != NULL && !sim_fs_save(flash_path)) {
+    fprintf(stderr, "sim: cannot write %s\n", flash_path);
+  }
+  fflush(stdout);
+  // Firmware tasks never return; leave without unwinding them
+  _exit(0);
+}
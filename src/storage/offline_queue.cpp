@@ -0,0 +1,367 @@
+#include "offline_queue.h"
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include "../utils/logger.h"
+
+#define OFFLINE_HEAD_MAGIC 0x4448514F  // "OQHD"
+
+// Which log is current and where its first unacknowledged record starts.
+// Compaction writes the other log, then this, then removes the old log, so
+// a reset at any point leaves a head that matches an intact file.
+struct OfflineHead {
+  uint32_t magic;
+  uint32_t log;     // 0: OFFLINE_LOG_A, 1: OFFLINE_LOG_B
+  uint32_t offset;
+  uint32_t check;   // ~(magic ^ log ^ offset)
+};
+
+bool offline_ready = false;
+SemaphoreHandle_t offline_mutex = NULL;  // Storage task, and the hub's web handlers
+int offline_log = 0;
+uint32_t offline_head = 0;
+uint32_t offline_tail = 0;  // Log file size
+uint32_t offline_generation = 0;  // Bumped by every compaction
+bool offline_torn = false;         // Partial record at the end, cut off before the next append
+OfflineQueueStats offline_stats = {0, 0, 0, 0, 0, 0, 0};
+
+struct OfflineLock {
+  OfflineLock() {
+    if (offline_mutex != NULL) {
+      xSemaphoreTakeRecursive(offline_mutex, portMAX_DELAY);
+    }
+  }
+  ~OfflineLock() {
+    if (offline_mutex != NULL) {
+      xSemaphoreGiveRecursive(offline_mutex);
+    }
+  }
+};
+
+static const char* log_path(int log) {
+  return log == 0 ? OFFLINE_LOG_A : OFFLINE_LOG_B;
+}
+
+static bool write_head(int log, uint32_t offset) {
+  OfflineHead head = {OFFLINE_HEAD_MAGIC, (uint32_t)log, offset, 0};
+  head.check = ~(head.magic ^ head.log ^ head.offset);
+  File file = SPIFFS.open(OFFLINE_HEAD_FILE, "w");
+  if (!file) {
+    return false;
+  }
+  bool written = file.write((const uint8_t*)&head, sizeof(head)) == sizeof(head);
+  file.close();
+  return written;
+}
+
+static bool read_head(OfflineHead& head) {
+  File file = SPIFFS.open(OFFLINE_HEAD_FILE, "r");
+  if (!file) {
+    return false;
+  }
+  bool complete = file.read((uint8_t*)&head, sizeof(head)) == sizeof(head);
+  file.close();
+  return complete && head.magic == OFFLINE_HEAD_MAGIC && head.log <= 1 &&
+         head.check == ~(head.magic ^ head.log ^ head.offset);
+}
+
+// One JSON line. False at the end of the file, including a last line with
+// no newline (a reset mid-append). An overlong line is skipped and comes
+// back empty, so the records after it are still read.
+static bool read_record(File& file, String& line) {
+  line = "";
+  bool overlong = false;
+  int c;
+  while ((c = file.read()) >= 0) {
+    if (c == '\n') {
+      if (overlong) {
+        line = "";
+      }
+      return true;
+    }
+    if (line.length() >= OFFLINE_RECORD_MAX) {
+      overlong = true;
+      continue;
+    }
+    line += (char)c;
+  }
+  return false;
+}
+
+// A line that does not parse may be a partial record with a whole one
+// glued on after it (a short write in a build before the tail was cut
+// back). The whole one is kept; false if nothing usable is left.
+static bool salvage_record(String& line) {
+  JsonDocument doc;
+  if (line.length() > 0 && deserializeJson(doc, line) == DeserializationError::Ok) {
+    return true;
+  }
+  int start = line.lastIndexOf("{\"id\":");
+  if (start <= 0) {
+    return false;
+  }
+  line = line.substring(start);
+  return deserializeJson(doc, line) == DeserializationError::Ok;
+}
+
+// Copies the records from the head on into the other log and makes it
+// current. Damaged records are repaired or dropped, and a torn last one
+// stays behind.
+static bool compact() {
+  int target = 1 - offline_log;
+  File out = SPIFFS.open(log_path(target), "w");
+  if (!out) {
+    Logger::logError("Offline Queue: Cannot write " + String(log_path(target)));
+    return false;
+  }
+
+  int pending = 0;
+  size_t size = 0;
+  bool complete = true;
+  File in = SPIFFS.open(log_path(offline_log), "r");
+  if (in && in.seek(offline_head)) {
+    String line;
+    while (complete && read_record(in, line)) {
+      if (!salvage_record(line)) {
+        offline_stats.recovered++;
+        Logger::logError("Offline Queue: Dropped an unreadable record");
+        continue;
+      }
+      line += '\n';
+      size_t written = out.write((const uint8_t*)line.c_str(), line.length());
+      size += written;
+      complete = written == line.length();
+      pending++;
+    }
+  }
+  if (in) {
+    in.close();
+  }
+  out.close();
+
+  // Flash full: keep the current log as it is
+  if (!complete || !write_head(target, 0)) {
+    SPIFFS.remove(log_path(target));
+    Logger::logError("Offline Queue: Write failed, compaction abandoned");
+    return false;
+  }
+  SPIFFS.remove(log_path(offline_log));
+  offline_log = target;
+  offline_head = 0;
+  offline_tail = size;
+  offline_stats.pending = pending;
+  offline_stats.compactions++;
+  offline_generation++;  // Offsets from an earlier peek no longer apply
+  offline_torn = false;
+  return true;
+}
+
+bool offline_queue_init() {
+  if (offline_mutex == NULL) {
+    offline_mutex = xSemaphoreCreateRecursiveMutex();
+  }
+  OfflineLock lock;
+  if (!SPIFFS.begin(true)) {
+    Logger::logError("Offline Queue: SPIFFS init failed");
+    return false;
+  }
+
+  OfflineHead head;
+  if (read_head(head) && SPIFFS.exists(log_path(head.log))) {
+    offline_log = head.log;
+    offline_head = head.offset;
+  } else {
+    // No usable head: from the start of whichever log is there. At worst
+    // the server sees some records twice.
+    if (SPIFFS.exists(OFFLINE_HEAD_FILE)) {
+      Logger::logError("Offline Queue: Head damaged, resending from the start");
+    }
+    offline_log = SPIFFS.exists(OFFLINE_LOG_B) && !SPIFFS.exists(OFFLINE_LOG_A) ? 1 : 0;
+    offline_head = 0;
+  }
+  if (SPIFFS.exists(log_path(1 - offline_log))) {
+    SPIFFS.remove(log_path(1 - offline_log));  // Left by an interrupted compaction
+  }
+
+  File file = SPIFFS.open(log_path(offline_log), "r");
+  if (!file) {
+    file = SPIFFS.open(log_path(offline_log), "w");
+    if (!file || !write_head(offline_log, 0)) {
+      Logger::logError("Offline Queue: Cannot create " + String(log_path(offline_log)));
+      return false;
+    }
+    file.close();
+    offline_head = 0;
+    offline_tail = 0;
+    offline_stats.pending = 0;
+    offline_ready = true;
+    return true;
+  }
+
+  offline_tail = file.size();
+  if (offline_head > offline_tail) {
+    offline_head = 0;
+  }
+
+  // Count what is left. A torn last record means a reset mid-append; a
+  // damaged one further in, a short write before the tail was cut back.
+  int pending = 0;
+  int damaged = 0;
+  uint32_t end_of_records = offline_head;
+  String line;
+  file.seek(offline_head);
+  while (read_record(file, line)) {
+    JsonDocument doc;
+    if (line.length() == 0 || deserializeJson(doc, line) != DeserializationError::Ok) {
+      damaged++;
+    }
+    pending++;
+    end_of_records = file.position();
+  }
+  file.close();
+  offline_stats.pending = pending;
+  offline_ready = true;
+
+  if (end_of_records < offline_tail) {
+    offline_stats.recovered++;
+    Logger::logError("Offline Queue: Dropped a torn record at the end of the log");
+  }
+  if (damaged > 0) {
+    Logger::logError("Offline Queue: " + String(damaged) + " damaged records, repairing");
+  }
+  if ((end_of_records < offline_tail || damaged > 0) && !compact()) {
+    offline_torn = end_of_records < offline_tail;
+  }
+  if (offline_stats.pending > 0) {
+    Logger::logInfo("Offline Queue: " + String(offline_stats.pending) +
+                    " transactions left from before the restart");
+  }
+  return true;
+}
+
+bool offline_queue_append(Transaction t) {
+  OfflineLock lock;
+  if (!offline_ready && !offline_queue_init()) {
+    return false;
+  }
+
+  String line = t.toJson();
+  if (line.length() >= OFFLINE_RECORD_MAX) {
+    offline_stats.dropped++;
+    Logger::logError("Offline Queue: Record too long, dropped " + t.id);
+    return false;
+  }
+  line += '\n';
+
+  // A partial record still at the end would swallow this one
+  if (offline_torn && !compact()) {
+    offline_stats.dropped++;
+    Logger::logError("Offline Queue: Torn log not repaired, dropped " + t.id);
+    return false;
+  }
+
+  // Full: reclaim the acknowledged part, else refuse
+  if (offline_tail + line.length() > OFFLINE_QUEUE_MAX_BYTES &&
+      (offline_head == 0 || !compact() || offline_tail + line.length() > OFFLINE_QUEUE_MAX_BYTES)) {
+    offline_stats.dropped++;
+    Logger::logError("Offline Queue: Full, dropped " + t.id);
+    return false;
+  }
+
+  File file = SPIFFS.open(log_path(offline_log), "a");
+  if (!file) {
+    offline_stats.dropped++;
+    Logger::logError("Offline Queue: Cannot append to " + String(log_path(offline_log)));
+    return false;
+  }
+  size_t written = file.write((const uint8_t*)line.c_str(), line.length());
+  file.close();
+  offline_tail += written;
+  if (written != line.length()) {
+    // Cut the partial line off again (compaction leaves it behind), now
+    // or before the next append. The caller still has the record.
+    offline_torn = !compact();
+    offline_stats.dropped++;
+    Logger::logError("Offline Queue: Short write, dropped " + t.id);
+    return false;
+  }
+
+  offline_stats.pending++;
+  offline_stats.appended++;
+  return true;
+}
+
+int offline_queue_peek(std::vector<Transaction>& out, std::vector<uint32_t>& ends, int max,
+                       size_t max_bytes, uint32_t& generation) {
+  OfflineLock lock;
+  generation = offline_generation;
+  if (!offline_ready || offline_stats.pending == 0 || max <= 0) {
+    return 0;
+  }
+  File file = SPIFFS.open(log_path(offline_log), "r");
+  if (!file || !file.seek(offline_head)) {
+    return 0;
+  }
+
+  // Records that cannot be salvaged are returned without an id, so they
+  // are acknowledged away with the rest instead of blocking the queue
+  int count = 0;
+  size_t bytes = 0;
+  String line;
+  while (count < max && read_record(file, line)) {
+    bytes += line.length() + 1;
+    if (count > 0 && bytes > max_bytes) {
+      break;
+    }
+    if (!salvage_record(line)) {
+      line = "";
+    }
+    out.push_back(Transaction::fromJson(line));
+    ends.push_back(file.position());
+    count++;
+  }
+  file.close();
+  return count;
+}
+
+bool offline_queue_advance(uint32_t generation, uint32_t next_offset, int count) {
+  OfflineLock lock;
+  // A compaction since the peek moved the records; they go again
+  if (!offline_ready || generation != offline_generation ||
+      next_offset <= offline_head || next_offset > offline_tail) {
+    return false;
+  }
+  if (!write_head(offline_log, next_offset)) {
+    Logger::logError("Offline Queue: Head write failed, records will be sent again");
+    return false;
+  }
+  offline_head = next_offset;
+  offline_stats.pending = max(0, offline_stats.pending - count);
+  offline_stats.acknowledged += count;
+
+  // Drained: start an empty log instead of growing this one
+  if (offline_stats.pending == 0) {
+    compact();
+  }
+  return true;
+}
+
+int offline_queue_pending() {
+  return offline_stats.pending;
+}
+
+OfflineQueueStats offline_queue_get_stats() {
+  OfflineLock lock;
+  OfflineQueueStats stats = offline_stats;
+  stats.bytes = offline_tail;
+  return stats;
+}
+
+void offline_queue_log_stats() {
+  if (offline_stats.appended == 0 && offline_stats.pending == 0) {
+    return;
+  }
+  Logger::logf("[INFO] Offline Queue: %d pending, %u bytes, %lu appended, %lu acknowledged, "
+               "%lu dropped, %lu compactions",
+               offline_stats.pending, (unsigned)offline_tail, offline_stats.appended,
+               offline_stats.acknowledged, offline_stats.dropped, offline_stats.compactions);
+}
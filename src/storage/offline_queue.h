@@ -0,0 +1,52 @@
+#ifndef OFFLINE_QUEUE_H
+#define OFFLINE_QUEUE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../config/data_types.h"
+
+// Transactions waiting for the server, in SPIFFS so a brownout during an
+// outage loses nothing. Records are appended to a log file as JSON lines;
+// the read position lives in a small head file, rewritten as records are
+// acknowledged. RAM holds only the cursor and counts. On the hub the
+// transactions it relays for other terminals wait here too.
+//
+// Delivery is at least once: a head write lost to a reset resends records
+// the server has already seen, never the other way round. Transaction ids
+// let the server drop the repeats.
+
+#define OFFLINE_LOG_A "/offline_a.log"
+#define OFFLINE_LOG_B "/offline_b.log"     // Compaction target, alternating with A
+#define OFFLINE_HEAD_FILE "/offline.head"
+#define OFFLINE_QUEUE_MAX_BYTES (64 * 1024)
+#define OFFLINE_RECORD_MAX 1024            // Longer lines are treated as damage
+
+struct OfflineQueueStats {
+  int pending;
+  size_t bytes;                // Log file size, acknowledged records included
+  unsigned long appended;
+  unsigned long acknowledged;
+  unsigned long dropped;       // Refused: log full, or a failed write
+  unsigned long compactions;
+  unsigned long recovered;     // Torn or unreadable records dropped
+};
+
+// Opens the log and counts what a previous boot left unsent
+bool offline_queue_init();
+bool offline_queue_append(Transaction t);
+// Up to max records from the head, fewer once their lines pass max_bytes
+// (always at least one). ends[i] is where the head moves once out[i] and
+// everything before it are acknowledged. A damaged record comes back with
+// an empty id, to be acknowledged without sending.
+//
+// Appends may come from other tasks (the hub's web handlers) and can
+// compact the log. generation ties the offsets to the log they were read
+// from; advance refuses stale ones and the records are simply sent again.
+int offline_queue_peek(std::vector<Transaction>& out, std::vector<uint32_t>& ends, int max,
+                       size_t max_bytes, uint32_t& generation);
+bool offline_queue_advance(uint32_t generation, uint32_t next_offset, int count);
+int offline_queue_pending();
+OfflineQueueStats offline_queue_get_stats();
+void offline_queue_log_stats();
+
+#endif
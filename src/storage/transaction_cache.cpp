@@ -3,12 +3,28 @@
 #include <ArduinoJson.h>
 #include <vector>
 #include "../utils/logger.h"
-
-#define CACHE_FILE "/transactions.json"
-#define MAX_CACHED_TRANSACTIONS 100
+#include "../utils/clock.h"
+#include "../utils/helpers.h"
 
 bool cache_initialized = false;
 
+// The commit worker writes while the state machine reads; every file access
+// holds this lock so readers never see a half-rewritten cache file.
+SemaphoreHandle_t cache_mutex = NULL;
+
+struct CacheLock {
+  CacheLock() {
+    if (cache_mutex != NULL) {
+      xSemaphoreTakeRecursive(cache_mutex, portMAX_DELAY);
+    }
+  }
+  ~CacheLock() {
+    if (cache_mutex != NULL) {
+      xSemaphoreGiveRecursive(cache_mutex);
+    }
+  }
+};
+
 bool cache_init() {
   if (cache_initialized) {
     return true;
@@ -19,19 +35,21 @@ bool cache_init() {
     return false;
   }
   
+  cache_mutex = xSemaphoreCreateRecursiveMutex();
   cache_initialized = true;
   Logger::logInfo("Transaction Cache: Initialized");
   return true;
 }
 
 bool cache_add_transaction(Transaction t) {
+  CacheLock lock;
   if (!cache_initialized) {
     return false;
   }
   
   // Generate ID if not present
   if (t.id.length() == 0) {
-    t.id = "TXN_" + String(millis()) + "_" + String(random(1000, 9999));
+    t.id = "TXN_" + String(clock_millis()) + "_" + String(random(1000, 9999));
   }
   
   // Read existing transactions
@@ -108,6 +126,7 @@ bool cache_add_transaction(Transaction t) {
 }
 
 std::vector<Transaction> cache_get_today_transactions(String student_id) {
+  CacheLock lock;
   std::vector<Transaction> result;
   
   if (!cache_initialized || !SPIFFS.exists(CACHE_FILE)) {
@@ -122,7 +141,7 @@ std::vector<Transaction> cache_get_today_transactions(String student_id) {
   String content = file.readString();
   file.close();
   
-  unsigned long today_start = (millis() / 1000) - (24 * 3600); // Last 24 hours
+  unsigned long today_start = clock_window_start(24 * 3600); // Last 24 hours
   
   JsonDocument doc;
   if (deserializeJson(doc, content) == DeserializationError::Ok) {
@@ -152,6 +171,7 @@ std::vector<Transaction> cache_get_today_transactions(String student_id) {
 }
 
 std::vector<Transaction> cache_get_recent_transactions(int hours) {
+  CacheLock lock;
   std::vector<Transaction> result;
   
   if (!cache_initialized || !SPIFFS.exists(CACHE_FILE)) {
@@ -166,7 +186,7 @@ std::vector<Transaction> cache_get_recent_transactions(int hours) {
   String content = file.readString();
   file.close();
   
-  unsigned long time_threshold = (millis() / 1000) - (hours * 3600);
+  unsigned long time_threshold = clock_window_start(hours * 3600);
   
   JsonDocument doc;
   if (deserializeJson(doc, content) == DeserializationError::Ok) {
@@ -198,6 +218,7 @@ std::vector<Transaction> cache_get_recent_transactions(int hours) {
 }
 
 void cache_clear_old_entries(int days) {
+  CacheLock lock;
   if (!cache_initialized || !SPIFFS.exists(CACHE_FILE)) {
     return;
   }
@@ -210,7 +231,7 @@ void cache_clear_old_entries(int days) {
   String content = file.readString();
   file.close();
   
-  unsigned long time_threshold = (millis() / 1000) - (days * 24 * 3600);
+  unsigned long time_threshold = clock_window_start(days * 24 * 3600);
   std::vector<Transaction> transactions;
   
   JsonDocument doc;
@@ -261,8 +282,9 @@ void cache_clear_old_entries(int days) {
 }
 
 std::vector<Transaction> cache_get_all_today() {
+  CacheLock lock;
   std::vector<Transaction> result;
-  unsigned long today_start = (millis() / 1000) - (24 * 3600);
+  unsigned long today_start = clock_window_start(24 * 3600);
   
   if (!cache_initialized || !SPIFFS.exists(CACHE_FILE)) {
     return result;
@@ -305,9 +327,10 @@ std::vector<Transaction> cache_get_all_today() {
 }
 
 bool cache_student_served_today(String student_id) {
+  CacheLock lock;
   std::vector<Transaction> today_txns = cache_get_today_transactions(student_id);
   for (const Transaction& txn : today_txns) {
-    if (txn.status == "approved" || txn.status == "manual_approved" || txn.status == "override") {
+    if (Helpers::isServedStatus(txn.status)) {
       return true;
     }
   }
@@ -315,6 +338,7 @@ bool cache_student_served_today(String student_id) {
 }
 
 std::vector<Transaction> cache_get_unsynced() {
+  CacheLock lock;
   std::vector<Transaction> result;
   
   if (!cache_initialized || !SPIFFS.exists(CACHE_FILE)) {
@@ -358,6 +382,7 @@ std::vector<Transaction> cache_get_unsynced() {
 }
 
 bool cache_mark_synced(String transaction_id) {
+  CacheLock lock;
   if (!cache_initialized || !SPIFFS.exists(CACHE_FILE)) {
     return false;
   }
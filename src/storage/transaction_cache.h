@@ -5,6 +5,11 @@
 #include <vector>
 #include "../config/data_types.h"
 
+#define CACHE_FILE "/transactions.json"
+#ifndef MAX_CACHED_TRANSACTIONS
+#define MAX_CACHED_TRANSACTIONS 100  // Oldest entries are dropped past this
+#endif
+
 bool cache_init();
 bool cache_add_transaction(Transaction t);
 std::vector<Transaction> cache_get_today_transactions(String student_id);
@@ -2,50 +2,95 @@
 #include "../modules/oled_display.h"
 #include "../modules/keyboard_module.h"
 #include "../utils/logger.h"
+#include "../utils/clock.h"
 #include "../config/data_types.h"
 
+#define APPROVAL_REFRESH_MS 500
+
+// Pending approval request, polled from the state machine
+String approval_student_name = "";
+String approval_student_id = "";
+String approval_reason = "";
+unsigned long approval_start_time = 0;
+unsigned long approval_timeout_ms = 0;
+unsigned long approval_last_display_update = 0;
+bool approval_active = false;
+
+void manager_approval_begin(String student_name,
+                            String student_id,
+                            String reason,
+                            int timeout_sec) {
+  Logger::logInfo("Manager Approval: Waiting for decision");
+  
+  approval_student_name = student_name;
+  approval_student_id = student_id;
+  approval_reason = reason;
+  approval_start_time = clock_millis();
+  approval_timeout_ms = timeout_sec * 1000;
+  approval_last_display_update = clock_millis();
+  approval_active = true;
+  
+  display_manager_approval_screen(student_name, student_id, reason);
+}
+
+ApprovalDecision manager_approval_poll(int key) {
+  if (!approval_active) {
+    return PENDING;
+  }
+  
+  if (key == KEY_APPROVE) {
+    Logger::logInfo("Manager Approval: APPROVED");
+    log_manager_action(APPROVED, approval_student_id, approval_reason);
+    approval_active = false;
+    return APPROVED;
+  } else if (key == KEY_DENY) {
+    Logger::logInfo("Manager Approval: DENIED");
+    log_manager_action(DENIED, approval_student_id, approval_reason);
+    approval_active = false;
+    return DENIED;
+  } else if (key == KEY_OVERRIDE) {
+    Logger::logInfo("Manager Approval: OVERRIDE (forced)");
+    log_manager_action(OVERRIDE, approval_student_id, approval_reason);
+    approval_active = false;
+    return OVERRIDE;
+  }
+  
+  unsigned long elapsed = clock_millis() - approval_start_time;
+  if (elapsed >= approval_timeout_ms) {
+    Logger::logInfo("Manager Approval: Timeout - Auto DENY");
+    log_manager_action(DENIED, approval_student_id, "Timeout - Auto denied");
+    approval_active = false;
+    return DENIED;
+  }
+  
+  // Update display every 500ms to show timeout countdown
+  if (clock_millis() - approval_last_display_update > APPROVAL_REFRESH_MS) {
+    unsigned long remaining = (approval_timeout_ms - elapsed) / 1000;
+    display_manager_approval_screen(approval_student_name, approval_student_id,
+                                    approval_reason + " (" + String(remaining) + "s)");
+    approval_last_display_update = clock_millis();
+  }
+  
+  return PENDING;
+}
+
+unsigned long manager_approval_next_deadline() {
+  unsigned long timeout_at = approval_start_time + approval_timeout_ms;
+  unsigned long refresh_at = approval_last_display_update + APPROVAL_REFRESH_MS + 1;
+  return (long)(refresh_at - timeout_at) < 0 ? refresh_at : timeout_at;
+}
+
 ApprovalDecision wait_manager_approval(String student_name, 
                                        String student_id,
                                        String reason,
                                        int timeout_sec) {
-  Logger::logInfo("Manager Approval: Waiting for decision");
-  
-  display_manager_approval_screen(student_name, student_id, reason);
+  manager_approval_begin(student_name, student_id, reason, timeout_sec);
   
-  unsigned long start_time = millis();
-  unsigned long timeout_ms = timeout_sec * 1000;
-  unsigned long last_display_update = 0;
-  
-  while (millis() - start_time < timeout_ms) {
-    int key = keyboard_get_key();
-    
-    if (key == KEY_APPROVE) {
-      Logger::logInfo("Manager Approval: APPROVED");
-      log_manager_action(APPROVED, student_id, reason);
-      return APPROVED;
-    } else if (key == KEY_DENY) {
-      Logger::logInfo("Manager Approval: DENIED");
-      log_manager_action(DENIED, student_id, reason);
-      return DENIED;
-    } else if (key == KEY_OVERRIDE) {
-      Logger::logInfo("Manager Approval: OVERRIDE (forced)");
-      log_manager_action(OVERRIDE, student_id, reason);
-      return OVERRIDE;
-    }
-    
-    // Update display every 500ms to show timeout countdown
-    if (millis() - last_display_update > 500) {
-      unsigned long remaining = (timeout_ms - (millis() - start_time)) / 1000;
-      display_manager_approval_screen(student_name, student_id, reason + " (" + String(remaining) + "s)");
-      last_display_update = millis();
-    }
-    
+  ApprovalDecision decision = PENDING;
+  while ((decision = manager_approval_poll(keyboard_get_key())) == PENDING) {
     delay(50);
   }
-  
-  Logger::logInfo("Manager Approval: Timeout - Auto DENY");
-  log_manager_action(DENIED, student_id, "Timeout - Auto denied");
-  return DENIED;
+  return decision;
 }
 
 void log_manager_action(ApprovalDecision decision, String student_id, String reason) {
@@ -60,4 +105,3 @@ void log_manager_action(ApprovalDecision decision, String student_id, String rea
   Logger::logInfo("Manager Action: " + decision_str + " for " + student_id + " - " + reason);
   // TODO: Store in SPIFFS for audit trail
 }
-
@@ -5,6 +5,17 @@
 #include "../config/data_types.h"
 #include "../modules/keyboard_module.h"
 
+// Non-blocking: begin once, then poll with the latest key (-1 for none)
+// until the result is not PENDING
+void manager_approval_begin(String student_name,
+                            String student_id,
+                            String reason,
+                            int timeout_sec);
+ApprovalDecision manager_approval_poll(int key);
+// clock_millis() at which poll next has work without a key (countdown or timeout)
+unsigned long manager_approval_next_deadline();
+
+// Blocking wrapper around begin/poll
 ApprovalDecision wait_manager_approval(String student_name, 
                                        String student_id,
                                        String reason,
@@ -0,0 +1,37 @@
+#include "clock.h"
+#include <time.h>
+
+// Below this the system time has not been set (2020-09-13)
+#define CLOCK_MIN_EPOCH 1600000000
+
+ClockReadFn clock_source = NULL;
+
+void clock_set_source(ClockReadFn read_ms) {
+  clock_source = read_ms;
+}
+
+unsigned long clock_millis() {
+  return clock_source != NULL ? clock_source() : millis();
+}
+
+unsigned long clock_seconds() {
+  return clock_millis() / 1000;
+}
+
+unsigned long clock_window_start(unsigned long window_sec) {
+  unsigned long now = clock_seconds();
+  return now > window_sec ? now - window_sec : 0;
+}
+
+bool clock_to_wall(unsigned long clock_sec, unsigned long& wall_sec) {
+  if (clock_source != NULL) {
+    wall_sec = clock_sec;
+    return true;
+  }
+  time_t now = time(nullptr);
+  if (now < CLOCK_MIN_EPOCH) {
+    return false;
+  }
+  wall_sec = (unsigned long)now - (clock_seconds() - clock_sec);
+  return true;
+}
@@ -0,0 +1,28 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+// Time source for every timeout and time window in the firmware (state
+// timeouts, debounce, backoff, fraud and cache windows). Defaults to the
+// hardware clock; the host replay installs a virtual one. Latency
+// measurements (trace, task load, camera timings) stay on micros().
+
+typedef unsigned long (*ClockReadFn)();
+
+// Pass NULL to go back to millis()
+void clock_set_source(ClockReadFn read_ms);
+
+unsigned long clock_millis();
+unsigned long clock_seconds();
+// Start of a window ending now, in clock_seconds(). Floors at 0 so windows
+// longer than the uptime cover everything instead of wrapping.
+unsigned long clock_window_start(unsigned long window_sec);
+
+// clock_seconds() counts from boot. Once SNTP has set the system time, a
+// clock_seconds() timestamp converts to Unix seconds; before that this
+// returns false and time-of-day or cross-reboot uses must wait. An
+// installed source (host replay, bench) already reads wall time.
+bool clock_to_wall(unsigned long clock_sec, unsigned long& wall_sec);
+
+#endif
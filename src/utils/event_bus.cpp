@@ -0,0 +1,82 @@
+#include "event_bus.h"
+
+// Fixed ring shared by all producers; a spinlock keeps it safe across both
+// cores. Nothing here allocates.
+Event event_ring[EVENT_BUS_CAPACITY];
+size_t event_head = 0;
+size_t event_count = 0;
+portMUX_TYPE event_mux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t event_consumer = NULL;
+EventBusStats event_stats = {0, 0, 0, 0};
+
+static bool ring_push(EventType type, int32_t value, const char* data, uint32_t now) {
+  if (event_count >= EVENT_BUS_CAPACITY) {
+    event_stats.dropped++;
+    return false;
+  }
+
+  Event& slot = event_ring[(event_head + event_count) % EVENT_BUS_CAPACITY];
+  slot.type = type;
+  slot.value = value;
+  slot.time_ms = now;
+  slot.data[0] = '\0';
+  if (data != NULL) {
+    size_t i = 0;
+    for (; i < EVENT_DATA_SIZE - 1 && data[i] != '\0'; i++) {
+      slot.data[i] = data[i];
+    }
+    slot.data[i] = '\0';
+  }
+
+  event_count++;
+  event_stats.posted++;
+  if (event_count > event_stats.max_depth) {
+    event_stats.max_depth = event_count;
+  }
+  return true;
+}
+
+bool event_post(EventType type, int32_t value, const char* data) {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&event_mux);
+  bool queued = ring_push(type, value, data, now);
+  portEXIT_CRITICAL(&event_mux);
+
+  if (queued && event_consumer != NULL) {
+    xTaskNotifyGive(event_consumer);
+  }
+  return queued;
+}
+
+void event_bus_set_consumer(TaskHandle_t consumer) {
+  event_consumer = consumer;
+}
+
+bool event_poll(Event& event) {
+  bool found = false;
+  portENTER_CRITICAL(&event_mux);
+  if (event_count > 0) {
+    event = event_ring[event_head];
+    event_head = (event_head + 1) % EVENT_BUS_CAPACITY;
+    event_count--;
+    found = true;
+  }
+  portEXIT_CRITICAL(&event_mux);
+  return found;
+}
+
+void event_bus_wait(unsigned long max_ms) {
+  // A post between the caller's last poll and here leaves a pending
+  // notification, so this returns immediately instead of missing it
+  TickType_t ticks = max_ms == EVENT_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(max_ms);
+  ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+EventBusStats event_bus_get_stats() {
+  EventBusStats stats;
+  portENTER_CRITICAL(&event_mux);
+  stats = event_stats;
+  stats.depth = event_count;
+  portEXIT_CRITICAL(&event_mux);
+  return stats;
+}
@@ -0,0 +1,48 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+
+#define EVENT_BUS_CAPACITY 16
+#define EVENT_DATA_SIZE 24
+
+enum EventType {
+  EVENT_NONE,
+  EVENT_CARD,           // data: RFID UID
+  EVENT_KEY,            // value: key code
+  EVENT_MOTION,         // PIR high for the debounce time
+  EVENT_WIFI,           // value: 1 connected, 0 lost
+  EVENT_CAMERA_RESULT,  // Camera task finished a capture request
+  EVENT_VERIFY_RESULT,  // Network task finished a face-verify request
+  EVENT_COMMITTED       // Storage task freed a commit pipeline slot
+};
+
+// Plain data so it can be copied inside a critical section
+struct Event {
+  EventType type;
+  int32_t value;
+  uint32_t time_ms;
+  char data[EVENT_DATA_SIZE];
+};
+
+struct EventBusStats {
+  unsigned long posted;
+  unsigned long dropped;
+  size_t depth;
+  size_t max_depth;
+};
+
+// Producers: any task. Not for ISRs: the PIR edge interrupt only wakes the
+// input task, which debounces the pin before posting EVENT_MOTION.
+bool event_post(EventType type, int32_t value = 0, const char* data = NULL);
+
+// Consumer: the single task registered with event_bus_set_consumer
+void event_bus_set_consumer(TaskHandle_t consumer);
+bool event_poll(Event& event);
+// Blocks until a post or max_ms; EVENT_WAIT_FOREVER has no timeout
+#define EVENT_WAIT_FOREVER 0xFFFFFFFFUL
+void event_bus_wait(unsigned long max_ms);
+
+EventBusStats event_bus_get_stats();
+
+#endif
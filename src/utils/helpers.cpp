@@ -1,5 +1,6 @@
 #include "helpers.h"
 #include <Arduino.h>
+#include "clock.h"
 
 String Helpers::getStateName(SystemState state) {
   switch(state) {
@@ -16,7 +17,7 @@ String Helpers::getStateName(SystemState state) {
 }
 
 unsigned long Helpers::getCurrentTimestamp() {
-  return millis() / 1000; // Simplified - should use NTP in production
+  return clock_seconds(); // Simplified - should use NTP in production
 }
 
 String Helpers::base64Encode(uint8_t* data, size_t length) {
@@ -64,3 +65,15 @@ String Helpers::base64Encode(uint8_t* data, size_t length) {
   return encoded;
 }
 
+uint64_t Helpers::hashString(const String& value) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < value.length(); i++) {
+    hash ^= (uint8_t)value[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash != 0 ? hash : 1; // 0 marks an empty table slot
+}
+
+bool Helpers::isServedStatus(const String& status) {
+  return status == "approved" || status == "manual_approved" || status == "override";
+}
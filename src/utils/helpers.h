@@ -9,6 +9,9 @@ public:
   static String getStateName(SystemState state);
   static unsigned long getCurrentTimestamp();
   static String base64Encode(uint8_t* data, size_t length);
+  static uint64_t hashString(const String& value); // 64-bit FNV-1a, never 0
+  // A meal was handed out: approved, manual_approved or override
+  static bool isServedStatus(const String& status);
 };
 
 #endif
@@ -0,0 +1,329 @@
+#include "image_utils.h"
+#include <math.h>
+
+bool image_rgb565_to_luma(const uint8_t* rgb565, uint16_t width, uint16_t height, LumaImage& out) {
+  if (rgb565 == nullptr || width == 0 || height == 0 ||
+      width > LUMA_MAX_WIDTH || height > LUMA_MAX_HEIGHT) {
+    return false;
+  }
+
+  out.width = width;
+  out.height = height;
+
+  size_t count = (size_t)width * height;
+  for (size_t i = 0; i < count; i++) {
+    uint16_t px = ((uint16_t)rgb565[i * 2] << 8) | rgb565[i * 2 + 1];
+    uint16_t r = (px >> 8) & 0xF8;
+    uint16_t g = (px >> 3) & 0xFC;
+    uint16_t b = (px << 3) & 0xF8;
+    // ITU-R BT.601 weights in 8-bit fixed point (77 + 150 + 29 = 256)
+    out.pixels[i] = (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+  }
+
+  return true;
+}
+
+uint8_t image_mean_brightness(const LumaImage& img) {
+  size_t count = (size_t)img.width * img.height;
+  if (count == 0) {
+    return 0;
+  }
+
+  uint32_t sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    sum += img.pixels[i];
+  }
+  return (uint8_t)(sum / count);
+}
+
+float image_laplacian_variance(const LumaImage& img) {
+  if (img.width < 3 || img.height < 3) {
+    return 0.0;
+  }
+
+  int64_t sum = 0;
+  int64_t sum_sq = 0;
+  uint32_t count = 0;
+  for (int y = 1; y < img.height - 1; y++) {
+    const uint8_t* row = img.pixels + (size_t)y * img.width;
+    for (int x = 1; x < img.width - 1; x++) {
+      int32_t lap = 4 * row[x] - row[x - 1] - row[x + 1] - row[x - img.width] - row[x + img.width];
+      sum += lap;
+      sum_sq += lap * lap;
+      count++;
+    }
+  }
+
+  float mean = (float)sum / count;
+  return (float)sum_sq / count - mean * mean;
+}
+
+// Integral image with a zero first row/column: (w + 1) x (h + 1)
+static uint32_t integral[(LUMA_MAX_WIDTH + 1) * (LUMA_MAX_HEIGHT + 1)];
+static uint32_t integral_sq[(LUMA_MAX_WIDTH + 1) * (LUMA_MAX_HEIGHT + 1)];
+
+static void build_integral(const LumaImage& img) {
+  int stride = img.width + 1;
+  for (int x = 0; x <= img.width; x++) {
+    integral[x] = 0;
+    integral_sq[x] = 0;
+  }
+
+  for (int y = 1; y <= img.height; y++) {
+    uint32_t row_sum = 0;
+    uint32_t row_sq = 0;
+    integral[y * stride] = 0;
+    integral_sq[y * stride] = 0;
+    for (int x = 1; x <= img.width; x++) {
+      uint32_t v = img.pixels[(y - 1) * img.width + (x - 1)];
+      row_sum += v;
+      row_sq += v * v;
+      integral[y * stride + x] = integral[(y - 1) * stride + x] + row_sum;
+      integral_sq[y * stride + x] = integral_sq[(y - 1) * stride + x] + row_sq;
+    }
+  }
+}
+
+// Mean luma of the rectangle [x0, x1) x [y0, y1)
+static float rect_mean(int stride, int x0, int y0, int x1, int y1) {
+  uint32_t sum = integral[y1 * stride + x1] - integral[y0 * stride + x1]
+               - integral[y1 * stride + x0] + integral[y0 * stride + x0];
+  return (float)sum / ((x1 - x0) * (y1 - y0));
+}
+
+static float window_score(int stride, int x, int y, int s) {
+  uint32_t area = s * s;
+  uint32_t sum = integral[(y + s) * stride + x + s] - integral[y * stride + x + s]
+               - integral[(y + s) * stride + x] + integral[y * stride + x];
+  uint32_t sq = integral_sq[(y + s) * stride + x + s] - integral_sq[y * stride + x + s]
+              - integral_sq[(y + s) * stride + x] + integral_sq[y * stride + x];
+  float mean = (float)sum / area;
+  float variance = (float)sq / area - mean * mean;
+  if (variance < 64.0) {
+    return 0.0; // Flat wall or lens cap, std dev < 8 levels
+  }
+  float std_dev = sqrtf(variance);
+
+  // Band layout as fractions of the window (in 1/20ths)
+  int eye_top = y + s * 5 / 20;
+  int eye_bottom = y + s * 9 / 20;
+  int cheek_top = y + s * 10 / 20;
+  int cheek_bottom = y + s * 14 / 20;
+  int left = x + s * 3 / 20;
+  int right = x + s * 17 / 20;
+  int left_eye_end = x + s * 8 / 20;
+  int right_eye_start = x + s * 12 / 20;
+
+  if (eye_bottom <= eye_top || cheek_bottom <= cheek_top ||
+      left_eye_end <= left || right <= right_eye_start || right_eye_start <= left_eye_end) {
+    return 0.0;
+  }
+
+  float eyes = rect_mean(stride, left, eye_top, right, eye_bottom);
+  float cheeks = rect_mean(stride, left, cheek_top, right, cheek_bottom);
+  float left_eye = rect_mean(stride, left, eye_top, left_eye_end, eye_bottom);
+  float right_eye = rect_mean(stride, right_eye_start, eye_top, right, eye_bottom);
+  float bridge = rect_mean(stride, left_eye_end, eye_top, right_eye_start, eye_bottom);
+
+  float eye_contrast = cheeks - eyes;
+  float bridge_contrast = bridge - (left_eye + right_eye) / 2;
+  float asymmetry = fabsf(left_eye - right_eye);
+
+  return (eye_contrast + bridge_contrast - asymmetry / 2) / std_dev;
+}
+
+bool image_find_face(const LumaImage& img, float min_score, FaceBox& box) {
+  box.x = 0;
+  box.y = 0;
+  box.size = 0;
+  box.score = 0.0;
+
+  int min_side = img.width < img.height ? img.width : img.height;
+  if (min_side < 16) {
+    return false;
+  }
+
+  build_integral(img);
+  int stride = img.width + 1;
+
+  // Faces at the counter fill roughly 30-100% of the frame height
+  for (int s = min_side * 3 / 10; s <= min_side; s += (s / 5 > 2 ? s / 5 : 2)) {
+    int step = s / 8 > 1 ? s / 8 : 1;
+    for (int y = 0; y + s <= img.height; y += step) {
+      for (int x = 0; x + s <= img.width; x += step) {
+        float score = window_score(stride, x, y, s);
+        if (score > box.score) {
+          box.x = x;
+          box.y = y;
+          box.size = s;
+          box.score = score;
+        }
+      }
+    }
+  }
+
+  return box.size > 0 && box.score >= min_score;
+}
+
+bool image_compute_descriptor(const LumaImage& img, const FaceBox* face, FaceDescriptor& out) {
+  uint16_t side = img.width < img.height ? img.width : img.height;
+  uint16_t x0 = (img.width - side) / 2;
+  uint16_t y0 = (img.height - side) / 2;
+  if (face != nullptr) {
+    if (face->size < FACE_DESCRIPTOR_GRID || face->x + face->size > img.width ||
+        face->y + face->size > img.height) {
+      return false;
+    }
+    side = face->size;
+    x0 = face->x;
+    y0 = face->y;
+  }
+
+  uint16_t cell = side / FACE_DESCRIPTOR_GRID;
+  if (cell == 0) {
+    return false;
+  }
+
+  // Center the grid inside the region when side is not a multiple of the grid
+  x0 += (side - cell * FACE_DESCRIPTOR_GRID) / 2;
+  y0 += (side - cell * FACE_DESCRIPTOR_GRID) / 2;
+
+  // Block averages over the region
+  int32_t blocks[FACE_DESCRIPTOR_SIZE];
+  int32_t total = 0;
+  for (int gy = 0; gy < FACE_DESCRIPTOR_GRID; gy++) {
+    for (int gx = 0; gx < FACE_DESCRIPTOR_GRID; gx++) {
+      int32_t sum = 0;
+      for (int y = 0; y < cell; y++) {
+        const uint8_t* row = img.pixels + (size_t)(y0 + gy * cell + y) * img.width + x0 + gx * cell;
+        for (int x = 0; x < cell; x++) {
+          sum += row[x];
+        }
+      }
+      int32_t avg = sum / (cell * cell);
+      blocks[gy * FACE_DESCRIPTOR_GRID + gx] = avg;
+      total += avg;
+    }
+  }
+
+  // Zero-mean so that overall brightness does not affect matching
+  int32_t mean = total / FACE_DESCRIPTOR_SIZE;
+  int32_t max_abs = 0;
+  for (int i = 0; i < FACE_DESCRIPTOR_SIZE; i++) {
+    blocks[i] -= mean;
+    int32_t a = blocks[i] < 0 ? -blocks[i] : blocks[i];
+    if (a > max_abs) {
+      max_abs = a;
+    }
+  }
+
+  if (max_abs == 0) {
+    return false; // Flat frame, nothing to match on
+  }
+
+  for (int i = 0; i < FACE_DESCRIPTOR_SIZE; i++) {
+    out.values[i] = (int8_t)((blocks[i] * 127) / max_abs);
+  }
+
+  return true;
+}
+
+float image_descriptor_similarity(const FaceDescriptor& a, const FaceDescriptor& b) {
+  int32_t dot = 0;
+  int32_t norm_a = 0;
+  int32_t norm_b = 0;
+  for (int i = 0; i < FACE_DESCRIPTOR_SIZE; i++) {
+    dot += (int32_t)a.values[i] * b.values[i];
+    norm_a += (int32_t)a.values[i] * a.values[i];
+    norm_b += (int32_t)b.values[i] * b.values[i];
+  }
+
+  if (norm_a == 0 || norm_b == 0) {
+    return 0.0;
+  }
+
+  float similarity = (float)dot / sqrtf((float)norm_a * (float)norm_b);
+  return similarity < 0.0 ? 0.0 : similarity;
+}
+
+void image_blend_descriptor(FaceDescriptor& stored, const FaceDescriptor& sample, uint16_t samples) {
+  // Cap the weight so the template keeps adapting (haircut, glasses, lighting)
+  int32_t weight = samples < 7 ? samples : 7;
+  for (int i = 0; i < FACE_DESCRIPTOR_SIZE; i++) {
+    stored.values[i] = (int8_t)(((int32_t)stored.values[i] * weight + sample.values[i]) / (weight + 1));
+  }
+}
+
+bool image_face_crop_rect(const FaceBox& face, uint16_t luma_width, uint16_t luma_height,
+                          uint16_t frame_width, uint16_t frame_height, float padding, CropRect& out) {
+  if (face.size == 0 || luma_width == 0 || luma_height == 0) {
+    return false;
+  }
+
+  // Work in frame pixels; luma is a uniform downscale of the frame
+  float scale_x = (float)frame_width / luma_width;
+  float scale_y = (float)frame_height / luma_height;
+  float center_x = (face.x + face.size / 2.0) * scale_x;
+  float center_y = (face.y + face.size / 2.0) * scale_y;
+  float side = face.size * (scale_x < scale_y ? scale_x : scale_y) * (1.0 + 2.0 * padding);
+
+  uint16_t max_side = frame_width < frame_height ? frame_width : frame_height;
+  if (side > max_side) {
+    side = max_side;
+  }
+
+  // Slide the square back inside the frame instead of shrinking it
+  float left = center_x - side / 2;
+  float top = center_y - side / 2;
+  if (left < 0) left = 0;
+  if (top < 0) top = 0;
+  if (left + side > frame_width) left = frame_width - side;
+  if (top + side > frame_height) top = frame_height - side;
+
+  out.x = (uint16_t)left;
+  out.y = (uint16_t)top;
+  out.width = (uint16_t)side;
+  out.height = (uint16_t)side;
+  return out.width > 0;
+}
+
+bool image_crop_scale_rgb888(const uint8_t* src, uint16_t src_width, uint16_t src_height,
+                             const CropRect& rect, uint8_t* dst, uint16_t dst_width, uint16_t dst_height) {
+  if (src == nullptr || dst == nullptr || dst_width == 0 || dst_height == 0 ||
+      rect.width == 0 || rect.height == 0 ||
+      rect.x + rect.width > src_width || rect.y + rect.height > src_height) {
+    return false;
+  }
+
+  // Each destination pixel averages the source block it covers (nearest pixel when upscaling)
+  for (uint16_t dy = 0; dy < dst_height; dy++) {
+    uint32_t sy0 = rect.y + (uint32_t)dy * rect.height / dst_height;
+    uint32_t sy1 = rect.y + (uint32_t)(dy + 1) * rect.height / dst_height;
+    if (sy1 <= sy0) sy1 = sy0 + 1;
+
+    for (uint16_t dx = 0; dx < dst_width; dx++) {
+      uint32_t sx0 = rect.x + (uint32_t)dx * rect.width / dst_width;
+      uint32_t sx1 = rect.x + (uint32_t)(dx + 1) * rect.width / dst_width;
+      if (sx1 <= sx0) sx1 = sx0 + 1;
+
+      uint32_t sum[3] = {0, 0, 0};
+      for (uint32_t sy = sy0; sy < sy1; sy++) {
+        const uint8_t* px = src + ((size_t)sy * src_width + sx0) * 3;
+        for (uint32_t sx = sx0; sx < sx1; sx++) {
+          sum[0] += px[0];
+          sum[1] += px[1];
+          sum[2] += px[2];
+          px += 3;
+        }
+      }
+
+      uint32_t count = (sy1 - sy0) * (sx1 - sx0);
+      uint8_t* out = dst + ((size_t)dy * dst_width + dx) * 3;
+      out[0] = (uint8_t)(sum[0] / count);
+      out[1] = (uint8_t)(sum[1] / count);
+      out[2] = (uint8_t)(sum[2] / count);
+    }
+  }
+
+  return true;
+}
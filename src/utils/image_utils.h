@@ -0,0 +1,74 @@
+#ifndef IMAGE_UTILS_H
+#define IMAGE_UTILS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Downscaled luma image (JPEG decoded at 1/8 scale: VGA -> 80x60, SVGA -> 100x75)
+#define LUMA_MAX_WIDTH 100
+#define LUMA_MAX_HEIGHT 75
+
+// Face descriptor: 16x16 grid of zero-mean, normalized block averages
+#define FACE_DESCRIPTOR_GRID 16
+#define FACE_DESCRIPTOR_SIZE (FACE_DESCRIPTOR_GRID * FACE_DESCRIPTOR_GRID)
+
+struct LumaImage {
+  uint16_t width;
+  uint16_t height;
+  uint8_t pixels[LUMA_MAX_WIDTH * LUMA_MAX_HEIGHT];
+};
+
+struct FaceDescriptor {
+  int8_t values[FACE_DESCRIPTOR_SIZE];
+};
+
+// Square face candidate in luma image coordinates
+struct FaceBox {
+  uint16_t x;
+  uint16_t y;
+  uint16_t size;
+  float score; // Haar-like contrast score in units of window standard deviation
+};
+
+// Pixel rectangle in full-resolution frame coordinates
+struct CropRect {
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+};
+
+// Convert big-endian RGB565 (as produced by jpg2rgb565) to 8-bit luma
+bool image_rgb565_to_luma(const uint8_t* rgb565, uint16_t width, uint16_t height, LumaImage& out);
+
+// Average luma over the whole image
+uint8_t image_mean_brightness(const LumaImage& img);
+
+// Variance of the 4-neighbour Laplacian; low values mean a blurred frame
+float image_laplacian_variance(const LumaImage& img);
+
+// Coarse face finder (eye band darker than cheeks and nose bridge, left/right symmetry).
+// Returns the best scoring window; box.score is valid even when nothing passes min_score.
+bool image_find_face(const LumaImage& img, float min_score, FaceBox& box);
+
+// Build a descriptor from the face box, or the centered square region when
+// face is null. False when the box is too small for the grid: a centered
+// square would not match templates taken over face boxes.
+bool image_compute_descriptor(const LumaImage& img, const FaceBox* face, FaceDescriptor& out);
+
+// Map a luma-space face box to a padded, clamped square in frame coordinates.
+// padding is the fraction of the box size added on each side.
+bool image_face_crop_rect(const FaceBox& face, uint16_t luma_width, uint16_t luma_height,
+                          uint16_t frame_width, uint16_t frame_height, float padding, CropRect& out);
+
+// Crop a 3-byte-per-pixel image and resample it to dst_width x dst_height by area averaging
+bool image_crop_scale_rgb888(const uint8_t* src, uint16_t src_width, uint16_t src_height,
+                             const CropRect& rect, uint8_t* dst, uint16_t dst_width, uint16_t dst_height);
+
+// Normalized correlation of two descriptors, clamped to [0, 1]
+float image_descriptor_similarity(const FaceDescriptor& a, const FaceDescriptor& b);
+
+// Running average used when refreshing a stored template with a new sample
+void image_blend_descriptor(FaceDescriptor& stored, const FaceDescriptor& sample, uint16_t samples);
+
+#endif
@@ -5,7 +5,7 @@
 
 #if DEBUG
   #define LOG(msg) Serial.println(msg)
-  #define LOGF(fmt, ...) Serial.printf(fmt, __VA_ARGS__)
+  #define LOGF(fmt, ...) Serial.printf(fmt "\n", __VA_ARGS__)
 #else
   #define LOG(msg)
   #define LOGF(fmt, ...)
@@ -34,6 +34,10 @@ void Logger::logStateTransition(String from, String to) {
   LOGF("[STATE] %s -> %s", from.c_str(), to.c_str());
 }
 
+void Logger::logStateTransition(String from, String to, unsigned long dwell_ms) {
+  LOGF("[STATE] %s -> %s (%lu ms in %s)", from.c_str(), to.c_str(), dwell_ms, from.c_str());
+}
+
 void Logger::logError(String error) {
   LOGF("[ERROR] %s", error.c_str());
 }
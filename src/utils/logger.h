@@ -10,6 +10,7 @@ public:
   static void log(String message);
   static void logf(const char* format, ...);
   static void logStateTransition(String from, String to);
+  static void logStateTransition(String from, String to, unsigned long dwell_ms);
   static void logError(String error);
   static void logInfo(String info);
 };
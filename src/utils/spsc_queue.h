@@ -0,0 +1,76 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+
+// Bounded lock-free queue for exactly one producer task and one consumer task.
+// Indices run freely and are reduced modulo N on access; the producer only
+// writes tail, the consumer only writes head. N should be a power of two.
+template <typename T, size_t N>
+class SpscQueue {
+public:
+  SpscQueue() : head(0), tail(0), high_water(0), dropped(0) {}
+
+  // Producer side. Returns false (and counts a drop) when full.
+  bool push(const T& item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    if (t - h >= N) {
+      dropped++;
+      return false;
+    }
+
+    slots[t % N] = item;
+    tail.store(t + 1, std::memory_order_release);
+
+    if (t + 1 - h > high_water) {
+      high_water = t + 1 - h;
+    }
+    return true;
+  }
+
+  // Consumer side. The slot is reset so large members are released early.
+  bool pop(T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    if (h == t) {
+      return false;
+    }
+
+    item = slots[h % N];
+    slots[h % N] = T();
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate from any task, exact from the producer or consumer
+  size_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  size_t capacity() const {
+    return N;
+  }
+
+  size_t max_depth() const {
+    return high_water;
+  }
+
+  unsigned long drops() const {
+    return dropped;
+  }
+
+private:
+  T slots[N];
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+  size_t high_water;      // Producer-owned
+  unsigned long dropped;  // Producer-owned
+};
+
+#endif
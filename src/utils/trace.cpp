@@ -0,0 +1,184 @@
+#include "trace.h"
+#include <ArduinoJson.h>
+#include "logger.h"
+
+const char* TRACE_STAGE_NAMES[TRACE_STAGE_COUNT] = {
+  "rfid_read",
+  "capture",
+  "encode",
+  "local_match",
+  "verify_rtt",
+  "fraud",
+  "cache_write",
+  "log_upload",
+  "serve"
+};
+
+// Stages are recorded from several tasks; a spinlock keeps each update short
+TraceRecord trace_ring[TRACE_RING_SIZE];
+size_t trace_next = 0;
+size_t trace_count = 0;
+uint32_t trace_histograms[TRACE_STAGE_COUNT][TRACE_BUCKETS];
+uint32_t trace_totals[TRACE_STAGE_COUNT];
+uint32_t trace_max[TRACE_STAGE_COUNT];
+portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static int bucket_index(uint32_t value) {
+  if (value < TRACE_SUB_BUCKETS) {
+    return value;
+  }
+  int msb = 31 - __builtin_clz(value);
+  int shift = msb - TRACE_SUB_BUCKET_BITS;
+  int sub = (value >> shift) & (TRACE_SUB_BUCKETS - 1);
+  return (shift + 1) * TRACE_SUB_BUCKETS + sub;
+}
+
+// Upper edge of a bucket, reported so percentiles never under-state latency
+static uint32_t bucket_upper(int index) {
+  if (index < TRACE_SUB_BUCKETS) {
+    return index;
+  }
+  int shift = index / TRACE_SUB_BUCKETS - 1;
+  uint64_t sub = index % TRACE_SUB_BUCKETS;
+  uint64_t upper = (((uint64_t)TRACE_SUB_BUCKETS + sub + 1) << shift) - 1;
+  return upper > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)upper;
+}
+
+uint32_t trace_begin() {
+  return micros();
+}
+
+void trace_end(TraceStage stage, uint32_t start_us) {
+  trace_record(stage, start_us, micros() - start_us);
+}
+
+void trace_record(TraceStage stage, uint32_t start_us, uint32_t duration_us) {
+  if (stage >= TRACE_STAGE_COUNT) {
+    return;
+  }
+
+  portENTER_CRITICAL(&trace_mux);
+  TraceRecord& record = trace_ring[trace_next];
+  record.start_us = start_us;
+  record.duration_us = duration_us;
+  record.stage = stage;
+  trace_next = (trace_next + 1) % TRACE_RING_SIZE;
+  if (trace_count < TRACE_RING_SIZE) {
+    trace_count++;
+  }
+
+  trace_histograms[stage][bucket_index(duration_us)]++;
+  trace_totals[stage]++;
+  if (duration_us > trace_max[stage]) {
+    trace_max[stage] = duration_us;
+  }
+  portEXIT_CRITICAL(&trace_mux);
+}
+
+const char* trace_stage_name(TraceStage stage) {
+  return stage < TRACE_STAGE_COUNT ? TRACE_STAGE_NAMES[stage] : "unknown";
+}
+
+TraceSummary trace_get_summary(TraceStage stage) {
+  TraceSummary summary = {0, 0, 0, 0, 0};
+  if (stage >= TRACE_STAGE_COUNT) {
+    return summary;
+  }
+
+  uint32_t buckets[TRACE_BUCKETS];
+  portENTER_CRITICAL(&trace_mux);
+  memcpy(buckets, trace_histograms[stage], sizeof(buckets));
+  summary.count = trace_totals[stage];
+  summary.max_us = trace_max[stage];
+  portEXIT_CRITICAL(&trace_mux);
+
+  if (summary.count == 0) {
+    return summary;
+  }
+
+  // Ranks are 1-based: p50 of 2 samples is the first one
+  uint32_t rank50 = (summary.count * 50 + 99) / 100;
+  uint32_t rank95 = (summary.count * 95 + 99) / 100;
+  uint32_t rank99 = (summary.count * 99 + 99) / 100;
+  uint32_t seen = 0;
+  for (int i = 0; i < TRACE_BUCKETS && seen < rank99; i++) {
+    if (buckets[i] == 0) {
+      continue;
+    }
+    uint32_t upper = min(bucket_upper(i), summary.max_us);
+    if (seen < rank50 && seen + buckets[i] >= rank50) summary.p50_us = upper;
+    if (seen < rank95 && seen + buckets[i] >= rank95) summary.p95_us = upper;
+    if (seen + buckets[i] >= rank99) summary.p99_us = upper;
+    seen += buckets[i];
+  }
+  return summary;
+}
+
+int trace_get_recent(TraceRecord* out, int max) {
+  portENTER_CRITICAL(&trace_mux);
+  int count = min((int)trace_count, max);
+  size_t first = (trace_next + TRACE_RING_SIZE - count) % TRACE_RING_SIZE;
+  for (int i = 0; i < count; i++) {
+    out[i] = trace_ring[(first + i) % TRACE_RING_SIZE];
+  }
+  portEXIT_CRITICAL(&trace_mux);
+  return count;
+}
+
+void trace_reset() {
+  portENTER_CRITICAL(&trace_mux);
+  memset(trace_histograms, 0, sizeof(trace_histograms));
+  memset(trace_totals, 0, sizeof(trace_totals));
+  memset(trace_max, 0, sizeof(trace_max));
+  trace_next = 0;
+  trace_count = 0;
+  portEXIT_CRITICAL(&trace_mux);
+}
+
+void trace_log_summary() {
+  for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+    TraceSummary s = trace_get_summary((TraceStage)i);
+    if (s.count == 0) {
+      continue;
+    }
+    Logger::logf("[INFO] Trace %-11s n=%-5u p50 %7.1fms  p95 %7.1fms  p99 %7.1fms  max %7.1fms",
+                 TRACE_STAGE_NAMES[i], s.count,
+                 s.p50_us / 1000.0, s.p95_us / 1000.0, s.p99_us / 1000.0, s.max_us / 1000.0);
+  }
+}
+
+String trace_summary_json() {
+  JsonDocument doc;
+  JsonObject stages = doc["stages"].to<JsonObject>();
+  for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+    TraceSummary s = trace_get_summary((TraceStage)i);
+    JsonObject obj = stages[TRACE_STAGE_NAMES[i]].to<JsonObject>();
+    obj["count"] = s.count;
+    obj["p50_us"] = s.p50_us;
+    obj["p95_us"] = s.p95_us;
+    obj["p99_us"] = s.p99_us;
+    obj["max_us"] = s.max_us;
+  }
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+String trace_recent_json() {
+  TraceRecord records[TRACE_RING_SIZE];
+  int count = trace_get_recent(records, TRACE_RING_SIZE);
+
+  JsonDocument doc;
+  JsonArray arr = doc["records"].to<JsonArray>();
+  for (int i = 0; i < count; i++) {
+    JsonObject obj = arr.add<JsonObject>();
+    obj["stage"] = trace_stage_name((TraceStage)records[i].stage);
+    obj["start_us"] = records[i].start_us;
+    obj["duration_us"] = records[i].duration_us;
+  }
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+// Serve pipeline stages, in the order a transaction passes through them
+enum TraceStage {
+  TRACE_RFID_READ,     // Presence check + UID read
+  TRACE_CAPTURE,       // Frame grab, quality gate, descriptor, crop
+  TRACE_ENCODE,        // JPEG -> base64
+  TRACE_LOCAL_MATCH,   // Template match on device
+  TRACE_VERIFY_RTT,    // Face-verify request round trip
+  TRACE_FRAUD,         // Fraud rules incl. recent transaction lookup
+  TRACE_CACHE_WRITE,   // Transaction cache append (storage task)
+  TRACE_LOG_UPLOAD,    // Transaction log request (storage task)
+  TRACE_SERVE,         // Card accepted -> transaction queued, incl. approval wait
+  TRACE_STAGE_COUNT
+};
+
+#define TRACE_RING_SIZE 128
+
+// Log-linear buckets (HDR style): 8 sub-buckets per power of two keeps the
+// relative error of any percentile under 12.5% from 1 us up to ~71 minutes
+#define TRACE_SUB_BUCKET_BITS 3
+#define TRACE_SUB_BUCKETS (1 << TRACE_SUB_BUCKET_BITS)
+#define TRACE_BUCKETS ((32 - TRACE_SUB_BUCKET_BITS + 1) * TRACE_SUB_BUCKETS)
+
+struct TraceRecord {
+  uint32_t start_us;
+  uint32_t duration_us;
+  uint8_t stage;
+};
+
+struct TraceSummary {
+  uint32_t count;
+  uint32_t p50_us;
+  uint32_t p95_us;
+  uint32_t p99_us;
+  uint32_t max_us;
+};
+
+uint32_t trace_begin();
+void trace_end(TraceStage stage, uint32_t start_us);
+void trace_record(TraceStage stage, uint32_t start_us, uint32_t duration_us);
+
+const char* trace_stage_name(TraceStage stage);
+TraceSummary trace_get_summary(TraceStage stage);
+int trace_get_recent(TraceRecord* out, int max); // Oldest first
+void trace_reset();
+
+void trace_log_summary();
+String trace_summary_json();
+String trace_recent_json();
+
+#endif
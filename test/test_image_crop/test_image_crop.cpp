@@ -0,0 +1,175 @@
+// Face crop on recorded frames: detector box -> padded crop rectangle ->
+// RGB888 crop and resample, the path esp_cam_crop_to_face() runs before the
+// upload. Frames are QVGA PGMs in test/frames; the face square drawn in each
+// is listed with the test. Run from the project root:
+//   pio test -e native_test
+
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "utils/image_utils.h"
+#include "modules/esp_cam_config.h"
+
+#define FRAMES_DIR "test/frames/"
+
+struct Frame {
+  uint16_t width;
+  uint16_t height;
+  std::vector<uint8_t> pixels;
+};
+
+static bool load_pgm(const char* name, Frame& out) {
+  char path[128];
+  snprintf(path, sizeof(path), FRAMES_DIR "%s", name);
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    return false;
+  }
+  int width = 0;
+  int height = 0;
+  int max_value = 0;
+  bool ok = fscanf(f, "P5 %d %d %d", &width, &height, &max_value) == 3 && max_value == 255 &&
+            fgetc(f) != EOF;
+  if (ok) {
+    out.width = width;
+    out.height = height;
+    out.pixels.resize((size_t)width * height);
+    ok = fread(out.pixels.data(), 1, out.pixels.size(), f) == out.pixels.size();
+  }
+  fclose(f);
+  return ok;
+}
+
+// 8x8 area average, as the device's 1/8-scale JPEG decode
+static void frame_luma(const Frame& frame, LumaImage& luma) {
+  luma.width = frame.width / 8;
+  luma.height = frame.height / 8;
+  for (int y = 0; y < luma.height; y++) {
+    for (int x = 0; x < luma.width; x++) {
+      uint32_t sum = 0;
+      for (int dy = 0; dy < 8; dy++) {
+        for (int dx = 0; dx < 8; dx++) {
+          sum += frame.pixels[(size_t)(y * 8 + dy) * frame.width + x * 8 + dx];
+        }
+      }
+      luma.pixels[y * luma.width + x] = sum / 64;
+    }
+  }
+}
+
+// Distinct channels, so a swapped or shifted channel shows up in the output
+static void frame_rgb888(const Frame& frame, std::vector<uint8_t>& rgb) {
+  rgb.resize(frame.pixels.size() * 3);
+  for (size_t i = 0; i < frame.pixels.size(); i++) {
+    rgb[i * 3] = frame.pixels[i];
+    rgb[i * 3 + 1] = frame.pixels[i] / 2;
+    rgb[i * 3 + 2] = 255 - frame.pixels[i];
+  }
+}
+
+static LumaImage luma;
+
+static void detect_and_crop(const char* name, Frame& frame, FaceBox& face, CropRect& rect) {
+  TEST_ASSERT_TRUE_MESSAGE(load_pgm(name, frame), name);
+  TEST_ASSERT_EQUAL_UINT16(320, frame.width);
+  TEST_ASSERT_EQUAL_UINT16(240, frame.height);
+  frame_luma(frame, luma);
+  TEST_ASSERT_TRUE(image_find_face(luma, 0.35, face));
+  TEST_ASSERT_TRUE(image_face_crop_rect(face, luma.width, luma.height, frame.width, frame.height,
+                                        FACE_CROP_PADDING, rect));
+  TEST_ASSERT_EQUAL_UINT16(rect.width, rect.height);
+  TEST_ASSERT_LESS_OR_EQUAL(frame.width, rect.x + rect.width);
+  TEST_ASSERT_LESS_OR_EQUAL(frame.height, rect.y + rect.height);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Face square 128 px at (96, 56): padded crop keeps the whole face
+void test_crop_rect_centered_face() {
+  Frame frame;
+  FaceBox face;
+  CropRect rect;
+  detect_and_crop("qvga_center.pgm", frame, face, rect);
+
+  TEST_ASSERT_INT_WITHIN(1, 12, face.x);
+  TEST_ASSERT_INT_WITHIN(1, 7, face.y);
+  TEST_ASSERT_INT_WITHIN(1, 16, face.size);
+
+  TEST_ASSERT_EQUAL_UINT16(74, rect.x);
+  TEST_ASSERT_EQUAL_UINT16(34, rect.y);
+  TEST_ASSERT_EQUAL_UINT16(180, rect.width);
+  TEST_ASSERT_TRUE(rect.x <= 96 && rect.x + rect.width >= 96 + 128);
+  TEST_ASSERT_TRUE(rect.y <= 56 && rect.y + rect.height >= 56 + 128);
+}
+
+// Face square 112 px at (200, 64): the square slides left to stay in the frame
+void test_crop_rect_slides_inside_frame() {
+  Frame frame;
+  FaceBox face;
+  CropRect rect;
+  detect_and_crop("qvga_edge.pgm", frame, face, rect);
+
+  TEST_ASSERT_EQUAL_UINT16(156, rect.width);
+  TEST_ASSERT_EQUAL_UINT16(320, rect.x + rect.width);
+  TEST_ASSERT_EQUAL_UINT16(46, rect.y);
+}
+
+// Face square 224 px at (56, 8): the padded side is capped at the frame height
+void test_crop_rect_capped_at_frame() {
+  Frame frame;
+  FaceBox face;
+  CropRect rect;
+  detect_and_crop("qvga_close.pgm", frame, face, rect);
+
+  TEST_ASSERT_EQUAL_UINT16(240, rect.width);
+  TEST_ASSERT_EQUAL_UINT16(0, rect.y);
+  TEST_ASSERT_EQUAL_UINT16(52, rect.x);
+}
+
+void test_crop_scale_output() {
+  Frame frame;
+  FaceBox face;
+  CropRect rect;
+  detect_and_crop("qvga_center.pgm", frame, face, rect);
+
+  std::vector<uint8_t> rgb;
+  frame_rgb888(frame, rgb);
+  // Guard bytes past the crop catch writes beyond dst_width x dst_height
+  std::vector<uint8_t> out(FACE_CROP_SIZE * FACE_CROP_SIZE * 3 + 16, 0xA5);
+  TEST_ASSERT_TRUE(image_crop_scale_rgb888(rgb.data(), frame.width, frame.height, rect,
+                                           out.data(), FACE_CROP_SIZE, FACE_CROP_SIZE));
+  for (size_t i = FACE_CROP_SIZE * FACE_CROP_SIZE * 3; i < out.size(); i++) {
+    TEST_ASSERT_EQUAL(0xA5, out[i]);
+  }
+
+  // Center lands on the bright band under the eyes, the corner on background
+  const uint8_t* center = &out[((FACE_CROP_SIZE / 2) * FACE_CROP_SIZE + FACE_CROP_SIZE / 2) * 3];
+  const uint8_t* corner = &out[0];
+  TEST_ASSERT_GREATER_THAN(150, center[0]);
+  TEST_ASSERT_LESS_THAN(140, corner[0]);
+  for (int c = 0; c < 2; c++) {
+    const uint8_t* px = c == 0 ? center : corner;
+    TEST_ASSERT_INT_WITHIN(1, px[0] / 2, px[1]);
+    TEST_ASSERT_INT_WITHIN(1, 255 - px[0], px[2]);
+  }
+}
+
+void test_crop_scale_rejects_rect_outside_frame() {
+  std::vector<uint8_t> rgb(320 * 240 * 3, 0);
+  std::vector<uint8_t> out(FACE_CROP_SIZE * FACE_CROP_SIZE * 3, 0);
+  CropRect rect = {200, 100, 156, 156};
+  TEST_ASSERT_FALSE(image_crop_scale_rgb888(rgb.data(), 320, 240, rect, out.data(), FACE_CROP_SIZE, FACE_CROP_SIZE));
+  rect.width = 0;
+  TEST_ASSERT_FALSE(image_crop_scale_rgb888(rgb.data(), 320, 240, rect, out.data(), FACE_CROP_SIZE, FACE_CROP_SIZE));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crop_rect_centered_face);
+  RUN_TEST(test_crop_rect_slides_inside_frame);
+  RUN_TEST(test_crop_rect_capped_at_frame);
+  RUN_TEST(test_crop_scale_output);
+  RUN_TEST(test_crop_scale_rejects_rect_outside_frame);
+  return UNITY_END();
+}
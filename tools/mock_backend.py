@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""Local stand-in for the dining server, for testing the device API.
+
+Serves the four endpoints the firmware calls:
+
+  POST /api/auth/face-verify
+  POST /api/transactions/log
+  POST /api/transactions/sync-batch
+  GET  /api/student/<id>/balance
+
+Any card is a known student ("STU_<uid>", Rs. 500). Latency, failures and
+response size are configurable, so retry behaviour and tail latency can be
+measured without the production server:
+
+  python3 tools/mock_backend.py --port 5000 --latency-ms 40 --jitter-ms 20 \\
+      --slow-rate 0.02 --slow-ms 1500 --error-rate 0.01 --pad-bytes 512
+
+Counters are served at GET /mock/stats and reset with POST /mock/reset.
+Only the standard library is used.
+"""
+
+import argparse
+import json
+import random
+import re
+import signal
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+BALANCE_RE = re.compile(r"^/api/student/([^/]+)/balance$")
+ENDPOINTS = ("face-verify", "log", "sync-batch", "balance")
+
+
+class MockState:
+    def __init__(self, args):
+        self.args = args
+        self.lock = threading.Lock()
+        self.students = {}
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.students.clear()
+            self.stats = {
+                name: {"requests": 0, "errors": 0, "dropped": 0, "timeouts": 0,
+                       "bytes_in": 0, "bytes_out": 0}
+                for name in ENDPOINTS
+            }
+            self.stats["sync-batch"]["records"] = 0
+            self.devices = {}
+
+    def student(self, rfid_uid):
+        if rfid_uid not in self.students:
+            self.students[rfid_uid] = {
+                "student_id": "STU_" + rfid_uid,
+                "student_name": "Student " + rfid_uid,
+                "balance": self.args.balance,
+            }
+        return self.students[rfid_uid]
+
+    def student_by_id(self, student_id):
+        for s in self.students.values():
+            if s["student_id"] == student_id:
+                return s
+        return None
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "MockDining/1.0"
+
+    def log_message(self, fmt, *args):
+        if self.server.state.args.verbose:
+            super().log_message(fmt, *args)
+
+    @property
+    def state(self):
+        return self.server.state
+
+    def read_body(self):
+        length = int(self.headers.get("Content-Length", 0))
+        return self.rfile.read(length) if length > 0 else b""
+
+    def reply(self, code, payload, endpoint=None):
+        args = self.state.args
+        if args.pad_bytes > 0 and isinstance(payload, dict):
+            payload = dict(payload, padding="x" * args.pad_bytes)
+        body = json.dumps(payload).encode()
+        if endpoint is not None:
+            with self.state.lock:
+                self.state.stats[endpoint]["bytes_out"] += len(body)
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def inject(self, endpoint, body):
+        """Latency and failures. Returns False when no reply should follow."""
+        args = self.state.args
+        with self.state.lock:
+            stats = self.state.stats[endpoint]
+            stats["requests"] += 1
+            stats["bytes_in"] += len(body)
+
+        delay_ms = args.latency_ms + random.uniform(0, args.jitter_ms)
+        if random.random() < args.slow_rate:
+            delay_ms += args.slow_ms
+        roll = random.random()
+        if roll < args.timeout_rate:
+            with self.state.lock:
+                stats["timeouts"] += 1
+            time.sleep(args.timeout_ms / 1000.0)
+            self.close_connection = True
+            return False
+        time.sleep(delay_ms / 1000.0)
+
+        roll -= args.timeout_rate
+        if roll < args.drop_rate:
+            with self.state.lock:
+                stats["dropped"] += 1
+            self.close_connection = True
+            return False
+        roll -= args.drop_rate
+        if roll < args.error_rate:
+            with self.state.lock:
+                stats["errors"] += 1
+            self.reply(500, {"status": "error", "reason": "Injected failure"})
+            return False
+        return True
+
+    def do_GET(self):
+        match = BALANCE_RE.match(self.path)
+        if match:
+            if not self.inject("balance", b""):
+                return
+            with self.state.lock:
+                s = self.state.student_by_id(match.group(1))
+            if s is None:
+                self.reply(404, {"status": "error", "reason": "Unknown student"}, "balance")
+            else:
+                self.reply(200, {"status": "success", "student_id": s["student_id"],
+                                 "balance": s["balance"]}, "balance")
+        elif self.path == "/mock/stats":
+            with self.state.lock:
+                snapshot = {"endpoints": self.state.stats, "devices": self.state.devices}
+                body = json.dumps(snapshot).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        else:
+            self.reply(404, {"status": "error", "reason": "Not found"})
+
+    def do_POST(self):
+        body = self.read_body()
+        if self.path == "/mock/reset":
+            self.state.reset()
+            self.reply(200, {"status": "success"})
+            return
+
+        endpoint = {
+            "/api/auth/face-verify": "face-verify",
+            "/api/transactions/log": "log",
+            "/api/transactions/sync-batch": "sync-batch",
+        }.get(self.path)
+        if endpoint is None:
+            self.reply(404, {"status": "error", "reason": "Not found"})
+            return
+        if not self.inject(endpoint, body):
+            return
+        try:
+            req = json.loads(body or b"{}")
+        except ValueError:
+            self.reply(400, {"status": "error", "reason": "Bad JSON"}, endpoint)
+            return
+
+        if endpoint == "face-verify":
+            self.face_verify(req)
+        elif endpoint == "log":
+            self.log_transaction(req)
+        else:
+            self.sync_batch(req)
+
+    def face_verify(self, req):
+        args = self.state.args
+        if not req.get("face_image"):
+            self.reply(200, {"status": "error", "reason": "No face image"}, "face-verify")
+            return
+        with self.state.lock:
+            s = dict(self.state.student(req.get("rfid_uid", "")))
+        self.reply(200, {
+            "status": "success",
+            "student_id": s["student_id"],
+            "student_name": s["student_name"],
+            "confidence": args.confidence,
+            "eligible": s["balance"] >= args.meal_cost,
+            "balance": s["balance"],
+            "meal_plan": "active",
+            "already_served_today": False,
+            "approval_required": False,
+            "reason": "",
+        }, "face-verify")
+
+    def log_transaction(self, req):
+        with self.state.lock:
+            s = self.state.student_by_id(req.get("student_id", ""))
+            if s is not None and req.get("approval_status") != "denied":
+                s["balance"] = req.get("balance_after", s["balance"])
+        self.reply(200, {"status": "success"}, "log")
+
+    def sync_batch(self, req):
+        records = req.get("transactions", [])
+        device = req.get("device_id", "")
+        with self.state.lock:
+            self.state.stats["sync-batch"]["records"] += len(records)
+            self.state.devices[device] = self.state.devices.get(device, 0) + len(records)
+        acked = [r.get("id", "") for r in records]
+        self.reply(200, {"status": "success", "synced_count": len(acked), "acked": acked}, "sync-batch")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument("--latency-ms", type=float, default=0, help="added to every response")
+    parser.add_argument("--jitter-ms", type=float, default=0, help="uniform extra latency")
+    parser.add_argument("--slow-rate", type=float, default=0, help="fraction of requests delayed by --slow-ms")
+    parser.add_argument("--slow-ms", type=float, default=1000)
+    parser.add_argument("--error-rate", type=float, default=0, help="fraction answered 500")
+    parser.add_argument("--drop-rate", type=float, default=0, help="fraction closed without a reply")
+    parser.add_argument("--timeout-rate", type=float, default=0, help="fraction held for --timeout-ms, then closed")
+    parser.add_argument("--timeout-ms", type=float, default=6000, help="longer than the device's 5 s timeout")
+    parser.add_argument("--pad-bytes", type=int, default=0, help="extra bytes in every JSON response")
+    parser.add_argument("--confidence", type=float, default=0.92)
+    parser.add_argument("--balance", type=float, default=500.0)
+    parser.add_argument("--meal-cost", type=float, default=100.0)
+    parser.add_argument("--seed", type=int, default=None)
+    parser.add_argument("--verbose", action="store_true", help="log every request")
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    server.state = MockState(args)
+    print(f"Mock backend on http://{args.host}:{args.port}", flush=True)
+    # Print the final counters on kill as well as on Ctrl-C
+    signal.signal(signal.SIGTERM, signal.default_int_handler)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print(json.dumps({"endpoints": server.state.stats, "devices": server.state.devices}, indent=2))
+
+
+if __name__ == "__main__":
+    main()